@@ -32,6 +32,7 @@ struct inode {
 	int open_cnt;			/* Number of openers. */
 	bool removed;			/* True if deleted, false otherwise. */
 	int deny_write_cnt;		/* 0: writes ok, >0: deny writes. */
+	unsigned write_cnt;		/* Number of writes that changed data. */
 	struct inode_disk data; /* Inode content. */
 };
 
@@ -117,6 +118,7 @@ struct inode *inode_open(disk_sector_t sector) {
 	inode->sector = sector;
 	inode->open_cnt = 1;
 	inode->deny_write_cnt = 0;
+	inode->write_cnt = 0;
 	inode->removed = false;
 	disk_read(filesys_disk, inode->sector, &inode->data);
 	return inode;
@@ -190,8 +192,20 @@ off_t inode_read_at(struct inode *inode, void *buffer_, off_t size,
 			break;
 
 		if (sector_ofs == 0 && chunk_size == DISK_SECTOR_SIZE) {
-			/* Read full sector directly into caller's buffer. */
-			disk_read(filesys_disk, sector_idx, buffer + bytes_read);
+			/* Read full sectors directly into caller's buffer, as many
+			 * at once as are wanted and lie next to each other on
+			 * disk. */
+			size_t cnt = 1;
+
+			while (cnt < DISK_MAX_SECTORS &&
+				   (off_t)(cnt + 1) * DISK_SECTOR_SIZE <= size &&
+				   (off_t)(cnt + 1) * DISK_SECTOR_SIZE <= inode_left &&
+				   byte_to_sector(inode, offset + cnt * DISK_SECTOR_SIZE) ==
+					   sector_idx + cnt)
+				cnt++;
+			disk_read_multiple(filesys_disk, sector_idx, cnt,
+							   buffer + bytes_read);
+			chunk_size = cnt * DISK_SECTOR_SIZE;
 		} else {
 			/* Read sector into bounce buffer, then partially copy
 			 * into caller's buffer. */
@@ -244,8 +258,19 @@ off_t inode_write_at(struct inode *inode, const void *buffer_, off_t size,
 			break;
 
 		if (sector_ofs == 0 && chunk_size == DISK_SECTOR_SIZE) {
-			/* Write full sector directly to disk. */
-			disk_write(filesys_disk, sector_idx, buffer + bytes_written);
+			/* Write full sectors directly to disk, as many at once as
+			 * are given and lie next to each other on disk. */
+			size_t cnt = 1;
+
+			while (cnt < DISK_MAX_SECTORS &&
+				   (off_t)(cnt + 1) * DISK_SECTOR_SIZE <= size &&
+				   (off_t)(cnt + 1) * DISK_SECTOR_SIZE <= inode_left &&
+				   byte_to_sector(inode, offset + cnt * DISK_SECTOR_SIZE) ==
+					   sector_idx + cnt)
+				cnt++;
+			disk_write_multiple(filesys_disk, sector_idx, cnt,
+								buffer + bytes_written);
+			chunk_size = cnt * DISK_SECTOR_SIZE;
 		} else {
 			/* We need a bounce buffer. */
 			if (bounce == NULL) {
@@ -272,6 +297,8 @@ off_t inode_write_at(struct inode *inode, const void *buffer_, off_t size,
 	}
 	free(bounce);
 
+	if (bytes_written > 0)
+		inode->write_cnt++;
 	return bytes_written;
 }
 
@@ -293,3 +320,11 @@ void inode_allow_write(struct inode *inode) {
 
 /* Returns the length, in bytes, of INODE's data. */
 off_t inode_length(const struct inode *inode) { return inode->data.length; }
+
+/* Returns the number of writes that changed INODE's data since it was
+ * opened, so that a copy of something derived from it can tell whether
+ * it is still up to date as long as the inode stays open. */
+unsigned inode_write_cnt(const struct inode *inode) { return inode->write_cnt; }
+
+/* Returns true if INODE is to be deleted when it is closed. */
+bool inode_is_removed(const struct inode *inode) { return inode->removed; }
@@ -19,5 +19,7 @@ off_t inode_write_at(struct inode *, const void *, off_t size, off_t offset);
 void inode_deny_write(struct inode *);
 void inode_allow_write(struct inode *);
 off_t inode_length(const struct inode *);
+unsigned inode_write_cnt(const struct inode *);
+bool inode_is_removed(const struct inode *);
 
 #endif /* filesys/inode.h */
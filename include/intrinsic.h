@@ -12,6 +12,46 @@ __attribute__((always_inline)) static __inline void lcr3(uint64_t val) {
 					 : "r"(val));
 }
 
+__attribute__((always_inline)) static __inline uint64_t rcr4(void) {
+	uint64_t val;
+	__asm __volatile("movq %%cr4,%0"
+					 : "=r"(val));
+	return val;
+}
+
+__attribute__((always_inline)) static __inline void lcr4(uint64_t val) {
+	__asm __volatile("movq %0, %%cr4"
+					 :
+					 : "r"(val)
+					 : "memory");
+}
+
+/* Executes CPUID with LEAF and SUBLEAF and stores the resulting
+   registers into REGS[0..3] as eax, ebx, ecx, edx. */
+__attribute__((always_inline)) static __inline void
+cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4]) {
+	__asm __volatile("cpuid"
+					 : "=a"(regs[0]), "=b"(regs[1]), "=c"(regs[2]),
+					   "=d"(regs[3])
+					 : "a"(leaf), "c"(subleaf));
+}
+
+/* Invalidates TLB entries tagged with process-context identifier
+   PCID.  TYPE selects the scope: 0 for the single address ADDR,
+   1 for the whole PCID, 2 for every PCID including globals.  See
+   [IA32-v2a] "INVPCID". */
+__attribute__((always_inline)) static __inline void
+invpcid(uint64_t type, uint64_t pcid, uint64_t addr) {
+	struct {
+		uint64_t pcid;
+		uint64_t addr;
+	} desc = {pcid, addr};
+	__asm __volatile("invpcid %0, %1"
+					 :
+					 : "m"(desc), "r"(type)
+					 : "memory");
+}
+
 __attribute__((always_inline)) static __inline void
 lgdt(const struct desc_ptr *dtr) {
 	__asm __volatile("lgdt %0"
@@ -136,4 +176,11 @@ __attribute__((always_inline)) static __inline void write_msr(uint32_t ecx,
 	__asm __volatile("wrmsr" ::"c"(ecx), "d"(edx), "a"(eax));
 }
 
+__attribute__((always_inline)) static __inline uint64_t rdtsc(void) {
+	uint32_t edx, eax;
+	__asm __volatile("rdtsc"
+					 : "=d"(edx), "=a"(eax));
+	return ((uint64_t)edx << 32) | eax;
+}
+
 #endif /* intrinsic.h */
@@ -18,7 +18,20 @@
  * conversion from a struct hash_elem back to a structure object
  * that contains it.  This is the same technique used in the
  * linked list implementation.  Refer to lib/kernel/list.h for a
- * detailed explanation. */
+ * detailed explanation.
+ *
+ * When the table grows or shrinks, the elements are moved to the
+ * new bucket array a few buckets at a time by later insertions
+ * and deletions, so that no single operation pays for moving
+ * the whole table.
+ *
+ * A table set up with hash_init_open() instead keeps pointers to
+ * its elements in one array of slots, using open addressing with
+ * Robin Hood probing, which touches fewer cache lines per
+ * lookup.  Both kinds of table are used through the same hash_*
+ * functions.  If an open-addressing table is full and cannot grow
+ * for lack of memory, hash_insert() and hash_replace() return
+ * the new element itself instead of inserting it. */
 
 #include <stdbool.h>
 #include <stddef.h>
@@ -53,25 +66,38 @@ typedef bool hash_less_func(const struct hash_elem *a,
  * data AUX. */
 typedef void hash_action_func(struct hash_elem *e, void *aux);
 
+/* Slot of a table that uses open addressing. */
+struct hash_slot {
+	struct hash_elem *elem; /* Element, or a null pointer if empty. */
+	uint64_t hash;			/* Hash value of `elem'. */
+};
+
 /* Hash table. */
 struct hash {
-	size_t elem_cnt;	  /* Number of elements in table. */
-	size_t bucket_cnt;	/* Number of buckets, a power of 2. */
-	struct list *buckets; /* Array of `bucket_cnt' lists. */
-	hash_hash_func *hash; /* Hash function. */
-	hash_less_func *less; /* Comparison function. */
-	void *aux;			  /* Auxiliary data for `hash' and `less'. */
+	size_t elem_cnt;		  /* Number of elements in table. */
+	size_t bucket_cnt;		  /* Number of buckets or slots, a power of 2. */
+	struct list *buckets;	 /* Array of `bucket_cnt' lists. */
+	struct list *old_buckets; /* Buckets being moved, or null. */
+	size_t old_bucket_cnt;	/* Number of old buckets. */
+	size_t moved_cnt;		  /* Old buckets moved so far. */
+	struct hash_slot *slots;  /* Open addressing: `bucket_cnt' slots. */
+	hash_hash_func *hash;	 /* Hash function. */
+	hash_less_func *less;	 /* Comparison function. */
+	void *aux;				  /* Auxiliary data for `hash' and `less'. */
 };
 
 /* A hash table iterator. */
 struct hash_iterator {
 	struct hash *hash;		/* The hash table. */
 	struct list *bucket;	/* Current bucket. */
+	size_t slot;			/* Current slot, for open addressing. */
 	struct hash_elem *elem; /* Current hash element in current bucket. */
 };
 
 /* Basic life cycle. */
 bool hash_init(struct hash *, hash_hash_func *, hash_less_func *, void *aux);
+bool hash_init_open(struct hash *, hash_hash_func *, hash_less_func *,
+					void *aux);
 void hash_clear(struct hash *, hash_action_func *);
 void hash_destroy(struct hash *, hash_action_func *);
 
@@ -0,0 +1,24 @@
+#ifndef __LIB_KERNEL_LZ_H
+#define __LIB_KERNEL_LZ_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Byte-oriented LZ77 compression, in the format of LZF.
+
+   Meant for compressing pages on their way to swap: it works on
+   one buffer at a time, needs no allocation, and decompresses
+   with nothing but byte copies. */
+
+/* Number of entries in the work area that lz_compress() needs. */
+#define LZ_WORK_CNT 4096
+
+/* Longest input lz_compress() accepts. */
+#define LZ_MAX_INPUT 65535
+
+size_t lz_compress(const void *src, size_t src_len, void *dst, size_t dst_cap,
+				   uint16_t work[LZ_WORK_CNT]);
+size_t lz_decompress(const void *src, size_t src_len, void *dst,
+					 size_t dst_cap);
+
+#endif /* lib/kernel/lz.h */
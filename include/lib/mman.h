@@ -0,0 +1,45 @@
+#ifndef __LIB_MMAN_H
+#define __LIB_MMAN_H
+
+/* Flag for the WRITABLE argument of mmap(), to be OR'd with it:
+ * read the whole mapping in before returning, instead of a page
+ * at a time as it is touched. */
+#define MAP_POPULATE 0x100
+
+/* Advice for madvise(). */
+#define MADV_NORMAL 0	  /* No particular pattern. */
+#define MADV_SEQUENTIAL 1 /* Read in order, each page once. */
+#define MADV_WILLNEED 2	  /* Will be used soon: read it in now. */
+#define MADV_DONTNEED 3	  /* Not used for now: drop it.  Anonymous
+							 memory reads back as it started out,
+							 zeros or the executable's initialized
+							 data; mapped files keep what was
+							 written. */
+
+/* Flags for msync(). */
+#define MS_ASYNC 1 /* Leave the writing to the writeback daemon. */
+#define MS_SYNC 2  /* Write back before returning. */
+
+/* Memory use of a process, as filled in by memstat().  A resident page
+ * that shares its frame with another process, or is mapped to the page
+ * of zeros, counts as shared.  The last two members are for the whole
+ * system. */
+struct memstat {
+	long long rss_anon;		/* Resident anonymous pages of its own. */
+	long long rss_file;		/* Resident pages of mapped files. */
+	long long rss_shared;	/* Resident pages shared with others. */
+	long long wss;			/* Pages accessed during the last sampling
+							   interval, or -1 if sampling is off. */
+	long long wss_peak;		/* Largest WSS so far, or -1. */
+	long long major_faults; /* Faults that read from a file or swap. */
+	long long minor_faults; /* Faults resolved in memory. */
+	long long cow_faults;	/* Minor faults that wrote to a page shared
+							   copy-on-write. */
+	long long swap_ins;		/* Pages read back from swap. */
+	long long swap_outs;	/* Pages written out to swap. */
+	long long swap_pages;	/* Pages in swap now. */
+	long long pressure_events; /* Frames that had to be reclaimed. */
+	long long oom_kills;	/* Processes killed for lack of memory. */
+};
+
+#endif /* lib/mman.h */
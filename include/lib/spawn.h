@@ -0,0 +1,13 @@
+#ifndef __LIB_SPAWN_H
+#define __LIB_SPAWN_H
+
+/* A file descriptor for the child of spawn() to start with: its
+ * CHILD_FD is the parent's PARENT_FD, with a position of its own that
+ * starts where the parent's is.  Descriptors that no action names are
+ * closed in the child. */
+struct spawn_action {
+	int parent_fd;
+	int child_fd;
+};
+
+#endif /* lib/spawn.h */
@@ -36,6 +36,13 @@ enum {
 
 	SYS_MOUNT,
 	SYS_UMOUNT,
+
+	/* Extra for Project 3 */
+	SYS_MADVISE, /* Advise how memory will be used. */
+	SYS_MSYNC,	 /* Write a memory mapping back to its file. */
+	SYS_MEMSTAT, /* Report the memory use of the process. */
+	SYS_BRK,	 /* Move the end of the heap. */
+	SYS_SPAWN,	 /* Start a process running a new program. */
 };
 
 #endif /* lib/syscall-nr.h */
@@ -3,7 +3,10 @@
 
 #include <stdbool.h>
 #include <debug.h>
+#include <mman.h>
+#include <spawn.h>
 #include <stddef.h>
+#include <stdint.h>
 
 /* Process identifier. */
 typedef int pid_t;
@@ -37,10 +40,17 @@ unsigned tell(int fd);
 void close(int fd);
 
 int dup2(int oldfd, int newfd);
+pid_t spawn(const char *cmd_line, const struct spawn_action *actions,
+			size_t action_cnt);
 
 /* Project 3 and optionally project 4. */
 void *mmap(void *addr, size_t length, int writable, int fd, off_t offset);
 void munmap(void *addr);
+int madvise(void *addr, size_t length, int advice);
+int msync(void *addr, size_t length, int flags);
+int memstat(struct memstat *st);
+int brk(void *addr);
+void *sbrk(intptr_t increment);
 
 /* Project 4 only. */
 bool chdir(const char *dir);
@@ -79,4 +89,16 @@ static inline long long get_fs_disk_write_cnt(void) {
 	return write_cnt;
 }
 
+/* Returns counter COUNTER of kernel subsystem TAG, as numbered by
+   enum mem_counter and enum mem_tag in threads/memstat.h, or -1 if
+   either is out of range or the kernel keeps no counters. */
+static inline long long get_mem_usage(int tag, int counter) {
+	long long value;
+	asm volatile("int $0x45"
+				 : "=a"(value)
+				 : "d"((long long)tag), "c"((long long)counter)
+				 : "memory");
+	return value;
+}
+
 #endif /* lib/user/syscall.h */
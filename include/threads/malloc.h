@@ -3,11 +3,17 @@
 
 #include <debug.h>
 #include <stddef.h>
+#include "threads/memstat.h"
 
 void malloc_init(void);
-void *malloc(size_t) __attribute__((malloc));
-void *calloc(size_t, size_t) __attribute__((malloc));
-void *realloc(void *, size_t);
+void *malloc_tagged(size_t, enum mem_tag) __attribute__((malloc));
+void *calloc_tagged(size_t, size_t, enum mem_tag) __attribute__((malloc));
+void *realloc_tagged(void *, size_t, enum mem_tag);
 void free(void *);
 
+/* Allocations are charged to the subsystem of the caller. */
+#define malloc(SIZE) malloc_tagged((SIZE), MEM_TAG)
+#define calloc(A, B) calloc_tagged((A), (B), MEM_TAG)
+#define realloc(BLOCK, SIZE) realloc_tagged((BLOCK), (SIZE), MEM_TAG)
+
 #endif /* threads/malloc.h */
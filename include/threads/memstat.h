@@ -0,0 +1,55 @@
+#ifndef THREADS_MEMSTAT_H
+#define THREADS_MEMSTAT_H
+
+#include <stddef.h>
+
+/* Subsystems that kernel memory is accounted to.
+   Every object file gets its subsystem as MEM_TAG from the build
+   (see Makefile.build), so palloc_get_page() and malloc() charge
+   their caller without any change at the call site.  Code that
+   allocates on behalf of another subsystem can pass a tag
+   explicitly through the *_tagged() variants.
+
+   The counters are kept only when the kernel is compiled with
+   -DMEMSTAT (see the Make.vars of each project).  Otherwise the
+   calls below that update and print them expand to nothing, and
+   the tags cost nothing either. */
+enum mem_tag {
+	MEM_THREADS,  /* threads/, devices/ and kernel tests. */
+	MEM_FILESYS,  /* filesys/. */
+	MEM_USERPROG, /* userprog/. */
+	MEM_VM,		  /* vm/. */
+	MEM_LIB,	  /* lib/ and lib/kernel/. */
+	MEM_TAG_CNT
+};
+
+#ifndef MEM_TAG
+#define MEM_TAG MEM_THREADS
+#endif
+
+/* Counters kept for each tag, selected by the inspect interrupt. */
+enum mem_counter {
+	MEM_PAGES,		/* Pages currently allocated. */
+	MEM_PAGES_PEAK, /* High-water mark of MEM_PAGES. */
+	MEM_PAGES_FAIL, /* Failed page allocations. */
+	MEM_HEAP,		/* malloc() bytes currently allocated. */
+	MEM_HEAP_PEAK,  /* High-water mark of MEM_HEAP. */
+	MEM_HEAP_FAIL,  /* Failed malloc() calls. */
+	MEM_COUNTER_CNT
+};
+
+void memstat_init(void);
+
+#ifdef MEMSTAT
+void memstat_add(enum mem_tag, enum mem_counter, size_t);
+void memstat_sub(enum mem_tag, enum mem_counter, size_t);
+void memstat_fail(enum mem_tag, enum mem_counter);
+void memstat_print_stats(void);
+#else
+#define memstat_add(TAG, CNT, AMOUNT) ((void)0)
+#define memstat_sub(TAG, CNT, AMOUNT) ((void)0)
+#define memstat_fail(TAG, CNT) ((void)0)
+#define memstat_print_stats() ((void)0)
+#endif
+
+#endif /* threads/memstat.h */
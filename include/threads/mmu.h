@@ -7,6 +7,12 @@
 
 typedef bool pte_for_each_func(uint64_t *pte, void *va, void *aux);
 
+/* -nopcid: Never tag address spaces with PCIDs. */
+extern bool pcid_disabled;
+
+void pcid_init(void);
+void mmu_print_stats(void);
+
 uint64_t *pml4e_walk(uint64_t *pml4, const uint64_t va, int create);
 uint64_t *pml4_create(void);
 bool pml4_for_each(uint64_t *, pte_for_each_func *, void *);
@@ -14,11 +20,13 @@ void pml4_destroy(uint64_t *pml4);
 void pml4_activate(uint64_t *pml4);
 void *pml4_get_page(uint64_t *pml4, const void *upage);
 bool pml4_set_page(uint64_t *pml4, void *upage, void *kpage, bool rw);
+bool pml4_collapse(uint64_t *pml4, void *upage);
 void pml4_clear_page(uint64_t *pml4, void *upage);
 bool pml4_is_dirty(uint64_t *pml4, const void *upage);
 void pml4_set_dirty(uint64_t *pml4, const void *upage, bool dirty);
 bool pml4_is_accessed(uint64_t *pml4, const void *upage);
 void pml4_set_accessed(uint64_t *pml4, const void *upage, bool accessed);
+void pml4_set_user(uint64_t *pml4, const void *upage, bool user);
 
 #define is_writable(pte) (*(pte)&PTE_W)
 #define is_user_pte(pte) (*(pte)&PTE_U)
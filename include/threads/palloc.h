@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include "threads/memstat.h"
 
 /* How to allocate pages. */
 enum palloc_flags {
@@ -15,9 +16,19 @@ enum palloc_flags {
 extern size_t user_page_limit;
 
 uint64_t palloc_init(void);
-void *palloc_get_page(enum palloc_flags);
-void *palloc_get_multiple(enum palloc_flags, size_t page_cnt);
+void *palloc_get_multiple_tagged(enum palloc_flags, size_t page_cnt,
+								 enum mem_tag);
+void *palloc_get_aligned_tagged(enum palloc_flags, size_t page_cnt,
+								enum mem_tag);
 void palloc_free_page(void *);
 void palloc_free_multiple(void *, size_t page_cnt);
+void *palloc_user_pool(size_t *page_cnt);
+
+/* Allocations are charged to the subsystem of the caller. */
+#define palloc_get_page(FLAGS) palloc_get_multiple_tagged((FLAGS), 1, MEM_TAG)
+#define palloc_get_multiple(FLAGS, PAGE_CNT) \
+	palloc_get_multiple_tagged((FLAGS), (PAGE_CNT), MEM_TAG)
+#define palloc_get_aligned(FLAGS, PAGE_CNT) \
+	palloc_get_aligned_tagged((FLAGS), (PAGE_CNT), MEM_TAG)
 
 #endif /* threads/palloc.h */
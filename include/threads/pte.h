@@ -26,6 +26,8 @@
 #define PDPE(la) ((((uint64_t)(la)) >> PDPESHIFT) & 0x1FF)
 #define PDX(la) ((((uint64_t)(la)) >> PDXSHIFT) & 0x1FF)
 #define PTX(la) ((((uint64_t)(la)) >> PTXSHIFT) & 0x1FF)
+#define HUGE_PGSIZE (1UL << PDXSHIFT) /* Bytes mapped by one PDE. */
+#define HUGE_PGCNT (HUGE_PGSIZE / PGSIZE) /* Pages in a 2 MB page. */
 #define PTE_ADDR(pte) ((uint64_t)(pte) & ~0xFFF)
 
 /* The important flags are listed below.
@@ -41,5 +43,6 @@
 #define PTE_U 0x4							/* 1=user/kernel, 0=kernel only. */
 #define PTE_A 0x20							/* 1=accessed, 0=not acccessed. */
 #define PTE_D 0x40							/* 1=dirty, 0=not dirty (PTEs only). */
+#define PTE_PS 0x80							/* 1=2 MB page (PDEs only). */
 
 #endif /* threads/pte.h */
@@ -134,6 +134,10 @@ struct thread {
 #ifdef VM
 	/* Table for whole virtual memory owned by thread. */
 	struct supplemental_page_table spt;
+	uintptr_t user_rsp; /* User stack pointer at the last system call. */
+#ifdef FAULT_PROFILE
+	struct fault_sample fault_sample; /* Page fault being handled. */
+#endif
 #endif
 
 	/* Owned by thread.c. */
@@ -14,6 +14,7 @@ void fd_seek(int, unsigned, fd_list);
 unsigned fd_tell(int, fd_list);
 void fd_close(int, fd_list);
 int fd_dup2(int, int, fd_list);
+struct file *fd_get_file(int, fd_list);
 
 void fd_close_all(fd_list);
 bool fd_dup_fd_list(fd_list, fd_list);
@@ -5,6 +5,7 @@
 #include "threads/synch.h"
 #include <list.h>
 #include "userprog/fd.h"
+#include <spawn.h>
 #define PROCESS_MAGIC 0xcd6abf4b
 
 /* Similar with ptr_thread */
@@ -21,6 +22,8 @@ struct process {
 	struct semaphore parent_waited;
 	/* Sema up when this process set exist status */
 	struct semaphore exist_status_setted;
+	/* Semaphore process_wait() is blocked on, if any */
+	struct semaphore *wait_sema;
 	/* Lock for accessing data of this process by other process*/
 	struct lock data_access_lock;
 	struct file *loaded_file; /* Opened file by this process */
@@ -32,10 +35,17 @@ void process_init_in_thread_init(struct process *new);
 void process_init_of_initial_thread(void);
 tid_t process_fork(const char *name, struct intr_frame *if_);
 int process_exec(void *f_name);
+tid_t process_spawn(char *cmd_line, const struct spawn_action *actions,
+					size_t action_cnt);
 int process_wait(tid_t);
 void process_exit(void);
 void process_activate(struct thread *next);
 
 struct process *process_current(void);
+void process_wake(struct thread *t);
+
+extern bool exec_cache_disabled;
+void process_init_exec_cache(void);
+void process_print_stats(void);
 
 #endif /* userprog/process.h */
@@ -1,12 +1,22 @@
 #ifndef VM_ANON_H
 #define VM_ANON_H
+#include <stddef.h>
 #include "vm/vm.h"
 struct page;
 enum vm_type;
+struct zswap_entry;
 
-struct anon_page {};
+struct anon_page {
+	size_t slot; /* Swap slot holding the page, or SWAP_SLOT_NONE. */
+	struct zswap_entry *zentry; /* Compressed copy, or NULL. */
+	vm_initializer *init; /* What first filled it, or NULL for zeros. */
+	void *aux;			  /* Its argument. */
+};
 
 void vm_anon_init(void);
 bool anon_initializer(struct page *page, enum vm_type type, void *kva);
+size_t anon_swap_slot(struct page *page);
+bool anon_is_swapped_out(struct page *page);
+size_t anon_swap_out_batch(struct page **pages, size_t cnt);
 
 #endif
@@ -0,0 +1,76 @@
+#ifndef VM_FAULTPROF_H
+#define VM_FAULTPROF_H
+
+/* Page fault profiling.
+
+   Built only when the kernel is compiled with -DFAULT_PROFILE (see
+   vm/Make.vars).  Otherwise the macros below expand to nothing, or
+   to the statement they wrap, and leave no trace on the fault path.
+
+   page_fault() stamps each fault with the TSC on the way in and out,
+   and the fault path adds the cycles it spends in each phase as it
+   goes, including those spent on pages faulted around.  Faults that
+   are resolved land in power-of-two histograms per kind of fault,
+   which are printed at power off. */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Kinds of faults. */
+enum fault_type {
+	FAULT_ANON,	 /* First touch of anonymous memory. */
+	FAULT_FILE,	 /* Page of a mapped file or of the executable. */
+	FAULT_SWAP,	 /* Anonymous page read back from swap. */
+	FAULT_STACK, /* Stack growth. */
+	FAULT_COW,	 /* Write to a page shared copy-on-write. */
+	FAULT_TYPE_CNT
+};
+
+/* Phases of a fault. */
+enum fault_phase {
+	FAULT_LOOKUP,  /* Finding the page in the supplemental page table. */
+	FAULT_ALLOC,   /* Taking a free frame. */
+	FAULT_EVICT,   /* Evicting frames when there is none. */
+	FAULT_IO,	   /* Filling the frame: reading, copying or zeroing. */
+	FAULT_INSTALL, /* Setting the page table entry. */
+	FAULT_PHASE_CNT
+};
+
+/* A fault that a thread is handling. */
+struct fault_sample {
+	bool active;					 /* Being timed? */
+	enum fault_type type;			 /* Kind of fault. */
+	uint64_t start;					 /* TSC on entry. */
+	uint64_t cycles[FAULT_PHASE_CNT]; /* Cycles spent in each phase. */
+};
+
+#ifdef FAULT_PROFILE
+void faultprof_begin(void);
+void faultprof_end(bool handled);
+void faultprof_set_type(enum fault_type);
+uint64_t faultprof_now(void);
+void faultprof_add(enum fault_phase, uint64_t start);
+void faultprof_print_stats(void);
+
+#define FAULT_PROF_BEGIN() faultprof_begin()
+#define FAULT_PROF_END(HANDLED) faultprof_end(HANDLED)
+#define FAULT_PROF_TYPE(TYPE) faultprof_set_type(TYPE)
+#define FAULT_PROF_PRINT() faultprof_print_stats()
+
+/* Executes the statement given after PHASE and charges the cycles it
+   takes to PHASE of the current fault, if any. */
+#define FAULT_PROF_TIME(PHASE, ...)                  \
+	do {                                             \
+		uint64_t faultprof_start_ = faultprof_now(); \
+		__VA_ARGS__;                                 \
+		faultprof_add(PHASE, faultprof_start_);      \
+	} while (0)
+#else
+#define FAULT_PROF_BEGIN() ((void)0)
+#define FAULT_PROF_END(HANDLED) ((void)0)
+#define FAULT_PROF_TYPE(TYPE) ((void)0)
+#define FAULT_PROF_PRINT() ((void)0)
+#define FAULT_PROF_TIME(PHASE, ...) __VA_ARGS__
+#endif
+
+#endif /* vm/faultprof.h */
@@ -1,16 +1,44 @@
 #ifndef VM_FILE_H
 #define VM_FILE_H
 #include "filesys/file.h"
+#include "threads/synch.h"
 #include "vm/vm.h"
 
 struct page;
 enum vm_type;
+struct supplemental_page_table;
 
-struct file_page {};
+/* A region mapped with mmap(). */
+struct mmap_region {
+	struct list_elem elem;	   /* Element in the spt's mmaps list. */
+	struct list_elem all_elem; /* Element in the list of all regions. */
+	struct supplemental_page_table *spt; /* Table the pages are in. */
+	struct file *file;		   /* Handle of the mapping's own. */
+	void *start;			   /* First page. */
+	size_t page_cnt;		   /* Number of pages. */
+	off_t offset;			   /* File offset of the first page. */
+	off_t length;			   /* Bytes of the file mapped, the rest is zeros. */
+	struct readahead ra;	   /* Fault-around state. */
+	struct lock lock;		   /* Held while pages are written back or dropped. */
+};
+
+extern unsigned writeback_ms;
+
+struct file_page {
+	struct mmap_region *region; /* Region the page belongs to. */
+	off_t offset;				/* File offset of the page. */
+	size_t read_bytes;			/* Bytes from the file, the rest is zeros. */
+};
 
 void vm_file_init(void);
 bool file_backed_initializer(struct page *page, enum vm_type type, void *kva);
 void *do_mmap(void *addr, size_t length, int writable, struct file *file,
 			  off_t offset);
 void do_munmap(void *va);
+int do_msync(void *addr, size_t length, int flags);
+void file_print_stats(void);
+void file_munmap_all(struct supplemental_page_table *spt);
+bool file_page_drop(struct page *page);
+void file_set_sequential(struct supplemental_page_table *spt, void *start,
+						 void *end, bool sequential);
 #endif
@@ -0,0 +1,23 @@
+#ifndef VM_SWAP_H
+#define VM_SWAP_H
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct disk;
+
+/* A swap slot holds one page, in consecutive disk sectors. */
+#define SWAP_SLOT_NONE SIZE_MAX
+
+/* Most pages that are evicted and written out together. */
+#define SWAP_BATCH 8
+
+void swap_init(struct disk *);
+size_t swap_alloc(size_t cnt);
+size_t swap_dup(size_t slot);
+void swap_free(size_t slot);
+void swap_write(size_t slot, void *const kvas[], size_t cnt);
+void swap_read(size_t slot, void *kva);
+void swap_print_stats(void);
+
+#endif /* vm/swap.h */
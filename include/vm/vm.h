@@ -1,6 +1,9 @@
 #ifndef VM_VM_H
 #define VM_VM_H
+#include <hash.h>
+#include <list.h>
 #include <stdbool.h>
+#include "filesys/off_t.h"
 #include "threads/palloc.h"
 
 enum vm_type {
@@ -24,18 +27,35 @@ enum vm_type {
 	VM_MARKER_END = (1 << 31),
 };
 
+/* Readahead state of a stream of pages that come from a file, which is an
+ * mmap'd region or the executable's segments. */
+struct readahead {
+	void *next;		  /* Address the stream should fault on next. */
+	size_t window;	  /* Pages to fault around next time. */
+	size_t last_cnt;  /* Pages faulted around last time. */
+	bool sequential;  /* Advised to be read in order? */
+};
+
 #include "vm/uninit.h"
 #include "vm/anon.h"
 #include "vm/file.h"
+#include "vm/faultprof.h"
 #ifdef EFILESYS
 #include "filesys/page_cache.h"
 #endif
 
+struct inode;
+struct memstat;
 struct page_operations;
 struct thread;
 
 #define VM_TYPE(type) ((type)&7)
 
+/* Most the stack may grow to, unless -o stack=KB says otherwise, and the
+ * gap below that which the heap and mappings keep clear of. */
+#define STACK_MAX (1024 * 1024)
+#define STACK_GUARD (64 * 1024)
+
 /* The representation of "page".
  * This is kind of "parent class", which has four "child class"es, which are
  * uninit_page, file_page, anon_page, and page cache (project4).
@@ -46,6 +66,10 @@ struct page {
 	struct frame *frame; /* Back reference for frame */
 
 	/* Your implementation */
+	bool writable;				 /* May the user process write to this page? */
+	uint64_t *pml4;				 /* Page table it is mapped into. */
+	struct supplemental_page_table *spt; /* Table it belongs to. */
+	struct list_elem frame_elem; /* Element in frame's pages list. */
 
 	/* Per-type data are binded into the union.
 	 * Each function automatically detects the current union */
@@ -59,10 +83,37 @@ struct page {
 	};
 };
 
-/* The representation of "frame" */
+/* Read-only contents that every process running the same executable may
+ * share: READ_BYTES bytes at offset OFS of INODE, then zeros. */
+struct text_key {
+	struct inode *inode;
+	off_t ofs;
+	size_t read_bytes;
+};
+
+/* The representation of "frame".
+ * A frame is usually mapped by one page, but fork shares the frames of
+ * anonymous pages between parent and child until one of them writes, so it
+ * may have several.  They are all mapped read-only while there is more than
+ * one.  The zero page is a frame of this kind too, and so is a page of a
+ * read-only segment of an executable, which every process running it
+ * maps, and so is a frame that the same-page scanner merged identical
+ * anonymous pages into. */
 struct frame {
 	void *kva;
-	struct page *page;
+	struct list pages;			/* Pages that map this frame. */
+	size_t refcnt;				/* Number of pages in PAGES. */
+	bool pinned;				/* Not to be evicted. */
+	bool evicting;				/* Being written out by eviction? */
+	bool young;					/* Accessed bit taken by the sampler. */
+	struct text_key text;		/* Contents, if in the text cache. */
+	struct hash_elem text_elem; /* Element in the text cache. */
+	bool merged;				/* Pages merged into it by the scanner? */
+	bool ksm_listed;			/* In the scanner's table? */
+	uint64_t ksm_sum;			/* Checksum at the last scan. */
+	struct hash_elem ksm_elem;	/* Element in the scanner's table. */
+	struct list *queue;			/* 2Q queue it is on, if any. */
+	struct list_elem queue_elem; /* Element in that queue. */
 };
 
 /* The function table for page operations.
@@ -82,10 +133,42 @@ struct page_operations {
 	if ((page)->operations->destroy) \
 	(page)->operations->destroy(page)
 
+/* Paging events of one address space, and its working set as last
+ * sampled. */
+struct spt_stats {
+	long long major_cnt;	/* # of faults that read from disk or swap. */
+	long long minor_cnt;	/* # of faults resolved in memory. */
+	long long cow_cnt;		/* # of writes to pages shared copy-on-write. */
+	long long swap_in_cnt;	/* # of pages swapped in. */
+	long long swap_out_cnt; /* # of pages swapped out. */
+	size_t swap_cnt;		/* # of pages in swap now. */
+	unsigned ws_pass;		/* Sampling pass that WS_CNT was counted in. */
+	size_t ws_cnt;			/* Pages accessed in that pass. */
+	size_t ws_peak;			/* Largest WS_CNT so far. */
+};
+
 /* Representation of current process's memory space.
- * We don't want to force you to obey any specific design for this struct.
- * All designs up to you for this. */
-struct supplemental_page_table {};
+ * A radix tree indexed the same way as the x86-64 page table; see
+ * vm/spt.c. */
+struct supplemental_page_table {
+	struct thread *owner; /* Thread whose address space this is. */
+	void *root;			  /* Top level node, or null if empty. */
+	size_t page_cnt;	  /* Number of pages in the table. */
+	size_t node_cnt;	  /* Number of tree nodes allocated. */
+	struct list mmaps;	  /* Regions mapped with mmap(). */
+	struct readahead exec_ra; /* Readahead of the executable. */
+	void *heap_start;		  /* End of the executable's segments. */
+	void *brk;				  /* End of the heap, set by brk(). */
+	void *stack_bottom;		  /* Lowest page of the stack. */
+	size_t stack_ahead;		  /* Pages to grow it by ahead of use. */
+	struct spt_stats stats;	  /* Paging events and working set. */
+	bool oom_killed;		  /* Chosen by the out-of-memory killer? */
+	size_t oom_badness;		  /* Its score, while it is choosing. */
+};
+
+/* Performs some operation on PAGE, given auxiliary data AUX.
+ * Returns false to stop an spt_for_each() walk. */
+typedef bool spt_action_func(struct page *page, void *aux);
 
 #include "threads/thread.h"
 void supplemental_page_table_init(struct supplemental_page_table *spt);
@@ -95,8 +178,21 @@ void supplemental_page_table_kill(struct supplemental_page_table *spt);
 struct page *spt_find_page(struct supplemental_page_table *spt, void *va);
 bool spt_insert_page(struct supplemental_page_table *spt, struct page *page);
 void spt_remove_page(struct supplemental_page_table *spt, struct page *page);
+bool spt_insert_pages(struct supplemental_page_table *spt, struct page **pages,
+					  size_t cnt);
+bool spt_for_each(struct supplemental_page_table *spt, void *start, void *end,
+				  spt_action_func *action, void *aux);
+void spt_destroy(struct supplemental_page_table *spt,
+				 void (*destructor)(struct page *));
 
 void vm_init(void);
+void vm_print_stats(void);
+void vm_set_option(const char *option);
+int vm_madvise(void *addr, size_t length, int advice);
+void vm_memstat(struct memstat *st);
+void *vm_brk(void *addr);
+void *vm_stack_limit(void);
+void vm_print_memstat(void);
 bool vm_try_handle_fault(struct intr_frame *f, void *addr, bool user,
 						 bool write, bool not_present);
 
@@ -105,6 +201,14 @@ bool vm_try_handle_fault(struct intr_frame *f, void *addr, bool user,
 bool vm_alloc_page_with_initializer(enum vm_type type, void *upage,
 									bool writable, vm_initializer *init,
 									void *aux);
+struct page *vm_new_page(enum vm_type type, void *upage, bool writable,
+						 vm_initializer *init, void *aux);
+void vm_free_frame(struct page *page);
+struct frame *vm_pin_resident(struct page *page);
+struct frame *vm_pin_dirty(struct page *page);
+void vm_unpin_page(struct page *page);
+bool vm_text_map(struct page *page, const struct text_key *key);
+void vm_text_insert(struct page *page, const struct text_key *key);
 void vm_dealloc_page(struct page *page);
 bool vm_claim_page(void *va);
 enum vm_type page_get_type(struct page *page);
@@ -0,0 +1,19 @@
+#ifndef VM_ZSWAP_H
+#define VM_ZSWAP_H
+#include <stdbool.h>
+#include <stddef.h>
+
+struct page;
+
+/* Most of user memory, in percent, that compressed pages may take up.
+ * Zero disables the compressed cache.  Set by the -o zswap=N% option. */
+extern unsigned zswap_percent;
+
+void zswap_init(void);
+bool zswap_store(struct page *page, const void *kva);
+bool zswap_load(struct page *page, void *kva);
+bool zswap_contains(struct page *page);
+void zswap_invalidate(struct page *page);
+void zswap_print_stats(void);
+
+#endif /* vm/zswap.h */
@@ -135,6 +135,7 @@ long long __divdi3(long long n, long long d);
 long long __moddi3(long long n, long long d);
 unsigned long long __udivdi3(unsigned long long n, unsigned long long d);
 unsigned long long __umoddi3(unsigned long long n, unsigned long long d);
+int __popcountdi2(unsigned long long x);
 
 /* Signed 64-bit division. */
 long long __divdi3(long long n, long long d) { return sdiv64(n, d); }
@@ -151,3 +152,13 @@ unsigned long long __udivdi3(unsigned long long n, unsigned long long d) {
 unsigned long long __umoddi3(unsigned long long n, unsigned long long d) {
 	return umod64(n, d);
 }
+
+/* Number of 1-bits in X, for __builtin_popcountll() on machines
+   without the POPCNT instruction.  Adds up the bits in pairs,
+   then nibbles, then sums the bytes with a multiply. */
+int __popcountdi2(unsigned long long x) {
+	x = x - ((x >> 1) & 0x5555555555555555ULL);
+	x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+	x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+	return (x * 0x0101010101010101ULL) >> 56;
+}
@@ -26,6 +26,7 @@ typedef unsigned long elem_type;
    simulates an array of bits. */
 struct bitmap {
 	size_t bit_cnt;  /* Number of bits. */
+	size_t hint;	 /* Where bitmap_scan_from_hint() starts. */
 	elem_type *bits; /* Elements that represent bits. */
 };
 
@@ -56,6 +57,45 @@ static inline elem_type last_mask(const struct bitmap *b) {
 	return last_bits ? ((elem_type)1 << last_bits) - 1 : (elem_type)-1;
 }
 
+/* Returns a bit mask in which the bits numbered START through
+   END - 1 within an element are set to 1 and the rest are set
+   to 0.  Requires START < END <= ELEM_BITS. */
+static inline elem_type range_mask(size_t start, size_t end) {
+	elem_type high = end < ELEM_BITS ? ((elem_type)1 << end) - 1 : (elem_type)-1;
+	return high & ~(((elem_type)1 << start) - 1);
+}
+
+/* Returns element IDX of B with the bits that are set to VALUE
+   turned on and the others turned off. */
+static inline elem_type elem_value(const struct bitmap *b, size_t idx,
+								   bool value) {
+	return value ? b->bits[idx] : ~b->bits[idx];
+}
+
+/* Returns the index of the first bit in B at or after START that
+   is set to VALUE, or B's size if there is none. */
+static size_t find_next(const struct bitmap *b, size_t start, bool value) {
+	size_t idx, last_idx;
+	elem_type e;
+
+	if (start >= b->bit_cnt)
+		return b->bit_cnt;
+
+	idx = elem_idx(start);
+	last_idx = elem_cnt(b->bit_cnt) - 1;
+	e = elem_value(b, idx, value) & ~(bit_mask(start) - 1);
+	while (e == 0) {
+		if (idx == last_idx)
+			return b->bit_cnt;
+		e = elem_value(b, ++idx, value);
+	}
+
+	/* The unused bits of the last element read as 1 when looking
+	   for false bits; they are clamped away here. */
+	start = idx * ELEM_BITS + __builtin_ctzll(e);
+	return start < b->bit_cnt ? start : b->bit_cnt;
+}
+
 /* Creation and destruction. */
 
 /* Initializes B to be a bitmap of BIT_CNT bits
@@ -66,6 +106,7 @@ struct bitmap *bitmap_create(size_t bit_cnt) {
 	struct bitmap *b = malloc(sizeof *b);
 	if (b != NULL) {
 		b->bit_cnt = bit_cnt;
+		b->hint = 0;
 		b->bits = malloc(byte_cnt(bit_cnt));
 		if (b->bits != NULL || bit_cnt == 0) {
 			bitmap_set_all(b, false);
@@ -86,6 +127,7 @@ struct bitmap *bitmap_create_in_buf(size_t bit_cnt, void *block,
 	ASSERT(block_size >= bitmap_buf_size(bit_cnt));
 
 	b->bit_cnt = bit_cnt;
+	b->hint = 0;
 	b->bits = (elem_type *)(b + 1);
 	bitmap_set_all(b, false);
 	return b;
@@ -184,33 +226,60 @@ void bitmap_set_all(struct bitmap *b, bool value) {
 	bitmap_set_multiple(b, 0, bitmap_size(b), value);
 }
 
-/* Sets the CNT bits starting at START in B to VALUE. */
+/* The functions below work on whole elements.  Each one walks
+   the elements that overlap the CNT bits starting at START and
+   applies range_mask() to the partial elements at either end. */
+
+/* Sets the CNT bits starting at START in B to VALUE.
+   Each element is updated atomically, as in bitmap_mark(). */
 void bitmap_set_multiple(struct bitmap *b, size_t start, size_t cnt,
 						 bool value) {
-	size_t i;
+	size_t end = start + cnt;
+	size_t i, next;
 
 	ASSERT(b != NULL);
 	ASSERT(start <= b->bit_cnt);
 	ASSERT(start + cnt <= b->bit_cnt);
 
-	for (i = 0; i < cnt; i++)
-		bitmap_set(b, start + i, value);
+	for (i = start; i < end; i = next) {
+		size_t idx = elem_idx(i);
+		elem_type mask;
+
+		next = (idx + 1) * ELEM_BITS < end ? (idx + 1) * ELEM_BITS : end;
+		mask = range_mask(i % ELEM_BITS, next - idx * ELEM_BITS);
+		if (value)
+			asm("lock orq %1, %0"
+				: "=m"(b->bits[idx])
+				: "r"(mask)
+				: "cc");
+		else
+			asm("lock andq %1, %0"
+				: "=m"(b->bits[idx])
+				: "r"(~mask)
+				: "cc");
+	}
 }
 
 /* Returns the number of bits in B between START and START + CNT,
    exclusive, that are set to VALUE. */
 size_t bitmap_count(const struct bitmap *b, size_t start, size_t cnt,
 					bool value) {
-	size_t i, value_cnt;
+	size_t end = start + cnt;
+	size_t i, next, value_cnt;
 
 	ASSERT(b != NULL);
 	ASSERT(start <= b->bit_cnt);
 	ASSERT(start + cnt <= b->bit_cnt);
 
 	value_cnt = 0;
-	for (i = 0; i < cnt; i++)
-		if (bitmap_test(b, start + i) == value)
-			value_cnt++;
+	for (i = start; i < end; i = next) {
+		size_t idx = elem_idx(i);
+
+		next = (idx + 1) * ELEM_BITS < end ? (idx + 1) * ELEM_BITS : end;
+		value_cnt +=
+			__builtin_popcountll(elem_value(b, idx, value) &
+								 range_mask(i % ELEM_BITS, next - idx * ELEM_BITS));
+	}
 	return value_cnt;
 }
 
@@ -218,15 +287,21 @@ size_t bitmap_count(const struct bitmap *b, size_t start, size_t cnt,
    exclusive, are set to VALUE, and false otherwise. */
 bool bitmap_contains(const struct bitmap *b, size_t start, size_t cnt,
 					 bool value) {
-	size_t i;
+	size_t end = start + cnt;
+	size_t i, next;
 
 	ASSERT(b != NULL);
 	ASSERT(start <= b->bit_cnt);
 	ASSERT(start + cnt <= b->bit_cnt);
 
-	for (i = 0; i < cnt; i++)
-		if (bitmap_test(b, start + i) == value)
+	for (i = start; i < end; i = next) {
+		size_t idx = elem_idx(i);
+
+		next = (idx + 1) * ELEM_BITS < end ? (idx + 1) * ELEM_BITS : end;
+		if (elem_value(b, idx, value) &
+			range_mask(i % ELEM_BITS, next - idx * ELEM_BITS))
 			return true;
+	}
 	return false;
 }
 
@@ -259,12 +334,25 @@ size_t bitmap_scan(const struct bitmap *b, size_t start, size_t cnt,
 	ASSERT(b != NULL);
 	ASSERT(start <= b->bit_cnt);
 
+	if (cnt == 0)
+		return start;
 	if (cnt <= b->bit_cnt) {
 		size_t last = b->bit_cnt - cnt;
-		size_t i;
-		for (i = start; i <= last; i++)
-			if (!bitmap_contains(b, i, cnt, !value))
+		size_t i = start;
+
+		/* Jump from the start of one run of VALUE bits to the
+		   next, skipping whole elements on the way. */
+		for (;;) {
+			size_t run_end;
+
+			i = find_next(b, i, value);
+			if (i > last)
+				break;
+			run_end = find_next(b, i, !value);
+			if (run_end - i >= cnt)
 				return i;
+			i = run_end;
+		}
 	}
 	return BITMAP_ERROR;
 }
@@ -284,6 +372,25 @@ size_t bitmap_scan_and_flip(struct bitmap *b, size_t start, size_t cnt,
 	return idx;
 }
 
+/* Like bitmap_scan(), but starts where the group found by the
+   previous call ended and wraps around to the start of B if
+   there is no group after it.  Allocators that flip the group
+   right away thus skip the bits they have already handed out.
+   Like bitmap_scan(), returns BITMAP_ERROR if there is no such
+   group. */
+size_t bitmap_scan_from_hint(struct bitmap *b, size_t cnt, bool value) {
+	size_t idx;
+
+	ASSERT(b != NULL);
+
+	idx = bitmap_scan(b, b->hint, cnt, value);
+	if (idx == BITMAP_ERROR && b->hint != 0)
+		idx = bitmap_scan(b, 0, cnt, value);
+	if (idx != BITMAP_ERROR)
+		b->hint = idx + cnt;
+	return idx;
+}
+
 /* File input and output. */
 
 #ifdef FILESYS
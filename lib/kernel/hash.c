@@ -18,6 +18,16 @@ static struct hash_elem *find_elem(struct hash *, struct list *,
 static void insert_elem(struct hash *, struct list *, struct hash_elem *);
 static void remove_elem(struct hash *, struct hash_elem *);
 static void rehash(struct hash *);
+static void move_buckets(struct hash *, size_t cnt);
+static struct list *next_bucket(struct hash *, struct list *);
+
+static size_t find_slot(struct hash *, struct hash_elem *, uint64_t hash);
+static bool place_slot(struct hash *, struct hash_elem *, uint64_t hash);
+static void remove_slot(struct hash *, size_t idx);
+static bool resize_slots(struct hash *, size_t slot_cnt);
+
+/* Returns true if H uses open addressing. */
+static inline bool is_open(const struct hash *h) { return h->slots != NULL; }
 
 /* Initializes hash table H to compute hash values using HASH and
    compare hash elements using LESS, given auxiliary data AUX. */
@@ -26,6 +36,10 @@ bool hash_init(struct hash *h, hash_hash_func *hash, hash_less_func *less,
 	h->elem_cnt = 0;
 	h->bucket_cnt = 4;
 	h->buckets = malloc(sizeof *h->buckets * h->bucket_cnt);
+	h->old_buckets = NULL;
+	h->old_bucket_cnt = 0;
+	h->moved_cnt = 0;
+	h->slots = NULL;
 	h->hash = hash;
 	h->less = less;
 	h->aux = aux;
@@ -37,6 +51,31 @@ bool hash_init(struct hash *h, hash_hash_func *hash, hash_less_func *less,
 		return false;
 }
 
+/* Minimum number of slots in a table with open addressing. */
+#define MIN_SLOTS 8
+
+/* Like hash_init(), but H keeps its elements in an array of
+   slots with open addressing instead of in bucket lists. */
+bool hash_init_open(struct hash *h, hash_hash_func *hash,
+					hash_less_func *less, void *aux) {
+	h->elem_cnt = 0;
+	h->bucket_cnt = MIN_SLOTS;
+	h->buckets = NULL;
+	h->old_buckets = NULL;
+	h->old_bucket_cnt = 0;
+	h->moved_cnt = 0;
+	h->slots = malloc(sizeof *h->slots * h->bucket_cnt);
+	h->hash = hash;
+	h->less = less;
+	h->aux = aux;
+
+	if (h->slots != NULL) {
+		hash_clear(h, NULL);
+		return true;
+	} else
+		return false;
+}
+
 /* Removes all the elements from H.
 
    If DESTRUCTOR is non-null, then it is called for each element
@@ -49,6 +88,21 @@ bool hash_init(struct hash *h, hash_hash_func *hash, hash_less_func *less,
 void hash_clear(struct hash *h, hash_action_func *destructor) {
 	size_t i;
 
+	if (is_open(h)) {
+		for (i = 0; i < h->bucket_cnt; i++) {
+			struct hash_elem *e = h->slots[i].elem;
+			h->slots[i].elem = NULL;
+			if (e != NULL && destructor != NULL)
+				destructor(e, h->aux);
+		}
+		h->elem_cnt = 0;
+		return;
+	}
+
+	/* Finish moving the old buckets, if any, so that only one
+	   array remains to be cleared. */
+	move_buckets(h, h->old_bucket_cnt);
+
 	for (i = 0; i < h->bucket_cnt; i++) {
 		struct list *bucket = &h->buckets[i];
 
@@ -79,13 +133,26 @@ void hash_destroy(struct hash *h, hash_action_func *destructor) {
 	if (destructor != NULL)
 		hash_clear(h, destructor);
 	free(h->buckets);
+	free(h->old_buckets);
+	free(h->slots);
 }
 
 /* Inserts NEW into hash table H and returns a null pointer, if
    no equal element is already in the table.
    If an equal element is already in the table, returns it
-   without inserting NEW. */
+   without inserting NEW.  A table with open addressing that is
+   full and cannot grow for lack of memory returns NEW itself,
+   without inserting it. */
 struct hash_elem *hash_insert(struct hash *h, struct hash_elem *new) {
+	if (is_open(h)) {
+		uint64_t hash = h->hash(new, h->aux);
+		size_t idx = find_slot(h, new, hash);
+
+		if (idx != SIZE_MAX)
+			return h->slots[idx].elem;
+		return place_slot(h, new, hash) ? NULL : new;
+	}
+
 	struct list *bucket = find_bucket(h, new);
 	struct hash_elem *old = find_elem(h, bucket, new);
 
@@ -98,8 +165,22 @@ struct hash_elem *hash_insert(struct hash *h, struct hash_elem *new) {
 }
 
 /* Inserts NEW into hash table H, replacing any equal element
-   already in the table, which is returned. */
+   already in the table, which is returned.  Like hash_insert(),
+   returns NEW itself if there is no equal element and NEW cannot
+   be inserted for lack of memory. */
 struct hash_elem *hash_replace(struct hash *h, struct hash_elem *new) {
+	if (is_open(h)) {
+		uint64_t hash = h->hash(new, h->aux);
+		size_t idx = find_slot(h, new, hash);
+		struct hash_elem *old;
+
+		if (idx == SIZE_MAX)
+			return place_slot(h, new, hash) ? NULL : new;
+		old = h->slots[idx].elem;
+		h->slots[idx].elem = new;
+		return old;
+	}
+
 	struct list *bucket = find_bucket(h, new);
 	struct hash_elem *old = find_elem(h, bucket, new);
 
@@ -115,6 +196,10 @@ struct hash_elem *hash_replace(struct hash *h, struct hash_elem *new) {
 /* Finds and returns an element equal to E in hash table H, or a
    null pointer if no equal element exists in the table. */
 struct hash_elem *hash_find(struct hash *h, struct hash_elem *e) {
+	if (is_open(h)) {
+		size_t idx = find_slot(h, e, h->hash(e, h->aux));
+		return idx != SIZE_MAX ? h->slots[idx].elem : NULL;
+	}
 	return find_elem(h, find_bucket(h, e), e);
 }
 
@@ -126,6 +211,17 @@ struct hash_elem *hash_find(struct hash *h, struct hash_elem *e) {
    or own resources that are, then it is the caller's
    responsibility to deallocate them. */
 struct hash_elem *hash_delete(struct hash *h, struct hash_elem *e) {
+	if (is_open(h)) {
+		size_t idx = find_slot(h, e, h->hash(e, h->aux));
+		struct hash_elem *found;
+
+		if (idx == SIZE_MAX)
+			return NULL;
+		found = h->slots[idx].elem;
+		remove_slot(h, idx);
+		return found;
+	}
+
 	struct hash_elem *found = find_elem(h, find_bucket(h, e), e);
 	if (found != NULL) {
 		remove_elem(h, found);
@@ -141,12 +237,19 @@ struct hash_elem *hash_delete(struct hash *h, struct hash_elem *e) {
    hash_insert(), hash_replace(), or hash_delete(), yields
    undefined behavior, whether done from ACTION or elsewhere. */
 void hash_apply(struct hash *h, hash_action_func *action) {
+	struct list *bucket;
 	size_t i;
 
 	ASSERT(action != NULL);
 
-	for (i = 0; i < h->bucket_cnt; i++) {
-		struct list *bucket = &h->buckets[i];
+	if (is_open(h)) {
+		for (i = 0; i < h->bucket_cnt; i++)
+			if (h->slots[i].elem != NULL)
+				action(h->slots[i].elem, h->aux);
+		return;
+	}
+
+	for (bucket = h->buckets; bucket != NULL; bucket = next_bucket(h, bucket)) {
 		struct list_elem *elem, *next;
 
 		for (elem = list_begin(bucket); elem != list_end(bucket); elem = next) {
@@ -178,6 +281,12 @@ void hash_first(struct hash_iterator *i, struct hash *h) {
 	ASSERT(h != NULL);
 
 	i->hash = h;
+	if (is_open(h)) {
+		i->bucket = NULL;
+		i->slot = SIZE_MAX;
+		i->elem = NULL;
+		return;
+	}
 	i->bucket = i->hash->buckets;
 	i->elem = list_elem_to_hash_elem(list_head(i->bucket));
 }
@@ -193,9 +302,18 @@ void hash_first(struct hash_iterator *i, struct hash *h) {
 struct hash_elem *hash_next(struct hash_iterator *i) {
 	ASSERT(i != NULL);
 
+	if (is_open(i->hash)) {
+		/* SIZE_MAX + 1 wraps around to the first slot. */
+		for (i->slot++; i->slot < i->hash->bucket_cnt; i->slot++)
+			if (i->hash->slots[i->slot].elem != NULL)
+				return i->elem = i->hash->slots[i->slot].elem;
+		return i->elem = NULL;
+	}
+
 	i->elem = list_elem_to_hash_elem(list_next(&i->elem->list_elem));
 	while (i->elem == list_elem_to_hash_elem(list_end(i->bucket))) {
-		if (++i->bucket >= i->hash->buckets + i->hash->bucket_cnt) {
+		i->bucket = next_bucket(i->hash, i->bucket);
+		if (i->bucket == NULL) {
 			i->elem = NULL;
 			break;
 		}
@@ -254,10 +372,45 @@ uint64_t hash_string(const char *s_) {
 /* Returns a hash of integer I. */
 uint64_t hash_int(int i) { return hash_bytes(&i, sizeof i); }
 
-/* Returns the bucket in H that E belongs in. */
+/* Returns the bucket in H that E belongs in.
+   While H is being resized, an element stays in its old bucket
+   until move_buckets() gets to that bucket. */
 static struct list *find_bucket(struct hash *h, struct hash_elem *e) {
-	size_t bucket_idx = h->hash(e, h->aux) & (h->bucket_cnt - 1);
-	return &h->buckets[bucket_idx];
+	uint64_t hash = h->hash(e, h->aux);
+
+	if (h->old_buckets != NULL) {
+		size_t old_idx = hash & (h->old_bucket_cnt - 1);
+		if (old_idx >= h->moved_cnt)
+			return &h->old_buckets[old_idx];
+	}
+	return &h->buckets[hash & (h->bucket_cnt - 1)];
+}
+
+/* Returns true if BUCKET, one of H's current buckets, is
+   initialized.  While H is being resized, a new bucket is
+   initialized only when move_buckets() gets to the old bucket
+   that its elements come from; until then it holds nothing. */
+static bool bucket_ready(struct hash *h, struct list *bucket) {
+	size_t idx = bucket - h->buckets;
+
+	return h->old_buckets == NULL ||
+		   (idx & (h->old_bucket_cnt - 1)) < h->moved_cnt;
+}
+
+/* Returns the bucket in H that follows BUCKET, going through the
+   current buckets that are initialized and then through the old
+   buckets not yet moved, or a null pointer after the last one. */
+static struct list *next_bucket(struct hash *h, struct list *bucket) {
+	if (bucket >= h->buckets && bucket < h->buckets + h->bucket_cnt) {
+		while (++bucket < h->buckets + h->bucket_cnt)
+			if (bucket_ready(h, bucket))
+				return bucket;
+		if (h->old_buckets == NULL)
+			return NULL;
+		bucket = h->old_buckets + h->moved_cnt;
+	} else
+		bucket++;
+	return bucket < h->old_buckets + h->old_bucket_cnt ? bucket : NULL;
 }
 
 /* Searches BUCKET in H for a hash element equal to E.  Returns
@@ -282,6 +435,12 @@ static inline size_t is_power_of_2(size_t x) {
 	return x != 0 && turn_off_least_1bit(x) == 0;
 }
 
+/* Number of old buckets moved by each insertion or deletion while
+   the table is being resized.  Growth starts at 4 elements per
+   bucket and the next one at 8, so the move always finishes long
+   before another one is needed. */
+#define BUCKETS_PER_STEP 4
+
 /* Element per bucket ratios. */
 #define MIN_ELEMS_PER_BUCKET 1  /* Elems/bucket < 1: reduce # of buckets. */
 #define BEST_ELEMS_PER_BUCKET 2 /* Ideal elems/bucket. */
@@ -290,16 +449,26 @@ static inline size_t is_power_of_2(size_t x) {
 /* Changes the number of buckets in hash table H to match the
    ideal.  This function can fail because of an out-of-memory
    condition, but that'll just make hash accesses less efficient;
-   we can still continue. */
+   we can still continue.
+
+   Neither the elements are moved nor the new buckets initialized
+   here, so that the cost does not grow with the table.  Instead,
+   the old buckets are kept aside and this function, called after
+   every insertion and deletion, moves BUCKETS_PER_STEP of them at
+   a time into the new ones, which are initialized as they are
+   first needed. */
 static void rehash(struct hash *h) {
 	size_t old_bucket_cnt, new_bucket_cnt;
-	struct list *new_buckets, *old_buckets;
-	size_t i;
+	struct list *new_buckets;
 
 	ASSERT(h != NULL);
 
-	/* Save old bucket info for later use. */
-	old_buckets = h->buckets;
+	/* Keep moving the previous resize's buckets first. */
+	if (h->old_buckets != NULL) {
+		move_buckets(h, BUCKETS_PER_STEP);
+		return;
+	}
+
 	old_bucket_cnt = h->bucket_cnt;
 
 	/* Calculate the number of buckets to use now.
@@ -316,7 +485,7 @@ static void rehash(struct hash *h) {
 	if (new_bucket_cnt == old_bucket_cnt)
 		return;
 
-	/* Allocate new buckets and initialize them as empty. */
+	/* Allocate new buckets. */
 	new_buckets = malloc(sizeof *new_buckets * new_bucket_cnt);
 	if (new_buckets == NULL) {
 		/* Allocation failed.  This means that use of the hash table will
@@ -324,30 +493,50 @@ static void rehash(struct hash *h) {
 		   there's no reason for it to be an error. */
 		return;
 	}
-	for (i = 0; i < new_bucket_cnt; i++)
-		list_init(&new_buckets[i]);
 
-	/* Install new bucket info. */
+	/* Install new bucket info, keeping the old buckets around
+	   until all of their elements have been moved. */
+	h->old_buckets = h->buckets;
+	h->old_bucket_cnt = old_bucket_cnt;
+	h->moved_cnt = 0;
 	h->buckets = new_buckets;
 	h->bucket_cnt = new_bucket_cnt;
 
-	/* Move each old element into the appropriate new bucket. */
-	for (i = 0; i < old_bucket_cnt; i++) {
-		struct list *old_bucket;
-		struct list_elem *elem, *next;
+	move_buckets(h, BUCKETS_PER_STEP);
+}
 
-		old_bucket = &old_buckets[i];
-		for (elem = list_begin(old_bucket); elem != list_end(old_bucket);
-			 elem = next) {
-			struct list *new_bucket =
-				find_bucket(h, list_elem_to_hash_elem(elem));
-			next = list_next(elem);
-			list_remove(elem);
-			list_push_front(new_bucket, elem);
+/* Moves the elements of up to CNT of H's old buckets into the
+   current buckets, and frees the old buckets once they have all
+   been moved.  The current buckets that the elements of an old
+   bucket go to are initialized first: the ones whose index matches
+   the old bucket's in its low bits, if the table grew, or the one
+   with the old bucket's index, which gets the first of them, if it
+   shrank. */
+static void move_buckets(struct hash *h, size_t cnt) {
+	if (h->old_buckets == NULL)
+		return;
+
+	for (; cnt > 0 && h->moved_cnt < h->old_bucket_cnt; cnt--) {
+		size_t idx = h->moved_cnt++;
+		struct list *old_bucket = &h->old_buckets[idx];
+		size_t i;
+
+		for (i = idx; i < h->bucket_cnt; i += h->old_bucket_cnt)
+			list_init(&h->buckets[i]);
+
+		while (!list_empty(old_bucket)) {
+			struct list_elem *elem = list_pop_front(old_bucket);
+			uint64_t hash = h->hash(list_elem_to_hash_elem(elem), h->aux);
+			list_push_front(&h->buckets[hash & (h->bucket_cnt - 1)], elem);
 		}
 	}
 
-	free(old_buckets);
+	if (h->moved_cnt == h->old_bucket_cnt) {
+		free(h->old_buckets);
+		h->old_buckets = NULL;
+		h->old_bucket_cnt = 0;
+		h->moved_cnt = 0;
+	}
 }
 
 /* Inserts E into BUCKET (in hash table H). */
@@ -362,3 +551,137 @@ static void remove_elem(struct hash *h, struct hash_elem *e) {
 	h->elem_cnt--;
 	list_remove(&e->list_elem);
 }
+
+/* Open addressing.
+
+   Each element lives in the first free slot at or after its
+   "home" slot, hash & (bucket_cnt - 1).  With Robin Hood probing,
+   an element that is inserted and finds a slot taken by an
+   element closer to its own home takes that slot over, and the
+   displaced element moves on.  That keeps the probe sequences
+   short and even, and a lookup can stop as soon as it meets an
+   element closer to home than the one it is looking for.
+   Deletion shifts the following elements back instead of
+   leaving a tombstone.
+
+   The table grows once it is 7/8 full and shrinks below 1/8.
+   Resizing reinserts every slot at once, but it reuses the hash
+   value kept in each slot instead of calling the hash function. */
+
+/* Returns how far the element in slot IDX of H is from its home
+   slot. */
+static inline size_t probe_dist(struct hash *h, size_t idx) {
+	size_t mask = h->bucket_cnt - 1;
+	return (idx - (h->slots[idx].hash & mask)) & mask;
+}
+
+/* Returns the index of the slot in H that holds an element equal
+   to E, whose hash value is HASH, or SIZE_MAX if there is none. */
+static size_t find_slot(struct hash *h, struct hash_elem *e, uint64_t hash) {
+	size_t mask = h->bucket_cnt - 1;
+	size_t idx = hash & mask;
+	size_t dist;
+
+	for (dist = 0;; dist++, idx = (idx + 1) & mask) {
+		struct hash_slot *s = &h->slots[idx];
+
+		if (s->elem == NULL || probe_dist(h, idx) < dist)
+			return SIZE_MAX;
+		if (s->hash == hash && !h->less(s->elem, e, h->aux) &&
+			!h->less(e, s->elem, h->aux))
+			return idx;
+	}
+}
+
+/* Inserts E, whose hash value is HASH, into H, which must not
+   contain an element equal to E.  If H is due to grow but memory
+   is not available, E still goes in while there is room, as a
+   chained table degrades in that case.  Returns false, leaving H
+   unchanged, if there is none. */
+static bool place_slot(struct hash *h, struct hash_elem *e, uint64_t hash) {
+	struct hash_slot cur = {.elem = e, .hash = hash};
+	size_t mask, idx, dist;
+
+	/* Always leave at least one slot free, so that probing ends. */
+	if ((h->elem_cnt + 1) * 8 > h->bucket_cnt * 7 &&
+		!resize_slots(h, h->bucket_cnt * 2) &&
+		h->elem_cnt + 1 >= h->bucket_cnt)
+		return false;
+
+	mask = h->bucket_cnt - 1;
+	idx = hash & mask;
+	for (dist = 0;; dist++, idx = (idx + 1) & mask) {
+		struct hash_slot *s = &h->slots[idx];
+		size_t s_dist;
+
+		if (s->elem == NULL) {
+			*s = cur;
+			break;
+		}
+
+		/* Take the slot from an element closer to its home. */
+		s_dist = probe_dist(h, idx);
+		if (s_dist < dist) {
+			struct hash_slot tmp = *s;
+			*s = cur;
+			cur = tmp;
+			dist = s_dist;
+		}
+	}
+	h->elem_cnt++;
+	return true;
+}
+
+/* Removes the element in slot IDX from H. */
+static void remove_slot(struct hash *h, size_t idx) {
+	size_t mask = h->bucket_cnt - 1;
+
+	/* Shift back the elements that follow, up to the next empty
+	   slot or element in its home slot. */
+	for (;;) {
+		size_t next = (idx + 1) & mask;
+
+		if (h->slots[next].elem == NULL || probe_dist(h, next) == 0)
+			break;
+		h->slots[idx] = h->slots[next];
+		idx = next;
+	}
+	h->slots[idx].elem = NULL;
+	h->elem_cnt--;
+
+	if (h->elem_cnt * 8 < h->bucket_cnt && h->bucket_cnt > MIN_SLOTS)
+		resize_slots(h, h->bucket_cnt / 2);
+}
+
+/* Changes the number of slots in H to SLOT_CNT, a power of 2.
+   Returns false if memory is not available, in which case H is
+   unchanged. */
+static bool resize_slots(struct hash *h, size_t slot_cnt) {
+	struct hash_slot *old_slots = h->slots;
+	size_t old_slot_cnt = h->bucket_cnt;
+	size_t elem_cnt = h->elem_cnt;
+	size_t i;
+
+	ASSERT(is_power_of_2(slot_cnt));
+	ASSERT(slot_cnt > elem_cnt);
+
+	h->slots = malloc(sizeof *h->slots * slot_cnt);
+	if (h->slots == NULL) {
+		h->slots = old_slots;
+		return false;
+	}
+	h->bucket_cnt = slot_cnt;
+	for (i = 0; i < slot_cnt; i++)
+		h->slots[i].elem = NULL;
+
+	/* The new table is at most half full, so place_slot() will not
+	   resize it again. */
+	h->elem_cnt = 0;
+	for (i = 0; i < old_slot_cnt; i++)
+		if (old_slots[i].elem != NULL)
+			place_slot(h, old_slots[i].elem, old_slots[i].hash);
+	ASSERT(h->elem_cnt == elem_cnt);
+
+	free(old_slots);
+	return true;
+}
@@ -0,0 +1,144 @@
+#include "lz.h"
+#include <debug.h>
+#include <stdbool.h>
+#include <string.h>
+
+/* The compressed stream is a sequence of runs, each introduced by
+   a control byte C:
+
+   - C < 32: a literal run.  The next C + 1 bytes are copied
+     through.
+
+   - C >= 32: a back reference.  L = C >> 5 is the length minus
+     2, and if L is 7 the next byte adds to it, so that matches
+     of 3 to 264 bytes can be expressed.  The offset minus 1 is
+     (C & 0x1f) << 8 plus the byte after that, so up to 8192
+     bytes back.  The source and the copy may overlap. */
+
+#define MAX_LITERAL 32
+#define MIN_MATCH 3
+#define MAX_MATCH (7 + 255 + 2)
+#define MAX_OFFSET 8192
+
+/* Returns the hash of the 3 bytes at P. */
+static inline size_t hash3(const uint8_t *p) {
+	uint32_t v = p[0] | (p[1] << 8) | ((uint32_t)p[2] << 16);
+	return (v * 2654435761u) >> (32 - 12);
+}
+
+/* Appends the CNT literal bytes at LIT to DST, which holds *OP
+   bytes out of DST_CAP.  Returns false if they do not fit. */
+static bool put_literals(const uint8_t *lit, size_t cnt, uint8_t *dst,
+						 size_t *op, size_t dst_cap) {
+	while (cnt > 0) {
+		size_t run = cnt < MAX_LITERAL ? cnt : MAX_LITERAL;
+
+		if (*op + 1 + run > dst_cap)
+			return false;
+		dst[(*op)++] = run - 1;
+		memcpy(dst + *op, lit, run);
+		*op += run;
+		lit += run;
+		cnt -= run;
+	}
+	return true;
+}
+
+/* Compresses the SRC_LEN bytes at SRC into DST, which has room
+   for DST_CAP bytes.  WORK is scratch space, whose contents do
+   not matter on entry.  Returns the compressed size, or 0 if the
+   result would not fit in DST_CAP bytes, which is how
+   incompressible data shows up when DST_CAP is less than
+   SRC_LEN. */
+size_t lz_compress(const void *src_, size_t src_len, void *dst_,
+				   size_t dst_cap, uint16_t work[LZ_WORK_CNT]) {
+	const uint8_t *src = src_;
+	uint8_t *dst = dst_;
+	size_t ip = 0, op = 0, lit = 0;
+
+	ASSERT(src_len <= LZ_MAX_INPUT);
+
+	/* WORK maps a hash to 1 + the last position that had it, so
+	   that 0 means none. */
+	memset(work, 0, LZ_WORK_CNT * sizeof *work);
+
+	while (ip + MIN_MATCH <= src_len) {
+		size_t h = hash3(src + ip);
+		size_t ref = work[h];
+
+		work[h] = ip + 1;
+		if (ref != 0 && ip - (ref - 1) <= MAX_OFFSET &&
+			!memcmp(src + ref - 1, src + ip, MIN_MATCH)) {
+			size_t off = ip - ref;
+			size_t max = src_len - ip < MAX_MATCH ? src_len - ip : MAX_MATCH;
+			size_t len = MIN_MATCH;
+
+			ref--;
+			while (len < max && src[ref + len] == src[ip + len])
+				len++;
+
+			if (!put_literals(src + lit, ip - lit, dst, &op, dst_cap) ||
+				op + 3 > dst_cap)
+				return 0;
+			if (len - 2 < 7)
+				dst[op++] = ((len - 2) << 5) | (off >> 8);
+			else {
+				dst[op++] = (7 << 5) | (off >> 8);
+				dst[op++] = len - 2 - 7;
+			}
+			dst[op++] = off & 0xff;
+
+			ip += len;
+			lit = ip;
+		} else
+			ip++;
+	}
+	if (!put_literals(src + lit, src_len - lit, dst, &op, dst_cap))
+		return 0;
+	return op;
+}
+
+/* Decompresses the SRC_LEN bytes at SRC, produced by
+   lz_compress(), into DST, which has room for DST_CAP bytes.
+   Returns the decompressed size, or 0 if SRC is corrupt or
+   decompresses to more than DST_CAP bytes. */
+size_t lz_decompress(const void *src_, size_t src_len, void *dst_,
+					 size_t dst_cap) {
+	const uint8_t *src = src_;
+	uint8_t *dst = dst_;
+	size_t ip = 0, op = 0;
+
+	while (ip < src_len) {
+		size_t c = src[ip++];
+
+		if (c < 32) {
+			size_t run = c + 1;
+
+			if (ip + run > src_len || op + run > dst_cap)
+				return 0;
+			memcpy(dst + op, src + ip, run);
+			ip += run;
+			op += run;
+		} else {
+			size_t len = (c >> 5) + 2;
+			size_t off;
+
+			if (len == 7 + 2) {
+				if (ip >= src_len)
+					return 0;
+				len += src[ip++];
+			}
+			if (ip >= src_len)
+				return 0;
+			off = ((c & 0x1f) << 8 | src[ip++]) + 1;
+			if (off > op || op + len > dst_cap)
+				return 0;
+
+			/* Byte by byte, since the copy may overlap its
+			   source. */
+			for (; len > 0; len--, op++)
+				dst[op] = dst[op - off];
+		}
+	}
+	return op;
+}
@@ -1,5 +1,71 @@
 #include <string.h>
 #include <debug.h>
+#include <stdint.h>
+
+/* The memory primitives below work a machine word at a time
+   instead of a byte at a time, and hand large blocks to the
+   string instructions (rep movsq, rep stosq).  SSE is not used:
+   the kernel is built with -mno-sse and does not save the FPU
+   state of kernel threads.
+
+   A word_t may be unaligned and may alias any other type. */
+typedef uint64_t word_t __attribute__((may_alias, aligned(1)));
+
+#define WORD_SIZE sizeof(word_t)
+#define ONES 0x0101010101010101ULL	/* 0x01 in every byte. */
+#define HIGHS 0x8080808080808080ULL /* 0x80 in every byte. */
+
+/* Nonzero if some byte of word X is zero. */
+#define HAS_ZERO(X) (((X)-ONES) & ~(X)&HIGHS)
+
+/* Blocks of at least this many bytes use the string instructions,
+   whose startup cost only pays off for larger blocks. */
+#define REP_THRESHOLD 256
+
+/* Copies SIZE bytes from SRC up to DST, lowest address first, so
+   that it also works if DST is below an overlapping SRC. */
+static void copy_forward(unsigned char *dst, const unsigned char *src,
+						 size_t size) {
+	/* Align DST, so that no word store straddles two words. */
+	if (size >= WORD_SIZE)
+		for (; (uintptr_t)dst % WORD_SIZE != 0; size--)
+			*dst++ = *src++;
+
+	if (size >= REP_THRESHOLD) {
+		size_t word_cnt = size / WORD_SIZE;
+		asm volatile("rep movsq"
+					 : "+D"(dst), "+S"(src), "+c"(word_cnt)
+					 :
+					 : "memory");
+		size %= WORD_SIZE;
+	}
+	for (; size >= WORD_SIZE; size -= WORD_SIZE) {
+		*(word_t *)dst = *(const word_t *)src;
+		dst += WORD_SIZE;
+		src += WORD_SIZE;
+	}
+	while (size-- > 0)
+		*dst++ = *src++;
+}
+
+/* Copies SIZE bytes from SRC to DST, highest address first, so
+   that it also works if DST is above an overlapping SRC. */
+static void copy_backward(unsigned char *dst, const unsigned char *src,
+						  size_t size) {
+	dst += size;
+	src += size;
+
+	if (size >= WORD_SIZE)
+		for (; (uintptr_t)dst % WORD_SIZE != 0; size--)
+			*--dst = *--src;
+	for (; size >= WORD_SIZE; size -= WORD_SIZE) {
+		dst -= WORD_SIZE;
+		src -= WORD_SIZE;
+		*(word_t *)dst = *(const word_t *)src;
+	}
+	while (size-- > 0)
+		*--dst = *--src;
+}
 
 /* Copies SIZE bytes from SRC to DST, which must not overlap.
    Returns DST. */
@@ -10,9 +76,7 @@ void *memcpy(void *dst_, const void *src_, size_t size) {
 	ASSERT(dst != NULL || size == 0);
 	ASSERT(src != NULL || size == 0);
 
-	while (size-- > 0)
-		*dst++ = *src++;
-
+	copy_forward(dst, src, size);
 	return dst_;
 }
 
@@ -25,17 +89,12 @@ void *memmove(void *dst_, const void *src_, size_t size) {
 	ASSERT(dst != NULL || size == 0);
 	ASSERT(src != NULL || size == 0);
 
-	if (dst < src) {
-		while (size-- > 0)
-			*dst++ = *src++;
-	} else {
-		dst += size;
-		src += size;
-		while (size-- > 0)
-			*--dst = *--src;
-	}
+	if (dst < src || dst >= src + size)
+		copy_forward(dst, src, size);
+	else if (dst != src)
+		copy_backward(dst, src, size);
 
-	return dst;
+	return dst_;
 }
 
 /* Find the first differing byte in the two blocks of SIZE bytes
@@ -49,6 +108,13 @@ int memcmp(const void *a_, const void *b_, size_t size) {
 	ASSERT(a != NULL || size == 0);
 	ASSERT(b != NULL || size == 0);
 
+	/* Skip equal words; the byte loop finds the difference. */
+	for (; size >= WORD_SIZE; size -= WORD_SIZE) {
+		if (*(const word_t *)a != *(const word_t *)b)
+			break;
+		a += WORD_SIZE;
+		b += WORD_SIZE;
+	}
 	for (; size-- > 0; a++, b++)
 		if (*a != *b)
 			return *a > *b ? +1 : -1;
@@ -84,6 +150,20 @@ void *memchr(const void *block_, int ch_, size_t size) {
 
 	ASSERT(block != NULL || size == 0);
 
+	/* Whole words first: a byte equal to CH becomes a zero byte
+	   once the word is XORed with CH repeated. */
+	if (size >= WORD_SIZE) {
+		word_t pattern = ch * ONES;
+
+		for (; (uintptr_t)block % WORD_SIZE != 0; block++, size--)
+			if (*block == ch)
+				return (void *)block;
+		for (; size >= WORD_SIZE; block += WORD_SIZE, size -= WORD_SIZE) {
+			word_t w = *(const word_t *)block ^ pattern;
+			if (HAS_ZERO(w))
+				break;
+		}
+	}
 	for (; size-- > 0; block++)
 		if (*block == ch)
 			return (void *)block;
@@ -244,9 +324,26 @@ char *strtok_r(char *s, const char *delimiters, char **save_ptr) {
 /* Sets the SIZE bytes in DST to VALUE. */
 void *memset(void *dst_, int value, size_t size) {
 	unsigned char *dst = dst_;
+	word_t pattern = (unsigned char)value * ONES;
 
 	ASSERT(dst != NULL || size == 0);
 
+	if (size >= WORD_SIZE)
+		for (; (uintptr_t)dst % WORD_SIZE != 0; size--)
+			*dst++ = value;
+
+	if (size >= REP_THRESHOLD) {
+		size_t word_cnt = size / WORD_SIZE;
+		asm volatile("rep stosq"
+					 : "+D"(dst), "+c"(word_cnt)
+					 : "a"(pattern)
+					 : "memory");
+		size %= WORD_SIZE;
+	}
+	for (; size >= WORD_SIZE; size -= WORD_SIZE) {
+		*(word_t *)dst = pattern;
+		dst += WORD_SIZE;
+	}
 	while (size-- > 0)
 		*dst++ = value;
 
@@ -259,7 +356,15 @@ size_t strlen(const char *string) {
 
 	ASSERT(string);
 
-	for (p = string; *p != '\0'; p++)
+	/* Reach a word boundary, then test a word at a time.  An
+	   aligned word never crosses a page boundary, so reading past
+	   the terminator cannot fault. */
+	for (p = string; (uintptr_t)p % WORD_SIZE != 0; p++)
+		if (*p == '\0')
+			return p - string;
+	while (!HAS_ZERO(*(const word_t *)p))
+		p += WORD_SIZE;
+	for (; *p != '\0'; p++)
 		continue;
 	return p - string;
 }
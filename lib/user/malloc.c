@@ -0,0 +1,362 @@
+#include <malloc.h>
+#include <round.h>
+#include <stdint.h>
+#include <string.h>
+#include <syscall.h>
+
+/* A memory allocator on top of sbrk().
+
+   The heap is a sequence of chunks, each with a header that
+   gives its size and that of the chunk before it, so that a
+   chunk can find both of its neighbours.  The last chunk is the
+   top, the free space at the end of the heap: the heap grows by
+   moving the break to make the top larger, and shrinks again
+   when the top gets large.
+
+   Small chunks, up to SMALL_MAX bytes with the header, are for
+   the sizes that programs allocate most often and free soon.
+   Each size, in steps of ALIGN bytes, has a list of free chunks
+   of its own, so that malloc() and free() of a small block just
+   pop and push it.  When the list is empty, a run of chunks of
+   that size about REFILL_BYTES long is carved out at once.  Free
+   small chunks stay small and are not coalesced.
+
+   Larger chunks are kept in bins by the power of 2 of their size.
+   A request takes the first chunk of its bin that fits, or any
+   chunk of a larger bin, or else comes from the top, and what is
+   left over goes back in a bin.  A freed large chunk is coalesced
+   with the chunks around it that are free, and with the top if it
+   borders it.
+
+   There are no user threads, so there are no locks and no caches
+   per thread. */
+
+#define ALIGN 16			  /* Alignment of blocks and chunk sizes. */
+#define SMALL_MAX 512		  /* Largest small chunk. */
+#define REFILL_BYTES 4096	  /* Size of a run of small chunks. */
+#define GROW_BYTES (64 * 1024) /* Least to grow the heap by. */
+#define TRIM_BYTES (256 * 1024) /* Size of top that makes it shrink. */
+#define BIN_CNT 64			  /* Number of large bins. */
+#define PAGE_SIZE 4096
+
+/* A chunk.  Its block starts at NEXT, which is only used while the
+   chunk is free. */
+struct chunk {
+	size_t prev_size;	 /* Size of the chunk before, 0 if none. */
+	size_t size;		 /* Size of this one, with IN_USE. */
+	struct chunk *next;	 /* Next in its free list. */
+	struct chunk *prev;	 /* Previous in its bin. */
+};
+
+#define IN_USE 1
+#define HEADER_SIZE offsetof(struct chunk, next)
+#define MIN_CHUNK sizeof(struct chunk)
+
+static struct chunk *small_bins[SMALL_MAX / ALIGN + 1];
+static struct chunk *large_bins[BIN_CNT];
+static uint64_t bin_map;  /* Bit I set if LARGE_BINS[I] is not empty. */
+static struct chunk *top; /* Free space at the end of the heap. */
+
+static void release(struct chunk *c);
+
+static inline size_t chunk_size(const struct chunk *c) {
+	return c->size & ~(size_t)IN_USE;
+}
+
+static inline struct chunk *next_chunk(const struct chunk *c) {
+	return (struct chunk *)((uint8_t *)c + chunk_size(c));
+}
+
+static inline struct chunk *chunk_of(void *block) {
+	return (struct chunk *)((uint8_t *)block - HEADER_SIZE);
+}
+
+static inline void *block_of(struct chunk *c) {
+	return (uint8_t *)c + HEADER_SIZE;
+}
+
+/* Returns the size of chunk that holds a block of N bytes, or 0 if
+   N is too large. */
+static size_t request_size(size_t n) {
+	size_t size;
+
+	if (n > SIZE_MAX / 2)
+		return 0;
+	size = ROUND_UP(n + HEADER_SIZE, ALIGN);
+	return size < MIN_CHUNK ? MIN_CHUNK : size;
+}
+
+/* Returns the large bin for chunks of SIZE bytes. */
+static inline int bin_of(size_t size) {
+	return 63 - __builtin_clzll(size);
+}
+
+static void bin_insert(struct chunk *c) {
+	int bin = bin_of(c->size);
+
+	c->prev = NULL;
+	c->next = large_bins[bin];
+	if (c->next != NULL)
+		c->next->prev = c;
+	large_bins[bin] = c;
+	bin_map |= 1ULL << bin;
+}
+
+static void bin_remove(struct chunk *c) {
+	int bin = bin_of(c->size);
+
+	if (c->prev != NULL)
+		c->prev->next = c->next;
+	else
+		large_bins[bin] = c->next;
+	if (c->next != NULL)
+		c->next->prev = c->prev;
+	if (large_bins[bin] == NULL)
+		bin_map &= ~(1ULL << bin);
+}
+
+/* Moves the break to give the top at least NEED more bytes.
+   Returns false if the break cannot move. */
+static bool grow(size_t need) {
+	size_t incr = ROUND_UP(need > GROW_BYTES ? need : GROW_BYTES, PAGE_SIZE);
+	uint8_t *p = sbrk(incr);
+
+	if (p == (void *)-1)
+		return false;
+	if (top != NULL && p == (uint8_t *)next_chunk(top)) {
+		top->size += incr;
+		return true;
+	}
+
+	/* The first time, or the break was moved behind our back: start
+	   again from here.  What was left of the old top stays in use. */
+	if (top != NULL)
+		top->size |= IN_USE;
+	top = (struct chunk *)ROUND_UP((uintptr_t)p, ALIGN);
+	top->prev_size = 0;
+	top->size = incr - ((uint8_t *)top - p);
+	return true;
+}
+
+/* Gives the top back to the system, down to GROW_BYTES, if it has
+   grown past TRIM_BYTES and still ends at the break. */
+static void trim(void) {
+	size_t excess;
+
+	if (top->size <= TRIM_BYTES || sbrk(0) != next_chunk(top))
+		return;
+	excess = ROUND_DOWN(top->size - GROW_BYTES, PAGE_SIZE);
+	if (sbrk(-(intptr_t)excess) != (void *)-1)
+		top->size -= excess;
+}
+
+/* Takes a chunk of SIZE bytes off the front of the top, growing the
+   heap if needed.  Returns a null pointer if it cannot grow. */
+static struct chunk *from_top(size_t size) {
+	struct chunk *c;
+
+	/* The top always keeps room for a header of its own. */
+	while (top == NULL || top->size < size + MIN_CHUNK)
+		if (!grow(size + MIN_CHUNK - (top != NULL ? top->size : 0)))
+			return NULL;
+
+	c = top;
+	top = (struct chunk *)((uint8_t *)c + size);
+	top->prev_size = size;
+	top->size = c->size - size;
+	c->size = size | IN_USE;
+	return c;
+}
+
+/* Cuts C, a chunk in use, down to SIZE bytes, and frees the rest if
+   it is large enough to be a chunk. */
+static void split(struct chunk *c, size_t size) {
+	size_t rest = chunk_size(c) - size;
+	struct chunk *r;
+
+	if (rest < MIN_CHUNK)
+		return;
+	r = (struct chunk *)((uint8_t *)c + size);
+	r->prev_size = size;
+	r->size = rest | IN_USE;
+	next_chunk(r)->prev_size = rest;
+	c->size = size | IN_USE;
+	release(r);
+}
+
+/* Returns a chunk of at least SIZE bytes that is not small, or a
+   null pointer if memory is exhausted. */
+static struct chunk *large_alloc(size_t size) {
+	int bin = bin_of(size);
+	uint64_t larger;
+	struct chunk *c;
+
+	for (c = large_bins[bin]; c != NULL; c = c->next)
+		if (c->size >= size)
+			goto found;
+	larger = bin < 63 ? bin_map & ~((2ULL << bin) - 1) : 0;
+	if (larger == 0)
+		return from_top(size);
+	c = large_bins[__builtin_ctzll(larger)];
+
+found:
+	bin_remove(c);
+	c->size |= IN_USE;
+	split(c, size);
+	return c;
+}
+
+/* Returns a small chunk of SIZE bytes, after carving a run of them
+   out of a large one, or a null pointer if memory is exhausted. */
+static struct chunk *small_refill(size_t size) {
+	size_t cnt = REFILL_BYTES / size;
+	struct chunk *run = large_alloc(cnt * size);
+	struct chunk *c;
+	size_t total, i;
+
+	if (run == NULL)
+		return NULL;
+
+	/* The run may have come with a few bytes too many for a chunk of
+	   their own, which go to the last chunk. */
+	total = chunk_size(run);
+	run->size = size | IN_USE;
+	c = run;
+	for (i = 1; i < cnt; i++) {
+		c = (struct chunk *)((uint8_t *)run + i * size);
+		c->prev_size = size;
+		c->size = (i < cnt - 1 ? size : total - i * size) | IN_USE;
+	}
+	next_chunk(c)->prev_size = chunk_size(c);
+	for (i = 1; i < cnt; i++)
+		release((struct chunk *)((uint8_t *)run + i * size));
+	return run;
+}
+
+/* Frees C: a small chunk goes on the list for its size, and a large
+   one is coalesced with its free neighbours. */
+static void release(struct chunk *c) {
+	size_t size = chunk_size(c);
+	struct chunk *next = next_chunk(c);
+
+	if (size <= SMALL_MAX) {
+		c->next = small_bins[size / ALIGN];
+		small_bins[size / ALIGN] = c;
+		return;
+	}
+
+	if (c->prev_size != 0) {
+		struct chunk *prev = (struct chunk *)((uint8_t *)c - c->prev_size);
+
+		if (!(prev->size & IN_USE)) {
+			bin_remove(prev);
+			size += prev->size;
+			c = prev;
+		}
+	}
+	if (next == top) {
+		c->size = size + top->size;
+		top = c;
+		trim();
+		return;
+	}
+	if (!(next->size & IN_USE)) {
+		bin_remove(next);
+		size += next->size;
+	}
+	c->size = size;
+	next_chunk(c)->prev_size = size;
+	bin_insert(c);
+}
+
+/* Obtains and returns a new block of at least SIZE bytes, aligned
+   to 16 bytes.  Returns a null pointer if memory is not
+   available. */
+void *malloc(size_t n) {
+	size_t size = request_size(n);
+	struct chunk *c;
+
+	if (size == 0)
+		return NULL;
+	if (size <= SMALL_MAX) {
+		c = small_bins[size / ALIGN];
+		if (c != NULL)
+			small_bins[size / ALIGN] = c->next;
+		else
+			c = small_refill(size);
+	} else
+		c = large_alloc(size);
+	return c != NULL ? block_of(c) : NULL;
+}
+
+/* Allocates and returns a zeroed block of CNT * SIZE bytes, or a
+   null pointer if memory is not available or the product
+   overflows. */
+void *calloc(size_t cnt, size_t size) {
+	void *p;
+
+	if (size != 0 && cnt > SIZE_MAX / size)
+		return NULL;
+	p = malloc(cnt * size);
+	if (p != NULL)
+		memset(p, 0, cnt * size);
+	return p;
+}
+
+/* Attempts to resize the block at PTR to N bytes, possibly moving
+   it.  A large block grows in place into the free chunk or the top
+   after it when it can.  Returns the new block, or a null pointer,
+   leaving PTR alone, if memory is not available.  A null PTR is
+   like malloc(N), and N of 0 is like free(PTR). */
+void *realloc(void *ptr, size_t n) {
+	size_t size = request_size(n);
+	struct chunk *c, *next;
+	void *p;
+
+	if (ptr == NULL)
+		return malloc(n);
+	if (n == 0) {
+		free(ptr);
+		return NULL;
+	}
+	if (size == 0)
+		return NULL;
+
+	c = chunk_of(ptr);
+	if (chunk_size(c) >= size)
+		return ptr;
+	if (chunk_size(c) > SMALL_MAX) {
+		next = next_chunk(c);
+		if (next == top && top->size >= size - chunk_size(c) + MIN_CHUNK) {
+			size_t rest = top->size - (size - chunk_size(c));
+
+			top = (struct chunk *)((uint8_t *)c + size);
+			top->prev_size = size;
+			top->size = rest;
+			c->size = size | IN_USE;
+			return ptr;
+		}
+		if (next != top && !(next->size & IN_USE) &&
+			chunk_size(c) + next->size >= size) {
+			bin_remove(next);
+			c->size += next->size;
+			next_chunk(c)->prev_size = chunk_size(c);
+			split(c, size);
+			return ptr;
+		}
+	}
+
+	p = malloc(n);
+	if (p != NULL) {
+		memcpy(p, ptr, chunk_size(c) - HEADER_SIZE);
+		free(ptr);
+	}
+	return p;
+}
+
+/* Frees block P, which must have been previously allocated with
+   malloc(), calloc(), or realloc(). */
+void free(void *p) {
+	if (p != NULL)
+		release(chunk_of(p));
+}
@@ -98,12 +98,46 @@ void close(int fd) { syscall1(SYS_CLOSE, fd); }
 
 int dup2(int oldfd, int newfd) { return syscall2(SYS_DUP2, oldfd, newfd); }
 
+pid_t spawn(const char *cmd_line, const struct spawn_action *actions,
+			size_t action_cnt) {
+	return (pid_t)syscall3(SYS_SPAWN, cmd_line, actions, action_cnt);
+}
+
 void *mmap(void *addr, size_t length, int writable, int fd, off_t offset) {
 	return (void *)syscall5(SYS_MMAP, addr, length, writable, fd, offset);
 }
 
 void munmap(void *addr) { syscall1(SYS_MUNMAP, addr); }
 
+int madvise(void *addr, size_t length, int advice) {
+	return syscall3(SYS_MADVISE, addr, length, advice);
+}
+
+int msync(void *addr, size_t length, int flags) {
+	return syscall3(SYS_MSYNC, addr, length, flags);
+}
+
+int memstat(struct memstat *st) { return syscall1(SYS_MEMSTAT, st); }
+
+/* The break as of the last call, or a null pointer before the first. */
+static char *cur_brk;
+
+int brk(void *addr) {
+	cur_brk = (char *)syscall1(SYS_BRK, addr);
+	return cur_brk == addr ? 0 : -1;
+}
+
+void *sbrk(intptr_t increment) {
+	char *old;
+
+	if (cur_brk == NULL)
+		cur_brk = (char *)syscall1(SYS_BRK, NULL);
+	old = cur_brk;
+	if (increment != 0 && brk(old + increment) != 0)
+		return (void *)-1;
+	return old;
+}
+
 bool chdir(const char *dir) { return syscall1(SYS_CHDIR, dir); }
 
 bool mkdir(const char *dir) { return syscall1(SYS_MKDIR, dir); }
@@ -0,0 +1,155 @@
+/* Checks memcpy(), memset(), memcmp(), memchr() and strlen()
+   against plain byte loops for every combination of source and
+   destination alignment within a word, at sizes around the word
+   size and around the threshold where the string instructions
+   take over.  Also checks that no byte outside the destination
+   is touched. */
+
+#include <string.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define GUARD 16
+#define MAX_SIZE 4099
+#define ALIGN_CNT 16
+
+static const size_t sizes[] = {0,  1,  7,	8,	 9,	  15,  16,  17,  63,
+							   64, 65, 255, 256, 257, 1000, 4096, MAX_SIZE};
+#define SIZE_CNT (sizeof sizes / sizeof *sizes)
+
+static unsigned char src[MAX_SIZE + ALIGN_CNT + 2 * GUARD];
+static unsigned char dst[MAX_SIZE + ALIGN_CNT + 2 * GUARD];
+static unsigned char expected[MAX_SIZE + ALIGN_CNT + 2 * GUARD];
+
+/* Fills BUF with a pattern that differs for every SEED. */
+static void fill(unsigned char *buf, unsigned seed) {
+	size_t i;
+
+	for (i = 0; i < sizeof src; i++)
+		buf[i] = (i * 7 + seed * 13 + 1) % 251 + 1;
+}
+
+/* Fails unless DST matches EXPECTED, guard bytes included. */
+static void compare(const char *what, size_t src_ofs, size_t dst_ofs,
+					size_t size) {
+	size_t i;
+
+	for (i = 0; i < sizeof dst; i++)
+		if (dst[i] != expected[i])
+			fail("%s of %zu bytes from offset %zu to offset %zu: "
+				 "byte %zu is %02x instead of %02x",
+				 what, size, src_ofs, dst_ofs, i, dst[i], expected[i]);
+}
+
+static void check_memcpy(void) {
+	size_t s, src_ofs, dst_ofs, i;
+
+	for (s = 0; s < SIZE_CNT; s++)
+		for (src_ofs = 0; src_ofs < ALIGN_CNT; src_ofs++)
+			for (dst_ofs = 0; dst_ofs < ALIGN_CNT; dst_ofs++) {
+				size_t size = sizes[s];
+
+				fill(src, 1);
+				fill(dst, 2);
+				fill(expected, 2);
+				for (i = 0; i < size; i++)
+					expected[GUARD + dst_ofs + i] = src[GUARD + src_ofs + i];
+				if (memcpy(dst + GUARD + dst_ofs, src + GUARD + src_ofs,
+						   size) != dst + GUARD + dst_ofs)
+					fail("memcpy returned wrong pointer");
+				compare("memcpy", src_ofs, dst_ofs, size);
+			}
+}
+
+static void check_memset(void) {
+	size_t s, dst_ofs, i;
+
+	for (s = 0; s < SIZE_CNT; s++)
+		for (dst_ofs = 0; dst_ofs < ALIGN_CNT; dst_ofs++) {
+			size_t size = sizes[s];
+
+			fill(dst, 3);
+			fill(expected, 3);
+			for (i = 0; i < size; i++)
+				expected[GUARD + dst_ofs + i] = 0xa5;
+			if (memset(dst + GUARD + dst_ofs, 0x1a5, size) !=
+				dst + GUARD + dst_ofs)
+				fail("memset returned wrong pointer");
+			compare("memset", 0, dst_ofs, size);
+		}
+}
+
+static void check_memcmp(void) {
+	size_t s, ofs, diff;
+
+	for (s = 0; s < SIZE_CNT; s++)
+		for (ofs = 0; ofs < ALIGN_CNT; ofs++) {
+			size_t size = sizes[s];
+
+			fill(src, 4);
+			fill(dst, 4);
+			if (memcmp(src + ofs, dst + GUARD + ofs, 0) != 0 ||
+				memcmp(src + GUARD + ofs, dst + GUARD + ofs, size) != 0)
+				fail("memcmp of %zu equal bytes at offset %zu", size, ofs);
+
+			/* A single differing byte, at every position for small
+			   sizes and at a few for large ones. */
+			for (diff = 0; diff < size; diff += diff < 64 ? 1 : size / 7) {
+				unsigned char *p = dst + GUARD + ofs + diff;
+
+				(*p)++;
+				if (memcmp(src + GUARD + ofs, dst + GUARD + ofs, size) >= 0 ||
+					memcmp(dst + GUARD + ofs, src + GUARD + ofs, size) <= 0)
+					fail("memcmp of %zu bytes at offset %zu, "
+						 "differing at byte %zu",
+						 size, ofs, diff);
+				(*p)--;
+			}
+		}
+}
+
+static void check_memchr_strlen(void) {
+	size_t s, ofs, pos;
+
+	for (s = 0; s < SIZE_CNT; s++)
+		for (ofs = 0; ofs < ALIGN_CNT; ofs++) {
+			size_t size = sizes[s];
+			unsigned char *block = dst + GUARD + ofs;
+
+			/* fill() never produces 0 or 0xff. */
+			fill(dst, 5);
+			if (memchr(block, 0xff, size) != NULL)
+				fail("memchr found missing byte in %zu bytes at offset %zu",
+					 size, ofs);
+			block[size] = 0xff;
+			if (memchr(block, 0xff, size) != NULL)
+				fail("memchr of %zu bytes at offset %zu read past the end",
+					 size, ofs);
+			block[size] = '\0';
+			if (strlen((char *)block) != size)
+				fail("strlen of %zu bytes at offset %zu", size, ofs);
+
+			for (pos = 0; pos < size; pos += pos < 64 ? 1 : size / 7) {
+				block[pos] = 0xff;
+				if (memchr(block, 0xff, size) != block + pos)
+					fail("memchr of %zu bytes at offset %zu, "
+						 "byte at %zu",
+						 size, ofs, pos);
+				block[pos] = '\0';
+				if (strlen((char *)block) != pos)
+					fail("strlen of %zu bytes at offset %zu", pos, ofs);
+				block[pos] = 0x5a;
+			}
+		}
+}
+
+void test_main(void) {
+	msg("check memcpy");
+	check_memcpy();
+	msg("check memset");
+	check_memset();
+	msg("check memcmp");
+	check_memcmp();
+	msg("check memchr and strlen");
+	check_memchr_strlen();
+}
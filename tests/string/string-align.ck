@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(string-align) begin
+(string-align) check memcpy
+(string-align) check memset
+(string-align) check memcmp
+(string-align) check memchr and strlen
+(string-align) end
+string-align: exit(0)
+EOF
+pass;
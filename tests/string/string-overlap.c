@@ -0,0 +1,70 @@
+/* Checks memmove() on overlapping blocks, with the destination
+   both below and above the source, at every distance up to a few
+   words and at sizes on both sides of the threshold where the
+   string instructions take over.  Also checks that no byte
+   outside the destination is touched. */
+
+#include <string.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define BUF_SIZE 4608
+#define MAX_DIST 33
+
+static const size_t sizes[] = {1, 7, 8, 9, 63, 64, 65, 255, 256, 257, 4096};
+#define SIZE_CNT (sizeof sizes / sizeof *sizes)
+
+static unsigned char buf[BUF_SIZE];
+static unsigned char expected[BUF_SIZE];
+
+/* Fills BUF and EXPECTED with the same pattern. */
+static void fill(void) {
+	size_t i;
+
+	for (i = 0; i < BUF_SIZE; i++)
+		buf[i] = expected[i] = (i * 7 + 1) % 251;
+}
+
+/* Moves SIZE bytes from BASE to BASE + DIST in EXPECTED the slow
+   way, through a second buffer. */
+static void move_expected(size_t base, long dist, size_t size) {
+	static unsigned char tmp[BUF_SIZE];
+	size_t i;
+
+	for (i = 0; i < size; i++)
+		tmp[i] = expected[base + i];
+	for (i = 0; i < size; i++)
+		expected[base + dist + i] = tmp[i];
+}
+
+static void check(long dist) {
+	size_t s, i;
+
+	for (s = 0; s < SIZE_CNT; s++) {
+		size_t size = sizes[s];
+		size_t base = 3 * MAX_DIST / 2 + (size + dist) % 8;
+
+		fill();
+		move_expected(base, dist, size);
+		if (memmove(buf + base + dist, buf + base, size) != buf + base + dist)
+			fail("memmove returned wrong pointer");
+		for (i = 0; i < BUF_SIZE; i++)
+			if (buf[i] != expected[i])
+				fail("memmove of %zu bytes by %ld: "
+					 "byte %zu is %02x instead of %02x",
+					 size, dist, i, buf[i], expected[i]);
+	}
+}
+
+void test_main(void) {
+	long dist;
+
+	msg("move down");
+	for (dist = -1; dist >= -MAX_DIST; dist--)
+		check(dist);
+	msg("move up");
+	for (dist = 1; dist <= MAX_DIST; dist++)
+		check(dist);
+	msg("move in place");
+	check(0);
+}
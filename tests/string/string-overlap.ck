@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(string-overlap) begin
+(string-overlap) move down
+(string-overlap) move up
+(string-overlap) move in place
+(string-overlap) end
+string-overlap: exit(0)
+EOF
+pass;
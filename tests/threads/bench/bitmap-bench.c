@@ -0,0 +1,92 @@
+/* Measures the bitmap operations that the page allocator and the
+   free map depend on.
+
+   For bitmaps from 1,024 bits up to 131,072 bits, which covers
+   the 16,384-bit free map of an 8 MB disk and the page pools of
+   a 512 MB machine, marks every bit in use except for a free run
+   at the end and reports the average cost in TSC cycles of:
+
+	 - bitmap_scan() for 1 and for 8 free bits, which must walk
+	   the whole bitmap,
+	 - the same 1-bit search done a bit at a time with
+	   bitmap_test(), as the old implementation did,
+	 - bitmap_count() over the whole bitmap,
+	 - allocating and freeing one bit with
+	   bitmap_scan_from_hint(), as palloc does. */
+
+#include <bitmap.h>
+#include <intrinsic.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+
+#define ROUND_CNT 64
+#define FREE_CNT 64
+
+static const size_t sizes[] = {1024, 4096, 16384, 65536, 131072};
+#define SIZE_CNT (sizeof sizes / sizeof *sizes)
+
+/* Finds the first false bit in B one bit at a time. */
+static size_t scan_bit_by_bit(const struct bitmap *b) {
+	size_t i;
+
+	for (i = 0; i < bitmap_size(b); i++)
+		if (!bitmap_test(b, i))
+			return i;
+	return BITMAP_ERROR;
+}
+
+void test_bitmap_bench(void) {
+	size_t s, round;
+
+	for (s = 0; s < SIZE_CNT; s++) {
+		size_t bit_cnt = sizes[s];
+		size_t first_free = bit_cnt - FREE_CNT;
+		unsigned long long start, scan1, scan8, naive, count, hint;
+		struct bitmap *b;
+
+		b = bitmap_create(bit_cnt);
+		if (b == NULL)
+			fail("bitmap_create(%zu) failed", bit_cnt);
+		bitmap_set_multiple(b, 0, first_free, true);
+
+		start = rdtsc();
+		for (round = 0; round < ROUND_CNT; round++)
+			if (bitmap_scan(b, 0, 1, false) != first_free)
+				fail("bitmap_scan for 1 bit in %zu bits", bit_cnt);
+		scan1 = (rdtsc() - start) / ROUND_CNT;
+
+		start = rdtsc();
+		for (round = 0; round < ROUND_CNT; round++)
+			if (bitmap_scan(b, 0, 8, false) != first_free)
+				fail("bitmap_scan for 8 bits in %zu bits", bit_cnt);
+		scan8 = (rdtsc() - start) / ROUND_CNT;
+
+		start = rdtsc();
+		for (round = 0; round < ROUND_CNT; round++)
+			if (scan_bit_by_bit(b) != first_free)
+				fail("bit-by-bit scan in %zu bits", bit_cnt);
+		naive = (rdtsc() - start) / ROUND_CNT;
+
+		start = rdtsc();
+		for (round = 0; round < ROUND_CNT; round++)
+			if (bitmap_count(b, 0, bit_cnt, true) != first_free)
+				fail("bitmap_count of %zu bits", bit_cnt);
+		count = (rdtsc() - start) / ROUND_CNT;
+
+		start = rdtsc();
+		for (round = 0; round < ROUND_CNT; round++) {
+			size_t idx = bitmap_scan_from_hint(b, 1, false);
+			if (idx < first_free)
+				fail("bitmap_scan_from_hint in %zu bits", bit_cnt);
+			bitmap_mark(b, idx);
+			bitmap_reset(b, idx);
+		}
+		hint = (rdtsc() - start) / ROUND_CNT;
+
+		msg("%zu bits: scan 1 %llu, scan 8 %llu, bit-by-bit %llu, "
+			"count %llu, hint %llu cycles",
+			bit_cnt, scan1, scan8, naive, count, hint);
+		bitmap_destroy(b);
+	}
+	pass();
+}
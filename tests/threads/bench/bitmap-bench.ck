@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+# The cycle counts vary from run to run, so only check that every
+# bitmap size reported its counts.
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+@output = get_core_output ("run", @output);
+foreach my $bits (1024, 4096, 16384, 65536, 131072) {
+    fail "missing results for $bits bits"
+      unless grep (/^\(bitmap-bench\) $bits bits: scan 1 \d+, scan 8 \d+, bit-by-bit \d+, count \d+, hint \d+ cycles$/,
+		   @output);
+}
+fail "missing PASS in output"
+  unless grep ($_ eq '(bitmap-bench) PASS', @output);
+pass;
@@ -0,0 +1,102 @@
+/* Measures insertion, lookup and deletion in hash tables of one
+   million elements, with chaining and with open addressing.
+
+   Reports the average cost of each operation in TSC cycles, and
+   also the worst single insertion, which is where a resize that
+   moved the whole table at once used to show up. */
+
+#include <hash.h>
+#include <intrinsic.h>
+#include <round.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+#define ELEM_CNT (1024 * 1024)
+
+struct item {
+	struct hash_elem elem;
+	uint64_t key;
+};
+
+static uint64_t item_hash(const struct hash_elem *e, void *aux UNUSED) {
+	const struct item *i = hash_entry(e, struct item, elem);
+	return hash_bytes(&i->key, sizeof i->key);
+}
+
+static bool item_less(const struct hash_elem *a, const struct hash_elem *b,
+					  void *aux UNUSED) {
+	return hash_entry(a, struct item, elem)->key <
+		   hash_entry(b, struct item, elem)->key;
+}
+
+/* Spreads consecutive indexes over the key space. */
+static uint64_t key_of(size_t i) { return i * 0x9e3779b97f4a7c15ULL; }
+
+static void run(const char *name, bool open, struct item *items) {
+	unsigned long long start, worst, insert, find, miss, delete;
+	struct item probe;
+	struct hash h;
+	size_t i;
+
+	if (!(open ? hash_init_open : hash_init)(&h, item_hash, item_less, NULL))
+		fail("%s: hash init failed", name);
+
+	worst = 0;
+	start = rdtsc();
+	for (i = 0; i < ELEM_CNT; i++) {
+		unsigned long long t = rdtsc();
+		items[i].key = key_of(i);
+		if (hash_insert(&h, &items[i].elem) != NULL)
+			fail("%s: duplicate key %zu", name, i);
+		t = rdtsc() - t;
+		if (t > worst)
+			worst = t;
+	}
+	insert = (rdtsc() - start) / ELEM_CNT;
+
+	start = rdtsc();
+	for (i = 0; i < ELEM_CNT; i++) {
+		probe.key = key_of(i);
+		if (hash_find(&h, &probe.elem) != &items[i].elem)
+			fail("%s: key %zu not found", name, i);
+	}
+	find = (rdtsc() - start) / ELEM_CNT;
+
+	start = rdtsc();
+	for (i = 0; i < ELEM_CNT; i++) {
+		probe.key = key_of(i + ELEM_CNT);
+		if (hash_find(&h, &probe.elem) != NULL)
+			fail("%s: missing key %zu found", name, i);
+	}
+	miss = (rdtsc() - start) / ELEM_CNT;
+
+	start = rdtsc();
+	for (i = 0; i < ELEM_CNT; i++) {
+		probe.key = key_of(i);
+		if (hash_delete(&h, &probe.elem) != &items[i].elem)
+			fail("%s: key %zu not deleted", name, i);
+	}
+	delete = (rdtsc() - start) / ELEM_CNT;
+
+	if (!hash_empty(&h))
+		fail("%s: table not empty", name);
+	hash_destroy(&h, NULL);
+
+	msg("%s: insert %llu (worst %llu), find %llu, miss %llu, "
+		"delete %llu cycles",
+		name, insert, worst, find, miss, delete);
+}
+
+void test_hash_bench(void) {
+	size_t page_cnt = DIV_ROUND_UP(sizeof(struct item) * ELEM_CNT, PGSIZE);
+	struct item *items = palloc_get_multiple(0, page_cnt);
+
+	if (items == NULL)
+		fail("out of memory for %d items", ELEM_CNT);
+	run("chained", false, items);
+	run("open", true, items);
+	palloc_free_multiple(items, page_cnt);
+	pass();
+}
@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+# The cycle counts vary from run to run, so only check that both
+# kinds of table reported their counts.
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+@output = get_core_output ("run", @output);
+foreach my $kind ('chained', 'open') {
+    fail "missing results for $kind table"
+      unless grep (/^\(hash-bench\) $kind: insert \d+ \(worst \d+\), find \d+, miss \d+, delete \d+ cycles$/,
+		   @output);
+}
+fail "missing PASS in output"
+  unless grep ($_ eq '(hash-bench) PASS', @output);
+pass;
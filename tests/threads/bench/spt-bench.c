@@ -0,0 +1,195 @@
+/* Measures the supplemental page table on one million mapped
+   pages, against a supplemental page table built on a chained
+   hash table keyed by virtual address.
+
+   The lookups are the ones the page fault handler makes: in
+   address order, as a sequential scan faults pages in, in
+   scattered order, and for addresses that are not mapped.
+   Reports the average cost of each in TSC cycles. */
+
+#include <hash.h>
+#include <intrinsic.h>
+#include <round.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+#include "vm/vm.h"
+
+#define PAGE_CNT (1024 * 1024)
+
+/* First mapped address.  The pages above it are contiguous, so
+   the misses are taken from right after them. */
+#define BASE ((uint8_t *)0x10000000)
+
+/* Address of the Ith page, in address order. */
+static void *seq_va(size_t i) { return BASE + i * PGSIZE; }
+
+/* Address of the Ith page, scattered over the mapped range.
+   Multiplying by an odd number permutes [0, PAGE_CNT). */
+static void *scattered_va(size_t i) {
+	return seq_va((i * 0x9e3779b1) & (PAGE_CNT - 1));
+}
+
+/* Hash table based supplemental page table entry. */
+struct hspt_entry {
+	struct hash_elem elem;
+	void *va;
+	struct page *page;
+};
+
+static uint64_t hspt_hash(const struct hash_elem *e, void *aux UNUSED) {
+	const struct hspt_entry *h = hash_entry(e, struct hspt_entry, elem);
+	return hash_bytes(&h->va, sizeof h->va);
+}
+
+static bool hspt_less(const struct hash_elem *a, const struct hash_elem *b,
+					  void *aux UNUSED) {
+	return hash_entry(a, struct hspt_entry, elem)->va <
+		   hash_entry(b, struct hspt_entry, elem)->va;
+}
+
+static struct page *hspt_find(struct hash *h, void *va) {
+	struct hspt_entry probe;
+	struct hash_elem *e;
+
+	probe.va = pg_round_down(va);
+	e = hash_find(h, &probe.elem);
+	return e != NULL ? hash_entry(e, struct hspt_entry, elem)->page : NULL;
+}
+
+static void hspt_free(struct hash_elem *e, void *aux UNUSED) {
+	free(hash_entry(e, struct hspt_entry, elem));
+}
+
+/* Lookup timings, in cycles per lookup. */
+struct lookups {
+	unsigned long long seq, scattered, miss;
+};
+
+static void report(const char *name, unsigned long long insert,
+				   const struct lookups *l) {
+	msg("%s: insert %llu, find %llu, scattered %llu, miss %llu cycles", name,
+		insert, l->seq, l->scattered, l->miss);
+}
+
+static void run_radix(struct page **pages, bool bulk) {
+	const char *name = bulk ? "radix bulk" : "radix";
+	struct supplemental_page_table spt;
+	unsigned long long start, insert;
+	struct lookups l;
+	size_t i;
+
+	supplemental_page_table_init(&spt);
+
+	start = rdtsc();
+	if (bulk) {
+		if (!spt_insert_pages(&spt, pages, PAGE_CNT))
+			fail("%s: insert failed", name);
+	} else {
+		for (i = 0; i < PAGE_CNT; i++)
+			if (!spt_insert_page(&spt, pages[i]))
+				fail("%s: insert %zu failed", name, i);
+	}
+	insert = (rdtsc() - start) / PAGE_CNT;
+
+	start = rdtsc();
+	for (i = 0; i < PAGE_CNT; i++)
+		if (spt_find_page(&spt, seq_va(i)) != pages[i])
+			fail("%s: page %zu not found", name, i);
+	l.seq = (rdtsc() - start) / PAGE_CNT;
+
+	start = rdtsc();
+	for (i = 0; i < PAGE_CNT; i++) {
+		void *va = scattered_va(i);
+		struct page *page = spt_find_page(&spt, va);
+		if (page == NULL || page->va != va)
+			fail("%s: page %p not found", name, va);
+	}
+	l.scattered = (rdtsc() - start) / PAGE_CNT;
+
+	start = rdtsc();
+	for (i = 0; i < PAGE_CNT; i++)
+		if (spt_find_page(&spt, seq_va(i + PAGE_CNT)) != NULL)
+			fail("%s: unmapped page %zu found", name, i);
+	l.miss = (rdtsc() - start) / PAGE_CNT;
+
+	if (spt.page_cnt != PAGE_CNT)
+		fail("%s: %zu pages in table", name, spt.page_cnt);
+	if (!bulk)
+		msg("%s: %zu nodes for %d pages", name, spt.node_cnt, PAGE_CNT);
+
+	/* Leave the pages to the caller. */
+	spt_destroy(&spt, NULL);
+	report(name, insert, &l);
+}
+
+static void run_hash(struct page **pages) {
+	unsigned long long start, insert;
+	struct lookups l;
+	struct hash h;
+	size_t i;
+
+	if (!hash_init(&h, hspt_hash, hspt_less, NULL))
+		fail("hash: hash init failed");
+
+	start = rdtsc();
+	for (i = 0; i < PAGE_CNT; i++) {
+		struct hspt_entry *e = malloc(sizeof *e);
+		if (e == NULL)
+			fail("hash: out of memory at page %zu", i);
+		e->va = pages[i]->va;
+		e->page = pages[i];
+		if (hash_insert(&h, &e->elem) != NULL)
+			fail("hash: duplicate page %zu", i);
+	}
+	insert = (rdtsc() - start) / PAGE_CNT;
+
+	start = rdtsc();
+	for (i = 0; i < PAGE_CNT; i++)
+		if (hspt_find(&h, seq_va(i)) != pages[i])
+			fail("hash: page %zu not found", i);
+	l.seq = (rdtsc() - start) / PAGE_CNT;
+
+	start = rdtsc();
+	for (i = 0; i < PAGE_CNT; i++) {
+		void *va = scattered_va(i);
+		struct page *page = hspt_find(&h, va);
+		if (page == NULL || page->va != va)
+			fail("hash: page %p not found", va);
+	}
+	l.scattered = (rdtsc() - start) / PAGE_CNT;
+
+	start = rdtsc();
+	for (i = 0; i < PAGE_CNT; i++)
+		if (hspt_find(&h, seq_va(i + PAGE_CNT)) != NULL)
+			fail("hash: unmapped page %zu found", i);
+	l.miss = (rdtsc() - start) / PAGE_CNT;
+
+	hash_destroy(&h, hspt_free);
+	report("hash", insert, &l);
+}
+
+void test_spt_bench(void) {
+	size_t array_pages = DIV_ROUND_UP(sizeof(struct page *) * PAGE_CNT, PGSIZE);
+	struct page **pages = palloc_get_multiple(0, array_pages);
+	size_t i;
+
+	if (pages == NULL)
+		fail("out of memory for %d page pointers", PAGE_CNT);
+	for (i = 0; i < PAGE_CNT; i++) {
+		pages[i] = vm_new_page(VM_ANON, seq_va(i), true, NULL, NULL);
+		if (pages[i] == NULL)
+			fail("out of memory at page %zu", i);
+	}
+
+	run_radix(pages, false);
+	run_radix(pages, true);
+	run_hash(pages);
+
+	for (i = 0; i < PAGE_CNT; i++)
+		vm_dealloc_page(pages[i]);
+	palloc_free_multiple(pages, array_pages);
+	pass();
+}
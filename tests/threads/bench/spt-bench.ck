@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+# The cycle counts vary from run to run, so only check that every
+# kind of table reported its counts.
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+@output = get_core_output ("run", @output);
+foreach my $kind ('radix', 'radix bulk', 'hash') {
+    fail "missing results for $kind table"
+      unless grep (/^\(spt-bench\) $kind: insert \d+, find \d+, scattered \d+, miss \d+ cycles$/,
+		   @output);
+}
+fail "missing PASS in output"
+  unless grep ($_ eq '(spt-bench) PASS', @output);
+pass;
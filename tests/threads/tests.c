@@ -36,6 +36,11 @@ static const struct test tests[] = {
 	{"mlfqs-nice-2", test_mlfqs_nice_2},
 	{"mlfqs-nice-10", test_mlfqs_nice_10},
 	{"mlfqs-block", test_mlfqs_block},
+	{"bitmap-bench", test_bitmap_bench},
+	{"hash-bench", test_hash_bench},
+#ifdef VM
+	{"spt-bench", test_spt_bench},
+#endif
 };
 
 static const char *test_name;
@@ -0,0 +1,30 @@
+/* Child process run by spawn-fd.
+
+   Its first argument is a descriptor that spawn() gave it for
+   "sample.txt", 10 bytes in, and its second one that its parent
+   has open but did not give it. */
+
+#include <stdlib.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+
+int main(int argc, char *argv[]) {
+	char buf[sizeof sample];
+	int given, withheld, rest = sizeof sample - 1 - 10;
+
+	test_name = "child-spawn";
+	if (argc != 3)
+		fail("bad command-line arguments");
+	given = atoi(argv[1]);
+	withheld = atoi(argv[2]);
+
+	if (read(given, buf, rest) != rest || memcmp(buf, sample + 10, rest))
+		fail("fd %d does not read on from offset 10", given);
+	msg("fd %d reads on from where the parent was", given);
+	if (filesize(withheld) != 0)
+		fail("fd %d was inherited", withheld);
+	msg("fd %d is not open", withheld);
+	return 81;
+}
@@ -0,0 +1,35 @@
+/* Runs a copy of child-simple, then overwrites the ELF magic of
+   the copy and checks that running it fails, and puts the magic
+   back and checks that it runs again: the kernel must not keep
+   using the layout it read from the executable the first time. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static char buf[4096];
+
+void test_main(void) {
+	int src, dst, size, n, ofs;
+
+	CHECK((src = open("child-simple")) > 1, "open \"child-simple\"");
+	size = filesize(src);
+	CHECK(create("child-copy", size), "create \"child-copy\"");
+	CHECK((dst = open("child-copy")) > 1, "open \"child-copy\"");
+	for (ofs = 0; ofs < size; ofs += n) {
+		n = read(src, buf, sizeof buf);
+		if (n <= 0 || write(dst, buf, n) != n)
+			fail("copy failed at offset %d", ofs);
+	}
+	msg("copied \"child-simple\" to \"child-copy\"");
+
+	msg("wait(spawn(\"child-copy\")) = %d", wait(spawn("child-copy", NULL, 0)));
+
+	seek(dst, 0);
+	CHECK(write(dst, "X", 1) == 1, "overwrite the ELF magic");
+	CHECK(spawn("child-copy", NULL, 0) == PID_ERROR, "spawn fails");
+
+	seek(dst, 0);
+	CHECK(write(dst, "\177", 1) == 1, "put it back");
+	msg("wait(spawn(\"child-copy\")) = %d", wait(spawn("child-copy", NULL, 0)));
+}
@@ -0,0 +1,24 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(exec-rewrite) begin
+(exec-rewrite) open "child-simple"
+(exec-rewrite) create "child-copy"
+(exec-rewrite) open "child-copy"
+(exec-rewrite) copied "child-simple" to "child-copy"
+(child-simple) run
+child-copy: exit(81)
+(exec-rewrite) wait(spawn("child-copy")) = 81
+(exec-rewrite) overwrite the ELF magic
+load: child-copy: error loading executable
+(exec-rewrite) spawn fails
+(exec-rewrite) put it back
+(child-simple) run
+child-copy: exit(81)
+(exec-rewrite) wait(spawn("child-copy")) = 81
+(exec-rewrite) end
+exec-rewrite: exit(0)
+EOF
+pass;
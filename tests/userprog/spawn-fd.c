@@ -0,0 +1,31 @@
+/* Starts a child with spawn(), giving it the console and one of
+   two descriptors for "sample.txt" under a number of its own.
+   The child reads on from where the parent had got to, and
+   checks that the other descriptor was not inherited.  Then
+   checks that spawn() fails for a missing program and for a
+   descriptor that is not open. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void test_main(void) {
+	struct spawn_action actions[2];
+	char buf[10], cmd[32];
+	int given, withheld;
+
+	CHECK((given = open("sample.txt")) > 1, "open \"sample.txt\"");
+	CHECK((withheld = open("sample.txt")) > 1, "open \"sample.txt\" again");
+	CHECK(read(given, buf, sizeof buf) == sizeof buf, "read first 10 bytes");
+
+	actions[0] = (struct spawn_action){STDOUT_FILENO, STDOUT_FILENO};
+	actions[1] = (struct spawn_action){given, 5};
+	snprintf(cmd, sizeof cmd, "child-spawn 5 %d", withheld);
+	msg("wait(spawn()) = %d", wait(spawn(cmd, actions, 2)));
+	CHECK(tell(given) == sizeof buf, "parent's position unchanged");
+
+	CHECK(spawn("no-such-file", NULL, 0) == PID_ERROR, "spawn missing file");
+	actions[1].parent_fd = 100;
+	CHECK(spawn(cmd, actions, 2) == PID_ERROR, "spawn with a closed fd");
+}
@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(spawn-fd) begin
+(spawn-fd) open "sample.txt"
+(spawn-fd) open "sample.txt" again
+(spawn-fd) read first 10 bytes
+(child-spawn) fd 5 reads on from where the parent was
+(child-spawn) fd 3 is not open
+child-spawn: exit(81)
+(spawn-fd) wait(spawn()) = 81
+(spawn-fd) parent's position unchanged
+load: no-such-file: open failed
+(spawn-fd) spawn missing file
+(spawn-fd) spawn with a closed fd
+(spawn-fd) end
+spawn-fd: exit(0)
+EOF
+pass;
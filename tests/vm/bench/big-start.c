@@ -0,0 +1,29 @@
+/* Starts up a large executable.
+
+   The program carries 1 MB of read-only data and reads all of it
+   in order, the way a large program's code is touched as it
+   starts.  Every page comes from the executable on its first
+   fault, so fault-around decides how many faults that takes.
+
+   The transcript is deterministic.  Compare the "Fault-around:"
+   line that the kernel prints at power off. */
+
+#include <stdint.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define DATA_SIZE (1024 * 1024)
+
+/* Initialized, so that it is part of the executable file rather
+   than zero-filled at load time. */
+static const uint8_t data[DATA_SIZE] = {1, 2, 3};
+
+void test_main(void) {
+	volatile const uint8_t *p = data;
+	unsigned sum = 0;
+	size_t i;
+
+	for (i = 0; i < DATA_SIZE; i += 64)
+		sum += p[i];
+	CHECK(sum == 1, "read %d kB of the executable", DATA_SIZE / 1024);
+}
@@ -0,0 +1,10 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(big-start) begin
+(big-start) read 1024 kB of the executable
+(big-start) end
+EOF
+pass;
@@ -0,0 +1,4 @@
+/* Child process of spawn-bench, which does nothing, so that only
+   starting it and waiting for it is timed. */
+
+int main(void) { return 0; }
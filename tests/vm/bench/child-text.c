@@ -0,0 +1,58 @@
+/* Child process of text-share.
+   Reads its 256 kB of read-only data, reports how long that and
+   its own exec took, then runs the next copy and waits for it. */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/vm/bench/text-share.h"
+
+#define DATA_SIZE (256 * 1024)
+
+/* Initialized, so that it is part of the executable file rather
+   than zero-filled at load time. */
+static const uint8_t data[DATA_SIZE] = {1, 2, 3};
+
+/* Parses the decimal number S. */
+static uint64_t parse_u64(const char *s) {
+	uint64_t n = 0;
+
+	for (; *s >= '0' && *s <= '9'; s++)
+		n = n * 10 + (*s - '0');
+	return n;
+}
+
+int main(int argc, char *argv[]) {
+	uint64_t now = rdtsc();
+	volatile const uint8_t *p = data;
+	uint64_t exec_cycles, start, read_cycles;
+	unsigned sum = 0;
+	int number;
+	pid_t child;
+	size_t i;
+
+	test_name = "child-text";
+	if (argc != 3)
+		fail("usage: child-text NUMBER TSC");
+	number = atoi(argv[1]);
+	exec_cycles = now - parse_u64(argv[2]);
+
+	start = rdtsc();
+	for (i = 0; i < DATA_SIZE; i += 64)
+		sum += p[i];
+	read_cycles = rdtsc() - start;
+	if (sum != 1)
+		fail("copy %d: bad data", number);
+	msg("copy %d: exec %llu cycles, read %llu cycles", number,
+		(unsigned long long)exec_cycles, (unsigned long long)read_cycles);
+
+	if (number + 1 < COPY_CNT) {
+		child = fork("child-text");
+		if (child == 0)
+			start_copy(number + 1);
+		if (child == PID_ERROR || wait(child) != 0)
+			fail("copy %d: running copy %d failed", number, number + 1);
+	}
+	return 0;
+}
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+# The numbers vary from run to run, so only check that they were
+# reported.
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+@output = get_core_output ("run", @output);
+fail "missing begin in output" unless grep ($_ eq '(exec-bench-nocache) begin', @output);
+fail "missing runs in output"
+  unless grep (/^\(exec-bench-nocache\) 1000 runs: \d+ cycles, \d+ disk reads each$/, @output);
+fail "missing end in output" unless grep ($_ eq '(exec-bench-nocache) end', @output);
+pass;
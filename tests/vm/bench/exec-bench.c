@@ -0,0 +1,38 @@
+/* Runs child-nop, which exits at once, EXEC_CNT times over with
+   spawn(), waiting for each, and reports the TSC cycles and disk
+   reads that a run took on average.
+
+   Built twice: exec-bench runs with the exec cache, so that only
+   the first run reads the ELF headers of child-nop, and
+   exec-bench-nocache with -noexeccache, so that every run reads
+   them.  The "Exec:" line that the kernel prints at power off
+   counts the runs that found the layout cached. */
+
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define EXEC_CNT 1000
+
+static inline uint64_t rdtsc(void) {
+	uint32_t lo, hi;
+	asm volatile("rdtsc" : "=a"(lo), "=d"(hi));
+	return ((uint64_t)hi << 32) | lo;
+}
+
+void test_main(void) {
+	long long reads = get_fs_disk_read_cnt();
+	uint64_t start = rdtsc();
+	int i;
+
+	for (i = 0; i < EXEC_CNT; i++) {
+		pid_t child = spawn("child-nop", NULL, 0);
+
+		if (child == PID_ERROR || wait(child) != 0)
+			fail("run %d of child-nop failed", i);
+	}
+	msg("%d runs: %llu cycles, %lld disk reads each", EXEC_CNT,
+		(unsigned long long)((rdtsc() - start) / EXEC_CNT),
+		(get_fs_disk_read_cnt() - reads) / EXEC_CNT);
+}
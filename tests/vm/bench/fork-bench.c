@@ -0,0 +1,82 @@
+/* Measures fork as the parent's resident set grows.
+
+   For each size, the parent writes every page of the first SIZE
+   bytes of a buffer and forks.  The parent reports how long fork
+   took to return, in TSC cycles.  The child reports how many of
+   those pages it shares with the parent, by physical address,
+   then writes every other one and reports again, which is the
+   memory that fork-then-write really costs.
+
+   With copy-on-write, fork latency should grow far slower than
+   the resident set, and the child should share every page until
+   it writes.  The "COW:" line that the kernel prints at power off
+   gives the totals. */
+
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define MAX_SIZE (4 * 1024 * 1024)
+#define MAX_PAGES (MAX_SIZE / PAGE_SIZE)
+
+static char buf[MAX_SIZE];
+static void *parent_pa[MAX_PAGES];
+
+static inline uint64_t rdtsc(void) {
+	uint32_t lo, hi;
+	asm volatile("rdtsc" : "=a"(lo), "=d"(hi));
+	return ((uint64_t)hi << 32) | lo;
+}
+
+/* Returns the number of the first PAGE_CNT pages of BUF that are
+   at the physical address the parent saw. */
+static size_t count_shared(size_t page_cnt) {
+	size_t shared = 0;
+	size_t i;
+
+	for (i = 0; i < page_cnt; i++)
+		if (get_phys_addr(buf + i * PAGE_SIZE) == parent_pa[i])
+			shared++;
+	return shared;
+}
+
+static void run(size_t size) {
+	size_t page_cnt = size / PAGE_SIZE;
+	uint64_t start, cycles;
+	size_t i;
+	pid_t child;
+
+	for (i = 0; i < page_cnt; i++) {
+		buf[i * PAGE_SIZE] = (char)(i + size);
+		parent_pa[i] = get_phys_addr(buf + i * PAGE_SIZE);
+	}
+
+	start = rdtsc();
+	child = fork("forked");
+	cycles = rdtsc() - start;
+	if (child == 0) {
+		size_t shared = count_shared(page_cnt);
+
+		for (i = 0; i < page_cnt; i += 2)
+			buf[i * PAGE_SIZE]++;
+		msg("%zu kB: child shares %zu of %zu pages, %zu after writing half",
+			size / 1024, shared, page_cnt, count_shared(page_cnt));
+		exit(0);
+	}
+	CHECK(child != PID_ERROR, "fork for %zu kB", size / 1024);
+	CHECK(wait(child) == 0, "wait for child");
+	msg("%zu kB: fork %llu cycles", size / 1024, (unsigned long long)cycles);
+
+	for (i = 0; i < page_cnt; i++)
+		if (buf[i * PAGE_SIZE] != (char)(i + size))
+			fail("%zu kB: page %zu changed by the child", size / 1024, i);
+}
+
+void test_main(void) {
+	size_t size;
+
+	for (size = 256 * 1024; size <= MAX_SIZE; size *= 2)
+		run(size);
+}
@@ -0,0 +1,25 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+# The cycle counts vary from run to run, and so may the number of
+# shared pages if some of them are evicted, so only check that every
+# size reported both.
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+@output = get_core_output ("run", @output);
+fail "missing begin in output" unless grep ($_ eq '(fork-bench) begin', @output);
+for (my $kb = 256; $kb <= 4096; $kb *= 2) {
+    my $pages = $kb / 4;
+    fail "missing child result for $kb kB"
+      unless grep (/^\(fork-bench\) $kb kB: child shares \d+ of $pages pages, \d+ after writing half$/,
+		   @output);
+    fail "missing fork latency for $kb kB"
+      unless grep (/^\(fork-bench\) $kb kB: fork \d+ cycles$/, @output);
+}
+fail "missing end in output" unless grep ($_ eq '(fork-bench) end', @output);
+pass;
@@ -0,0 +1,89 @@
+/* Same-page merging on a fork workload.
+
+   The parent forks CHILD_CNT children, which each build the same
+   table in memory of their own, along with a buffer that they
+   clear by writing zeros to it, and then wait for the same-page
+   scanner to merge those pages.  Each child reports how many of
+   its pages ended up shared, then writes to every other page of
+   the table, which copies them out again, and checks that it
+   reads back what it wrote.
+
+   Runs with -o ksm=N.  The "KSM:" line that the kernel prints at
+   power off gives the number of pages merged and the most frames
+   that merging saved at once. */
+
+#include <stdint.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define CHILD_CNT 16
+#define TABLE_PAGES 32
+#define ZERO_PAGES 16
+#define MERGE_PAGES (TABLE_PAGES + ZERO_PAGES)
+
+/* How long a child waits for its pages to be merged, in TSC cycles. */
+#define MERGE_TIMEOUT 20000000000ULL
+
+static uint32_t table[TABLE_PAGES * PAGE_SIZE / sizeof(uint32_t)]
+	__attribute__((aligned(PAGE_SIZE)));
+static char zeros[ZERO_PAGES * PAGE_SIZE] __attribute__((aligned(PAGE_SIZE)));
+
+static inline uint64_t rdtsc(void) {
+	uint32_t lo, hi;
+	asm volatile("rdtsc" : "=a"(lo), "=d"(hi));
+	return ((uint64_t)hi << 32) | lo;
+}
+
+/* Returns entry I of the table, as written the first time. */
+static uint32_t entry(size_t i) {
+	return (uint32_t)(i * 2654435761u);
+}
+
+static void run_child(int id) {
+	struct memstat before, after;
+	uint64_t start;
+	size_t i;
+
+	memstat(&before);
+	for (i = 0; i < sizeof table / sizeof *table; i++)
+		table[i] = entry(i);
+	memset(zeros, 0, sizeof zeros);
+
+	start = rdtsc();
+	do
+		memstat(&after);
+	while (after.rss_shared - before.rss_shared < MERGE_PAGES &&
+		   rdtsc() - start < MERGE_TIMEOUT);
+	msg("child %d: %lld of %d pages shared", id,
+		after.rss_shared - before.rss_shared, MERGE_PAGES);
+
+	for (i = 0; i < TABLE_PAGES; i += 2)
+		table[i * PAGE_SIZE / sizeof *table] = (uint32_t)id;
+	for (i = 0; i < sizeof table / sizeof *table; i++) {
+		uint32_t expected = i % (2 * PAGE_SIZE / sizeof *table) == 0
+								? (uint32_t)id
+								: entry(i);
+
+		if (table[i] != expected)
+			fail("child %d: entry %zu is %u, not %u", id, i, table[i],
+				 expected);
+	}
+	exit(0);
+}
+
+void test_main(void) {
+	pid_t children[CHILD_CNT];
+	int i;
+
+	for (i = 0; i < CHILD_CNT; i++) {
+		children[i] = fork("merger");
+		if (children[i] == 0)
+			run_child(i);
+		CHECK(children[i] != PID_ERROR, "fork child %d", i);
+	}
+	for (i = 0; i < CHILD_CNT; i++)
+		CHECK(wait(children[i]) == 0, "wait for child %d", i);
+}
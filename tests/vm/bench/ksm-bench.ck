@@ -0,0 +1,24 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+# How many pages get merged before a child gives up waiting depends
+# on timing, so only check that every child reported and that the
+# scanner ran.
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+fail "missing KSM statistics in output" unless grep (/^KSM: /, @output);
+
+@output = get_core_output ("run", @output);
+fail "missing begin in output" unless grep ($_ eq '(ksm-bench) begin', @output);
+for (my $i = 0; $i < 16; $i++) {
+    fail "missing result of child $i"
+      unless grep (/^\(ksm-bench\) child $i: \d+ of 48 pages shared$/, @output);
+    fail "missing wait for child $i"
+      unless grep ($_ eq "(ksm-bench) wait for child $i", @output);
+}
+fail "missing end in output" unless grep ($_ eq '(ksm-bench) end', @output);
+pass;
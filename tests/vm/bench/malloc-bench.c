@@ -0,0 +1,180 @@
+/* Compares malloc() with the simplest allocator there is, one
+   that moves the break for every block and never frees, on four
+   patterns of use:
+
+   - small churn: many blocks of 16 to 128 bytes, each freed soon
+     after it is allocated;
+
+   - random sizes: blocks of 8 bytes to 16 kB, freed in random
+     order;
+
+   - large blocks: blocks of 64 to 256 kB, with a byte written to
+     each page;
+
+   - realloc growth: buffers grown 64 bytes at a time up to 8 kB,
+     taking turns.
+
+   Each pattern runs in a child of its own, so that it starts with
+   an empty heap, and both allocators see the same random
+   sequence.  The child reports the TSC cycles per operation, how
+   far the heap grew, and the anonymous pages it had resident at
+   the end, as memstat() counts them. */
+
+#include <malloc.h>
+#include <mman.h>
+#include <random.h>
+#include <stdint.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define SLOT_CNT 256
+
+static inline uint64_t rdtsc(void) {
+	uint32_t lo, hi;
+	asm volatile("rdtsc" : "=a"(lo), "=d"(hi));
+	return ((uint64_t)hi << 32) | lo;
+}
+
+/* An allocator under test. */
+struct allocator {
+	const char *name;
+	void *(*alloc)(size_t);
+	void *(*resize)(void *, size_t);
+	void (*release)(void *);
+};
+
+/* The bump allocator.  Each block has the size of its caller's
+   part in front of it, for bump_resize(). */
+static void *bump_alloc(size_t n) {
+	size_t *p = sbrk((n + sizeof *p + 15) & ~(size_t)15);
+
+	if (p == (void *)-1)
+		return NULL;
+	*p = n;
+	return p + 1;
+}
+
+static void *bump_resize(void *ptr, size_t n) {
+	size_t old = ptr != NULL ? ((size_t *)ptr)[-1] : 0;
+	void *p = bump_alloc(n);
+
+	if (p != NULL && ptr != NULL)
+		memcpy(p, ptr, old < n ? old : n);
+	return p;
+}
+
+static void bump_release(void *ptr UNUSED) {}
+
+static const struct allocator allocators[] = {
+	{"malloc", malloc, realloc, free},
+	{"bump", bump_alloc, bump_resize, bump_release},
+};
+
+static void *slots[SLOT_CNT];
+
+/* Allocates a block of N bytes with A and writes its first
+   byte. */
+static void *get(const struct allocator *a, size_t n) {
+	char *p = a->alloc(n);
+
+	if (p == NULL)
+		fail("%s: allocation of %zu bytes failed", a->name, n);
+	p[0] = 1;
+	return p;
+}
+
+/* Frees and reallocates slots at random, with sizes from MIN to
+   MAX bytes.  Returns the number of operations. */
+static int churn(const struct allocator *a, size_t min, size_t max,
+				 size_t slot_cnt, int round_cnt, bool touch) {
+	int round;
+	size_t i;
+
+	for (round = 0; round < round_cnt; round++) {
+		void **slot = &slots[random_ulong() % slot_cnt];
+		size_t n = min + random_ulong() % (max - min + 1);
+
+		a->release(*slot);
+		*slot = get(a, n);
+		if (touch)
+			for (i = PAGE_SIZE; i < n; i += PAGE_SIZE)
+				((char *)*slot)[i] = 1;
+	}
+	return round_cnt * 2;
+}
+
+static int small_churn(const struct allocator *a) {
+	return churn(a, 16, 128, SLOT_CNT, 40000, false);
+}
+
+static int random_sizes(const struct allocator *a) {
+	return churn(a, 8, 16 * 1024, SLOT_CNT, 2000, false);
+}
+
+static int large_blocks(const struct allocator *a) {
+	return churn(a, 64 * 1024, 256 * 1024, 16, 48, true);
+}
+
+static int realloc_growth(const struct allocator *a) {
+	size_t size, i;
+	int ops = 0;
+
+	for (size = 64; size <= 8 * 1024; size += 64)
+		for (i = 0; i < 8; i++) {
+			char *p = a->resize(slots[i], size);
+
+			if (p == NULL)
+				fail("%s: realloc to %zu bytes failed", a->name, size);
+			p[size - 1] = 1;
+			slots[i] = p;
+			ops++;
+		}
+	return ops;
+}
+
+struct pattern {
+	const char *name;
+	int (*run)(const struct allocator *);
+};
+
+static const struct pattern patterns[] = {
+	{"small churn", small_churn},
+	{"random sizes", random_sizes},
+	{"large blocks", large_blocks},
+	{"realloc growth", realloc_growth},
+};
+
+/* Runs pattern P with allocator A in a child process. */
+static void run(const struct pattern *p, const struct allocator *a) {
+	pid_t child = fork(a->name);
+
+	if (child == 0) {
+		char *start = sbrk(0);
+		struct memstat st;
+		uint64_t cycles;
+		int ops;
+
+		random_init(0);
+		cycles = rdtsc();
+		ops = p->run(a);
+		cycles = rdtsc() - cycles;
+		memstat(&st);
+		msg("%s, %s: %llu cycles/op, heap %zu kB, %lld pages resident",
+			p->name, a->name, (unsigned long long)(cycles / ops),
+			(size_t)((char *)sbrk(0) - start) / 1024, st.rss_anon);
+		exit(0);
+	}
+	if (child == PID_ERROR || wait(child) != 0)
+		fail("%s, %s: child failed", p->name, a->name);
+}
+
+void test_main(void) {
+	size_t i, j;
+
+	for (i = 0; i < sizeof patterns / sizeof *patterns; i++)
+		for (j = 0; j < sizeof allocators / sizeof *allocators; j++)
+			run(&patterns[i], &allocators[j]);
+}
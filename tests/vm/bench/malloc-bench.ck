@@ -0,0 +1,24 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+# The numbers vary from run to run, so only check that every
+# pattern reported them for both allocators.
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+@output = get_core_output ("run", @output);
+fail "missing begin in output" unless grep ($_ eq '(malloc-bench) begin', @output);
+foreach my $pattern ('small churn', 'random sizes', 'large blocks',
+		     'realloc growth') {
+    foreach my $allocator ('malloc', 'bump') {
+	my ($re) = qr/\Q$pattern\E, $allocator: \d+ cycles\/op, heap \d+ kB, \d+ pages resident/;
+	fail "missing \"$pattern, $allocator\" in output"
+	  unless grep (/^\(malloc-bench\) $re$/, @output);
+    }
+}
+fail "missing end in output" unless grep ($_ eq '(malloc-bench) end', @output);
+pass;
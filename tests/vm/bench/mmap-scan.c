@@ -0,0 +1,61 @@
+/* Reads a memory-mapped file, in order and then scattered.
+
+   Maps large.txt and compares each page of the mapping with the
+   same page read through read(), first from start to end, then in
+   an order that jumps around the file.  Fault-around should take
+   most of the faults out of the sequential pass and back off in
+   the scattered one.
+
+   The transcript is deterministic.  Compare the "Fault-around:"
+   line that the kernel prints at power off. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+
+/* Multiplier that visits the pages in scattered order.  It must
+   share no factor with the number of pages. */
+#define STRIDE 97
+
+static char *map = (char *)0x10000000;
+static char page[PAGE_SIZE];
+
+/* Checks page I of the mapping against the file open as HANDLE,
+   which is SIZE bytes long. */
+static void check_page(int handle, size_t size, size_t i) {
+	size_t ofs = i * PAGE_SIZE;
+	size_t len = size - ofs < PAGE_SIZE ? size - ofs : PAGE_SIZE;
+
+	seek(handle, ofs);
+	if ((size_t)read(handle, page, len) != len)
+		fail("read of page %zu failed", i);
+	if (memcmp(map + ofs, page, len))
+		fail("page %zu of the mapping differs from the file", i);
+}
+
+void test_main(void) {
+	size_t size, page_cnt, i;
+	int handle;
+
+	CHECK((handle = open("large.txt")) > 1, "open \"large.txt\"");
+	size = filesize(handle);
+	page_cnt = (size + PAGE_SIZE - 1) / PAGE_SIZE;
+	CHECK(mmap(map, size, 0, handle, 0) != MAP_FAILED, "mmap \"large.txt\"");
+
+	for (i = 0; i < page_cnt; i++)
+		check_page(handle, size, i);
+	msg("sequential pass");
+
+	munmap(map);
+	CHECK(mmap(map, size, 0, handle, 0) != MAP_FAILED,
+		  "mmap \"large.txt\" again");
+	for (i = 0; i < page_cnt; i++)
+		check_page(handle, size, i * STRIDE % page_cnt);
+	msg("scattered pass");
+
+	munmap(map);
+	close(handle);
+}
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(mmap-scan) begin
+(mmap-scan) open "large.txt"
+(mmap-scan) mmap "large.txt"
+(mmap-scan) sequential pass
+(mmap-scan) mmap "large.txt" again
+(mmap-scan) scattered pass
+(mmap-scan) end
+EOF
+pass;
@@ -0,0 +1,24 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+# The cycle count varies from run to run, so only check that the
+# scan reported one.
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+@output = get_core_output ("run", @output);
+foreach my $line ('(mmap-stream-seq) begin',
+		  '(mmap-stream-seq) open "large.txt"',
+		  '(mmap-stream-seq) mmap "large.txt"',
+		  '(mmap-stream-seq) madvise sequential',
+		  '(mmap-stream-seq) compare mapping against file',
+		  '(mmap-stream-seq) end') {
+    fail "missing \"$line\" in output" unless grep ($_ eq $line, @output);
+}
+fail "missing scan time"
+  unless grep (/^\(mmap-stream-seq\) scan: \d+ cycles$/, @output);
+pass;
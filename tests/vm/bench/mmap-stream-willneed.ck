@@ -0,0 +1,25 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+# The cycle count varies from run to run, so only check that the
+# scan reported one.
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+@output = get_core_output ("run", @output);
+foreach my $line ('(mmap-stream-willneed) begin',
+		  '(mmap-stream-willneed) open "large.txt"',
+		  '(mmap-stream-willneed) mmap "large.txt"',
+		  '(mmap-stream-willneed) madvise sequential',
+		  '(mmap-stream-willneed) madvise willneed',
+		  '(mmap-stream-willneed) compare mapping against file',
+		  '(mmap-stream-willneed) end') {
+    fail "missing \"$line\" in output" unless grep ($_ eq $line, @output);
+}
+fail "missing scan time"
+  unless grep (/^\(mmap-stream-willneed\) scan: \d+ cycles$/, @output);
+pass;
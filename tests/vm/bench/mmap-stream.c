@@ -0,0 +1,67 @@
+/* Streams through a memory-mapped file once, the way a program
+   that processes a file front to back does.
+
+   Built four times, and the name it runs under picks how the
+   file is mapped:
+
+   - mmap-stream maps it plainly and leaves the rest to
+     fault-around.
+
+   - mmap-stream-seq advises MADV_SEQUENTIAL first.
+
+   - mmap-stream-willneed advises MADV_SEQUENTIAL and then
+     MADV_WILLNEED for the whole file before reading it.
+
+   - mmap-stream-populate maps it with MAP_POPULATE.
+
+   Each reports how long the scan took, in TSC cycles.  Compare
+   the "VM:" and "Fault-around:" lines that the kernel prints at
+   power off for the number of faults the scan took. */
+
+#include <stdint.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define MAP ((char *)0x10000000)
+
+static char buf[4096];
+
+static inline uint64_t rdtsc(void) {
+	uint32_t lo, hi;
+	asm volatile("rdtsc" : "=a"(lo), "=d"(hi));
+	return ((uint64_t)hi << 32) | lo;
+}
+
+void test_main(void) {
+	unsigned expected = 0, sum = 0;
+	int flags = 0, handle, n;
+	uint64_t start;
+	size_t size, i;
+
+	CHECK((handle = open("large.txt")) > 1, "open \"large.txt\"");
+	size = filesize(handle);
+	while ((n = read(handle, buf, sizeof buf)) > 0)
+		for (i = 0; i < (size_t)n; i++)
+			expected += (unsigned char)buf[i];
+
+	if (!strcmp(test_name, "mmap-stream-populate"))
+		flags = MAP_POPULATE;
+	start = rdtsc();
+	CHECK(mmap(MAP, size, flags, handle, 0) != MAP_FAILED,
+		  "mmap \"large.txt\"");
+	if (!strcmp(test_name, "mmap-stream-seq") ||
+		!strcmp(test_name, "mmap-stream-willneed"))
+		CHECK(madvise(MAP, size, MADV_SEQUENTIAL) == 0, "madvise sequential");
+	if (!strcmp(test_name, "mmap-stream-willneed"))
+		CHECK(madvise(MAP, size, MADV_WILLNEED) == 0, "madvise willneed");
+
+	for (i = 0; i < size; i++)
+		sum += (unsigned char)MAP[i];
+	msg("scan: %llu cycles", (unsigned long long)(rdtsc() - start));
+	CHECK(sum == expected, "compare mapping against file");
+
+	munmap(MAP);
+	close(handle);
+}
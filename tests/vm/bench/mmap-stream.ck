@@ -0,0 +1,23 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+# The cycle count varies from run to run, so only check that the
+# scan reported one.
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+@output = get_core_output ("run", @output);
+foreach my $line ('(mmap-stream) begin',
+		  '(mmap-stream) open "large.txt"',
+		  '(mmap-stream) mmap "large.txt"',
+		  '(mmap-stream) compare mapping against file',
+		  '(mmap-stream) end') {
+    fail "missing \"$line\" in output" unless grep ($_ eq $line, @output);
+}
+fail "missing scan time"
+  unless grep (/^\(mmap-stream\) scan: \d+ cycles$/, @output);
+pass;
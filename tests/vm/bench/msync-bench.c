@@ -0,0 +1,145 @@
+/* Measures how long unmapping a 4 MB mapping that was written
+   all over takes, and how long exiting with one does.
+
+   Each round writes every page of the mapping, then unmaps it or
+   exits:
+
+   - right away, so that every page is written back on the spot;
+
+   - after msync(MS_SYNC), which reports its own time;
+
+   - after the writeback daemon has written the mapping back,
+     which the program finds out by reading the file.
+
+   Unmapping is timed around munmap().  Exiting is timed from
+   just before the child's exit to the return of the parent's
+   wait(), with the child handing its starting time over through
+   a file.  All times are in TSC cycles.  The "Writeback:" line
+   that the kernel prints at power off tells how the pages were
+   written. */
+
+#include <stdint.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define MAP_SIZE (4 * 1024 * 1024)
+#define PAGE_CNT (MAP_SIZE / PAGE_SIZE)
+#define MAP ((char *)0x10000000)
+
+enum mode { RIGHT_AWAY, MSYNC, DAEMON };
+
+static int handle;
+
+static inline uint64_t rdtsc(void) {
+	uint32_t lo, hi;
+	asm volatile("rdtsc" : "=a"(lo), "=d"(hi));
+	return ((uint64_t)hi << 32) | lo;
+}
+
+/* Returns the byte at offset OFS of the file. */
+static char file_byte(size_t ofs) {
+	char c;
+
+	seek(handle, ofs);
+	if (read(handle, &c, 1) != 1)
+		fail("read at offset %zu failed", ofs);
+	return c;
+}
+
+/* Maps the file and writes ROUND on every page. */
+static void map_and_dirty(int round) {
+	size_t i;
+
+	if (mmap(MAP, MAP_SIZE, 1, handle, 0) == MAP_FAILED)
+		fail("mmap for round %d failed", round);
+	for (i = 0; i < PAGE_CNT; i++)
+		MAP[i * PAGE_SIZE] = (char)round;
+}
+
+/* Waits until the writeback daemon has written the last page of
+   ROUND, which it writes last. */
+static void wait_for_daemon(int round) {
+	while (file_byte(MAP_SIZE - PAGE_SIZE) != (char)round)
+		continue;
+}
+
+/* Checks that the file holds ROUND on every page. */
+static void check_written(int round) {
+	size_t i;
+
+	for (i = 0; i < PAGE_CNT; i++)
+		if (file_byte(i * PAGE_SIZE) != (char)round)
+			fail("round %d: page %zu was not written back", round, i);
+}
+
+static void unmap_round(int round, enum mode mode) {
+	uint64_t start, msync_cycles = 0, munmap_cycles;
+
+	map_and_dirty(round);
+	if (mode == MSYNC) {
+		start = rdtsc();
+		CHECK(msync(MAP, MAP_SIZE, MS_SYNC) == 0, "msync");
+		msync_cycles = rdtsc() - start;
+	} else if (mode == DAEMON)
+		wait_for_daemon(round);
+
+	start = rdtsc();
+	munmap(MAP);
+	munmap_cycles = rdtsc() - start;
+	check_written(round);
+
+	if (mode == RIGHT_AWAY)
+		msg("munmap right away: %llu cycles",
+			(unsigned long long)munmap_cycles);
+	else if (mode == MSYNC)
+		msg("msync: %llu cycles, then munmap: %llu cycles",
+			(unsigned long long)msync_cycles,
+			(unsigned long long)munmap_cycles);
+	else
+		msg("munmap after writeback: %llu cycles",
+			(unsigned long long)munmap_cycles);
+}
+
+static void exit_round(int round, enum mode mode) {
+	uint64_t start;
+	pid_t child;
+	int tsc;
+
+	CHECK(create("tsc", sizeof start), "create \"tsc\"");
+	child = fork("dirtier");
+	if (child == 0) {
+		map_and_dirty(round);
+		if (mode == DAEMON)
+			wait_for_daemon(round);
+		tsc = open("tsc");
+		start = rdtsc();
+		write(tsc, &start, sizeof start);
+		exit(0);
+	}
+	CHECK(child != PID_ERROR, "fork");
+	CHECK(wait(child) == 0, "wait");
+	tsc = open("tsc");
+	if (read(tsc, &start, sizeof start) != sizeof start)
+		fail("read of \"tsc\" failed");
+	msg("exit %s: %llu cycles",
+		mode == DAEMON ? "after writeback" : "right away",
+		(unsigned long long)(rdtsc() - start));
+	close(tsc);
+	CHECK(remove("tsc"), "remove \"tsc\"");
+	check_written(round);
+}
+
+void test_main(void) {
+	CHECK(create("dirty", MAP_SIZE), "create \"dirty\"");
+	CHECK((handle = open("dirty")) > 1, "open \"dirty\"");
+
+	unmap_round(1, RIGHT_AWAY);
+	unmap_round(2, MSYNC);
+	unmap_round(3, DAEMON);
+	exit_round(4, RIGHT_AWAY);
+	exit_round(5, DAEMON);
+	close(handle);
+}
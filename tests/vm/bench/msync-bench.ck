@@ -0,0 +1,24 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+# The cycle counts vary from run to run, so only check that every
+# round reported them.
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+@output = get_core_output ("run", @output);
+fail "missing begin in output" unless grep ($_ eq '(msync-bench) begin', @output);
+foreach my $re (qr/munmap right away: \d+ cycles/,
+		qr/msync: \d+ cycles, then munmap: \d+ cycles/,
+		qr/munmap after writeback: \d+ cycles/,
+		qr/exit right away: \d+ cycles/,
+		qr/exit after writeback: \d+ cycles/) {
+    fail "missing \"$re\" in output"
+      unless grep (/^\(msync-bench\) $re$/, @output);
+}
+fail "missing end in output" unless grep ($_ eq '(msync-bench) end', @output);
+pass;
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(page-linear-thp) begin
+(page-linear-thp) initialize
+(page-linear-thp) read pass
+(page-linear-thp) read/modify/write pass one
+(page-linear-thp) read/modify/write pass two
+(page-linear-thp) read pass
+(page-linear-thp) end
+EOF
+pass;
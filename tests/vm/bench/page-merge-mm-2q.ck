@@ -0,0 +1,29 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(page-merge-mm-2q) begin
+(page-merge-mm-2q) init
+(page-merge-mm-2q) sort chunk 0
+(page-merge-mm-2q) sort chunk 1
+(page-merge-mm-2q) sort chunk 2
+(page-merge-mm-2q) sort chunk 3
+(page-merge-mm-2q) sort chunk 4
+(page-merge-mm-2q) sort chunk 5
+(page-merge-mm-2q) sort chunk 6
+(page-merge-mm-2q) sort chunk 7
+(page-merge-mm-2q) wait for child 0
+(page-merge-mm-2q) wait for child 1
+(page-merge-mm-2q) wait for child 2
+(page-merge-mm-2q) wait for child 3
+(page-merge-mm-2q) wait for child 4
+(page-merge-mm-2q) wait for child 5
+(page-merge-mm-2q) wait for child 6
+(page-merge-mm-2q) wait for child 7
+(page-merge-mm-2q) merge
+(page-merge-mm-2q) verify
+(page-merge-mm-2q) success, buf_idx=1,048,576
+(page-merge-mm-2q) end
+EOF
+pass;
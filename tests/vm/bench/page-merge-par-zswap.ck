@@ -0,0 +1,29 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(page-merge-par-zswap) begin
+(page-merge-par-zswap) init
+(page-merge-par-zswap) sort chunk 0
+(page-merge-par-zswap) sort chunk 1
+(page-merge-par-zswap) sort chunk 2
+(page-merge-par-zswap) sort chunk 3
+(page-merge-par-zswap) sort chunk 4
+(page-merge-par-zswap) sort chunk 5
+(page-merge-par-zswap) sort chunk 6
+(page-merge-par-zswap) sort chunk 7
+(page-merge-par-zswap) wait for child 0
+(page-merge-par-zswap) wait for child 1
+(page-merge-par-zswap) wait for child 2
+(page-merge-par-zswap) wait for child 3
+(page-merge-par-zswap) wait for child 4
+(page-merge-par-zswap) wait for child 5
+(page-merge-par-zswap) wait for child 6
+(page-merge-par-zswap) wait for child 7
+(page-merge-par-zswap) merge
+(page-merge-par-zswap) verify
+(page-merge-par-zswap) success, buf_idx=1,048,576
+(page-merge-par-zswap) end
+EOF
+pass;
@@ -0,0 +1,22 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+# The hit rate and cycle count depend on the policy and the run, so
+# only check that they were reported.
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+@output = get_core_output ("run", @output);
+fail "missing begin in output" unless grep ($_ eq '(scan-hot-2q) begin', @output);
+foreach my $re (qr/open "large.txt"/,
+		qr/mmap "large.txt"/,
+		qr/hot set: \d+% hits in \d+ rounds, \d+ cycles/) {
+    fail "missing \"$re\" in output"
+      unless grep (/^\(scan-hot-2q\) $re$/, @output);
+}
+fail "missing end in output" unless grep ($_ eq '(scan-hot-2q) end', @output);
+pass;
@@ -0,0 +1,75 @@
+/* A hot set that is reused while a file is read through, which
+   is the access pattern that scan-resistant page replacement is
+   for.
+
+   Each round reads every page of the hot set, HOT_PAGES of
+   anonymous memory, and then every page of large.txt through a
+   mapping.  Together they take more frames than the machine has,
+   but the hot set alone does not.  The clock keeps whatever was
+   used last, so the scan pushes the hot set out every round; 2Q
+   should notice that the hot set comes back and let the scan pass
+   through the in queue.  The test reports how often the hot set
+   was still resident, from the major faults that memstat() counts
+   while it is read, and how long the rounds took in TSC cycles.
+
+   Built twice: scan-hot runs with the clock and scan-hot-2q with
+   -o evict=2q.  The "VM:" line that the kernel prints at power off
+   gives the faults of the whole run. */
+
+#include <mman.h>
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define HOT_PAGES 512
+#define ROUND_CNT 8
+
+static char hot[HOT_PAGES * PAGE_SIZE];
+static char *map = (char *)0x10000000;
+
+static inline uint64_t rdtsc(void) {
+	uint32_t lo, hi;
+	asm volatile("rdtsc" : "=a"(lo), "=d"(hi));
+	return ((uint64_t)hi << 32) | lo;
+}
+
+/* Returns the number of major faults the process took so far. */
+static long long major_faults(void) {
+	struct memstat st;
+
+	if (memstat(&st) != 0)
+		fail("memstat failed");
+	return st.major_faults;
+}
+
+void test_main(void) {
+	long long misses = 0;
+	volatile char sum = 0;
+	uint64_t start;
+	size_t size, i;
+	int handle, round;
+
+	for (i = 0; i < HOT_PAGES; i++)
+		hot[i * PAGE_SIZE] = (char)i;
+	CHECK((handle = open("large.txt")) > 1, "open \"large.txt\"");
+	size = filesize(handle);
+	CHECK(mmap(map, size, 0, handle, 0) != MAP_FAILED, "mmap \"large.txt\"");
+
+	start = rdtsc();
+	for (round = 0; round < ROUND_CNT; round++) {
+		long long before = major_faults();
+
+		for (i = 0; i < HOT_PAGES; i++)
+			if (hot[i * PAGE_SIZE] != (char)i)
+				fail("round %d: hot page %zu changed", round, i);
+		misses += major_faults() - before;
+
+		for (i = 0; i < size; i += PAGE_SIZE)
+			sum += map[i];
+	}
+	msg("hot set: %lld%% hits in %d rounds, %llu cycles",
+		100 - misses * 100 / (HOT_PAGES * ROUND_CNT), ROUND_CNT,
+		(unsigned long long)(rdtsc() - start));
+}
@@ -0,0 +1,84 @@
+/* Compares starting a program with spawn() against fork() and
+   exec(), from a process that has 1 MB of data of its own.
+
+   Each round starts child-nop, which exits at once, waits for it,
+   and then writes its data again.  The rounds report the TSC
+   cycles from starting the child to the return of wait(), and the
+   faults that the parent took when it wrote its data afterwards:
+   fork() shares the data with the child copy-on-write, so the
+   parent takes a fault on every page it writes even though the
+   child threw its copy away in exec(), while spawn() leaves the
+   parent's address space alone. */
+
+#include <mman.h>
+#include <stdint.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define DATA_SIZE (1024 * 1024)
+#define ROUND_CNT 20
+
+static char data[DATA_SIZE];
+
+static inline uint64_t rdtsc(void) {
+	uint32_t lo, hi;
+	asm volatile("rdtsc" : "=a"(lo), "=d"(hi));
+	return ((uint64_t)hi << 32) | lo;
+}
+
+/* Returns the faults the process took so far. */
+static long long faults(void) {
+	struct memstat st;
+
+	memstat(&st);
+	return st.major_faults + st.minor_faults;
+}
+
+static void write_data(int round) {
+	size_t i;
+
+	for (i = 0; i < DATA_SIZE; i += PAGE_SIZE)
+		data[i] = (char)round;
+}
+
+static pid_t start_spawn(void) { return spawn("child-nop", NULL, 0); }
+
+static pid_t start_fork_exec(void) {
+	pid_t child = fork("child-nop");
+
+	if (child == 0) {
+		exec("child-nop");
+		exit(-1);
+	}
+	return child;
+}
+
+static void run(const char *name, pid_t (*start)(void)) {
+	uint64_t cycles = 0;
+	long long fault_cnt = 0, before;
+	int round;
+
+	for (round = 0; round < ROUND_CNT; round++) {
+		uint64_t t = rdtsc();
+		pid_t child = start();
+
+		if (child == PID_ERROR || wait(child) != 0)
+			fail("%s: round %d failed", name, round);
+		cycles += rdtsc() - t;
+
+		before = faults();
+		write_data(round);
+		fault_cnt += faults() - before;
+	}
+	msg("%s: %llu cycles per child, %lld faults after it", name,
+		(unsigned long long)(cycles / ROUND_CNT), fault_cnt / ROUND_CNT);
+}
+
+void test_main(void) {
+	write_data(0);
+	run("spawn", start_spawn);
+	run("fork+exec", start_fork_exec);
+}
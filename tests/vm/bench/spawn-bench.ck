@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+# The numbers vary from run to run, so only check that both ways of
+# starting a child reported them.
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+@output = get_core_output ("run", @output);
+fail "missing begin in output" unless grep ($_ eq '(spawn-bench) begin', @output);
+foreach my $re (qr/spawn: \d+ cycles per child, \d+ faults after it/,
+		qr/fork\+exec: \d+ cycles per child, \d+ faults after it/) {
+    fail "missing \"$re\" in output"
+      unless grep (/^\(spawn-bench\) $re$/, @output);
+}
+fail "missing end in output" unless grep ($_ eq '(spawn-bench) end', @output);
+pass;
@@ -0,0 +1,76 @@
+/* Grows the stack to about 700 kB through deep recursion, in two
+   ways: with small frames, a page taking dozens of calls, and
+   with frames of 8 kB, each call skipping a page.  Each runs in a
+   child of its own, which starts with a stack of one page, and
+   reports how many pages the stack grew by, the page faults that
+   took, and the TSC cycles the recursion took.  Without stack
+   growth ahead of use there would be a fault for every page.
+   The "Stack:" line that the kernel prints at power off sums up
+   the run. */
+
+#include <mman.h>
+#include <stdint.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define STACK_USE (700 * 1024)
+
+static inline uint64_t rdtsc(void) {
+	uint32_t lo, hi;
+	asm volatile("rdtsc" : "=a"(lo), "=d"(hi));
+	return ((uint64_t)hi << 32) | lo;
+}
+
+static uintptr_t top, lowest;
+
+/* Recurses with frames of about SIZE bytes until STACK_USE bytes
+   of stack are in use, writing every frame. */
+#define RECURSE(NAME, SIZE)                              \
+	static int NAME(int depth) {                         \
+		volatile char frame[SIZE];                       \
+		                                                 \
+		frame[0] = frame[SIZE - 1] = (char)depth;        \
+		if (top - (uintptr_t)frame < STACK_USE)          \
+			depth = NAME(depth + 1);                     \
+		else                                             \
+			lowest = (uintptr_t)frame;                   \
+		return depth + frame[0] - frame[SIZE - 1];       \
+	}
+
+RECURSE(recurse_small, 64)
+RECURSE(recurse_large, 8 * 1024)
+
+static long long faults(void) {
+	struct memstat st;
+
+	memstat(&st);
+	return st.major_faults + st.minor_faults;
+}
+
+static void run(const char *name, int (*recurse)(int)) {
+	pid_t child = fork(name);
+
+	if (child == 0) {
+		long long before = faults();
+		uint64_t start = rdtsc();
+		int depth;
+
+		top = (uintptr_t)&depth;
+		depth = recurse(0);
+		start = rdtsc() - start;
+		msg("%s: %d calls, %zu pages of stack, %lld faults, %llu cycles",
+			name, depth, (size_t)(top - lowest) / PAGE_SIZE,
+			faults() - before, (unsigned long long)start);
+		exit(0);
+	}
+	if (child == PID_ERROR || wait(child) != 0)
+		fail("%s: child failed", name);
+}
+
+void test_main(void) {
+	run("small frames", recurse_small);
+	run("large frames", recurse_large);
+}
@@ -0,0 +1,20 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+# The numbers vary from run to run, so only check that both ways of
+# recursing reported them.
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+@output = get_core_output ("run", @output);
+fail "missing begin in output" unless grep ($_ eq '(stack-bench) begin', @output);
+foreach my $name ('small frames', 'large frames') {
+    fail "missing \"$name\" in output"
+      unless grep (/^\(stack-bench\) $name: \d+ calls, \d+ pages of stack, \d+ faults, \d+ cycles$/, @output);
+}
+fail "missing end in output" unless grep ($_ eq '(stack-bench) end', @output);
+pass;
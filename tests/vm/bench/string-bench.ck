@@ -0,0 +1,23 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+# The cycle counts vary from run to run, so only check that every
+# primitive reported a count for every size.
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+@output = get_core_output ("run", @output);
+fail "missing begin in output" unless grep ($_ eq '(string-bench) begin', @output);
+for (my $size = 8; $size <= 65536; $size *= 2) {
+    foreach my $op (qw (memcpy memmove memset memcmp memchr strlen)) {
+	fail "missing $op result for $size bytes"
+	  unless grep (/^\(string-bench\) $op $size bytes: \d+ cycles$/,
+		       @output);
+    }
+}
+fail "missing end in output" unless grep ($_ eq '(string-bench) end', @output);
+pass;
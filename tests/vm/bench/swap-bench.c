@@ -0,0 +1,99 @@
+/* Swap-heavy workloads for measuring page replacement.
+
+   Built three times, and the name it runs under picks the
+   workload:
+
+   - swap-linear writes a buffer larger than the user pool from
+     start to end and reads it back, twice, like page-linear.
+
+   - swap-parallel does the same from CHILD_CNT processes at
+     once, each on a slice of its own copy of the buffer, like
+     page-parallel.
+
+   - swap-sparse writes one byte on every page of the buffer and
+     reads them back, like swap-iter, so that every access is a
+     fault.
+
+   The transcript is deterministic.  Compare the "VM:" line that
+   the kernel prints at power off, which gives the fault rate and
+   the average number of frames the clock looked at per
+   eviction. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define BUF_SIZE (20 * 1024 * 1024)
+#define PAGE_CNT (BUF_SIZE / PAGE_SIZE)
+#define CHILD_CNT 4
+#define PASS_CNT 2
+
+static char buf[BUF_SIZE];
+
+/* Fills SIZE bytes at P with a pattern that depends on SEED,
+   then checks it.  Returns true if the pattern survived. */
+static bool linear(char *p, size_t size, int seed) {
+	size_t i;
+
+	for (i = 0; i < size; i++)
+		p[i] = (char)(i * 7 + seed);
+	for (i = 0; i < size; i++)
+		if (p[i] != (char)(i * 7 + seed))
+			return false;
+	return true;
+}
+
+static void run_linear(void) {
+	int pass;
+
+	for (pass = 0; pass < PASS_CNT; pass++)
+		CHECK(linear(buf, BUF_SIZE, pass), "linear pass %d", pass);
+}
+
+static void run_parallel(void) {
+	size_t slice = BUF_SIZE / CHILD_CNT;
+	pid_t children[CHILD_CNT];
+	int i;
+
+	for (i = 0; i < CHILD_CNT; i++) {
+		children[i] = fork("swapper");
+		if (children[i] == 0) {
+			int pass;
+
+			for (pass = 0; pass < PASS_CNT; pass++)
+				if (!linear(buf + i * slice, slice, pass + i))
+					exit(1);
+			exit(0);
+		}
+		CHECK(children[i] != PID_ERROR, "fork child %d", i);
+	}
+	for (i = 0; i < CHILD_CNT; i++)
+		CHECK(wait(children[i]) == 0, "wait for child %d", i);
+}
+
+static void run_sparse(void) {
+	size_t i;
+	int pass;
+
+	for (i = 0; i < PAGE_CNT; i++)
+		buf[i * PAGE_SIZE] = (char)i;
+	for (pass = 0; pass < PASS_CNT; pass++) {
+		for (i = 0; i < PAGE_CNT; i++)
+			if (buf[i * PAGE_SIZE] != (char)i)
+				fail("page %zu: bad data", i);
+		msg("sparse pass %d", pass);
+	}
+}
+
+void test_main(void) {
+	if (!strcmp(test_name, "swap-linear"))
+		run_linear();
+	else if (!strcmp(test_name, "swap-parallel"))
+		run_parallel();
+	else if (!strcmp(test_name, "swap-sparse"))
+		run_sparse();
+	else
+		fail("unknown workload %s", test_name);
+}
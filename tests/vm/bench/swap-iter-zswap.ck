@@ -0,0 +1,31 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(swap-iter-zswap) begin
+(swap-iter-zswap) write sparsely over page 0
+(swap-iter-zswap) write sparsely over page 512
+(swap-iter-zswap) write sparsely over page 1024
+(swap-iter-zswap) write sparsely over page 1536
+(swap-iter-zswap) write sparsely over page 2048
+(swap-iter-zswap) write sparsely over page 2560
+(swap-iter-zswap) write sparsely over page 3072
+(swap-iter-zswap) write sparsely over page 3584
+(swap-iter-zswap) write sparsely over page 4096
+(swap-iter-zswap) write sparsely over page 4608
+(swap-iter-zswap) open "large.txt"
+(swap-iter-zswap) mmap "large.txt"
+(swap-iter-zswap) check consistency in page 0
+(swap-iter-zswap) check consistency in page 512
+(swap-iter-zswap) check consistency in page 1024
+(swap-iter-zswap) check consistency in page 1536
+(swap-iter-zswap) check consistency in page 2048
+(swap-iter-zswap) check consistency in page 2560
+(swap-iter-zswap) check consistency in page 3072
+(swap-iter-zswap) check consistency in page 3584
+(swap-iter-zswap) check consistency in page 4096
+(swap-iter-zswap) check consistency in page 4608
+(swap-iter-zswap) end
+EOF
+pass;
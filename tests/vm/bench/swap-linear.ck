@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(swap-linear) begin
+(swap-linear) linear pass 0
+(swap-linear) linear pass 1
+(swap-linear) end
+EOF
+pass;
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(swap-parallel) begin
+(swap-parallel) fork child 0
+(swap-parallel) fork child 1
+(swap-parallel) fork child 2
+(swap-parallel) fork child 3
+(swap-parallel) wait for child 0
+(swap-parallel) wait for child 1
+(swap-parallel) wait for child 2
+(swap-parallel) wait for child 3
+(swap-parallel) end
+EOF
+pass;
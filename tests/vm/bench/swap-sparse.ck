@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(swap-sparse) begin
+(swap-sparse) sparse pass 0
+(swap-sparse) sparse pass 1
+(swap-sparse) end
+EOF
+pass;
@@ -0,0 +1,28 @@
+/* Runs COPY_CNT copies of child-text at once.
+
+   Each copy reads all of its read-only data, then starts the
+   next one and waits for it, so that all of them are running by
+   the time the last one starts.  Each copy reports how long its
+   exec took, from just before the exec call to the start of
+   main, and how long reading its read-only data took, in TSC
+   cycles.
+
+   Every copy after the first should find the read-only data of
+   the executable in memory already, mapped by the others.  The
+   "Text:" line that the kernel prints at power off gives the
+   number of pages mapped that way and the most frames in use at
+   once. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+#include "tests/vm/bench/text-share.h"
+
+void test_main(void) {
+	pid_t child = fork("child-text");
+
+	if (child == 0)
+		start_copy(0);
+	CHECK(child != PID_ERROR, "fork child-text");
+	CHECK(wait(child) == 0, "wait for %d copies", COPY_CNT);
+}
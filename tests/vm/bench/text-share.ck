@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+# The cycle counts vary from run to run, so only check that every
+# copy reported them.
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+@output = get_core_output ("run", @output);
+fail "missing begin in output" unless grep ($_ eq '(text-share) begin', @output);
+for (my $copy = 0; $copy < 20; $copy++) {
+    fail "missing result for copy $copy"
+      unless grep (/^\(child-text\) copy $copy: exec \d+ cycles, read \d+ cycles$/,
+		   @output);
+}
+fail "missing end in output" unless grep ($_ eq '(text-share) end', @output);
+pass;
@@ -0,0 +1,29 @@
+#ifndef TESTS_VM_BENCH_TEXT_SHARE_H
+#define TESTS_VM_BENCH_TEXT_SHARE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+
+/* Number of copies of child-text that run at once. */
+#define COPY_CNT 20
+
+static inline uint64_t rdtsc(void) {
+	uint32_t lo, hi;
+	asm volatile("rdtsc" : "=a"(lo), "=d"(hi));
+	return ((uint64_t)hi << 32) | lo;
+}
+
+/* Turns the current process into copy NUMBER of child-text,
+   telling it when the exec started. */
+static inline void start_copy(int number) {
+	char cmd_line[64];
+
+	snprintf(cmd_line, sizeof cmd_line, "child-text %d %llu", number,
+			 (unsigned long long)rdtsc());
+	exec(cmd_line);
+	fail("exec child-text %d", number);
+}
+
+#endif /* tests/vm/bench/text-share.h */
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(tlb-switch-nopcid) begin
+(tlb-switch-nopcid) fork child 0
+(tlb-switch-nopcid) fork child 1
+(tlb-switch-nopcid) fork child 2
+(tlb-switch-nopcid) fork child 3
+(tlb-switch-nopcid) wait for child 0
+(tlb-switch-nopcid) wait for child 1
+(tlb-switch-nopcid) wait for child 2
+(tlb-switch-nopcid) wait for child 3
+(tlb-switch-nopcid) end
+EOF
+pass;
@@ -0,0 +1,50 @@
+/* Measures the cost of address space switches.
+
+   Forks CHILD_CNT processes that each sweep a private working set
+   of PAGE_CNT pages over and over, so that the timer keeps
+   preempting one of them in favour of another.  With PCIDs the
+   translations of each process survive the switch; with -nopcid
+   every switch flushes them and the next sweep refills the TLB.
+
+   Compare the user ticks and the "MMU:" line that the kernel
+   prints at power off for tlb-switch and tlb-switch-nopcid. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define CHILD_CNT 4
+#define PAGE_CNT 64
+#define ROUND_CNT 20000
+#define PAGE_SIZE 4096
+
+static volatile char buf[PAGE_CNT * PAGE_SIZE];
+
+/* Touches every page of BUF ROUND_CNT times.
+   Returns true if every page saw every touch. */
+static bool sweep(void) {
+	size_t round, page;
+
+	for (round = 0; round < ROUND_CNT; round++)
+		for (page = 0; page < PAGE_CNT; page++)
+			buf[page * PAGE_SIZE]++;
+
+	for (page = 0; page < PAGE_CNT; page++)
+		if (buf[page * PAGE_SIZE] != (char)ROUND_CNT)
+			return false;
+	return true;
+}
+
+void test_main(void) {
+	pid_t children[CHILD_CNT];
+	size_t i;
+
+	for (i = 0; i < CHILD_CNT; i++) {
+		children[i] = fork("sweeper");
+		if (children[i] == 0)
+			exit(sweep() ? 0 : 1);
+		CHECK(children[i] != PID_ERROR, "fork child %zu", i);
+	}
+	for (i = 0; i < CHILD_CNT; i++)
+		CHECK(wait(children[i]) == 0, "wait for child %zu", i);
+}
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(tlb-switch) begin
+(tlb-switch) fork child 0
+(tlb-switch) fork child 1
+(tlb-switch) fork child 2
+(tlb-switch) fork child 3
+(tlb-switch) wait for child 0
+(tlb-switch) wait for child 1
+(tlb-switch) wait for child 2
+(tlb-switch) wait for child 3
+(tlb-switch) end
+EOF
+pass;
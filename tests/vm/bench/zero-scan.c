@@ -0,0 +1,60 @@
+/* Measures faults on memory that is only read.
+
+   Reads every page of a large zero-initialized array, then writes
+   every page of it.  Reports, after each pass, how many pages are
+   backed by the same frame as the first one, which is the whole
+   array while it has only been read, and the average cost of a
+   pass per page in TSC cycles, which is mostly the page fault.
+
+   The "COW:" line that the kernel prints at power off gives the
+   number of pages mapped to the zero page. */
+
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 2048
+
+static char buf[PAGE_CNT * PAGE_SIZE];
+
+static inline uint64_t rdtsc(void) {
+	uint32_t lo, hi;
+	asm volatile("rdtsc" : "=a"(lo), "=d"(hi));
+	return ((uint64_t)hi << 32) | lo;
+}
+
+/* Returns the number of pages of BUF on the same frame as its first
+   page. */
+static size_t count_same_frame(void) {
+	void *first = get_phys_addr(buf);
+	size_t cnt = 0;
+	size_t i;
+
+	for (i = 0; i < PAGE_CNT; i++)
+		if (get_phys_addr(buf + i * PAGE_SIZE) == first)
+			cnt++;
+	return cnt;
+}
+
+void test_main(void) {
+	volatile char *p = buf;
+	uint64_t start, cycles;
+	size_t i;
+
+	start = rdtsc();
+	for (i = 0; i < PAGE_CNT; i++)
+		if (p[i * PAGE_SIZE] != 0)
+			fail("page %zu is not zero", i);
+	cycles = (rdtsc() - start) / PAGE_CNT;
+	msg("read %d pages: %zu on one frame, %llu cycles per page", PAGE_CNT,
+		count_same_frame(), (unsigned long long)cycles);
+
+	start = rdtsc();
+	for (i = 0; i < PAGE_CNT; i++)
+		p[i * PAGE_SIZE] = 1;
+	cycles = (rdtsc() - start) / PAGE_CNT;
+	msg("wrote %d pages: %zu on one frame, %llu cycles per page", PAGE_CNT,
+		count_same_frame(), (unsigned long long)cycles);
+}
@@ -0,0 +1,20 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+# The cycle counts vary from run to run, so only check the format.
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+@output = get_core_output ("run", @output);
+fail "missing begin in output" unless grep ($_ eq '(zero-scan) begin', @output);
+foreach my $pass (qw (read wrote)) {
+    fail "missing $pass result"
+      unless grep (/^\(zero-scan\) $pass 2048 pages: \d+ on one frame, \d+ cycles per page$/,
+		   @output);
+}
+fail "missing end in output" unless grep ($_ eq '(zero-scan) end', @output);
+pass;
@@ -0,0 +1,27 @@
+/* Writes every page of a buffer larger than the user pool and
+   swap put together, then checks them, for oom-kill.  It should
+   be killed before it gets that far, so it prints nothing. */
+
+#include <debug.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define BUF_SIZE (16 * 1024 * 1024)
+
+static char buf[BUF_SIZE];
+
+int main(int argc UNUSED, char *argv[] UNUSED) {
+	size_t i;
+
+	test_name = "child-hog";
+	quiet = true;
+
+	for (i = 0; i < BUF_SIZE; i += PAGE_SIZE)
+		buf[i] = (char)(i / PAGE_SIZE);
+	for (i = 0; i < BUF_SIZE; i += PAGE_SIZE)
+		if (buf[i] != (char)(i / PAGE_SIZE))
+			fail("page %zu: bad data", i / PAGE_SIZE);
+	return 0;
+}
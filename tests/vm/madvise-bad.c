@@ -0,0 +1,19 @@
+/* Passes madvise() bad arguments, which must fail without
+   killing the process, and an unmapped range, which must
+   not. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void test_main(void) {
+	CHECK(madvise((void *)0x10000123, 4096, MADV_WILLNEED) == -1,
+		  "misaligned address");
+	CHECK(madvise((void *)0x8004000000, 4096, MADV_DONTNEED) == -1,
+		  "kernel address");
+	CHECK(madvise((void *)0x10000000, (size_t)-1 & ~4095, MADV_DONTNEED) == -1,
+		  "range into the kernel");
+	CHECK(madvise((void *)0x10000000, 4096, 1234) == -1, "unknown advice");
+	CHECK(madvise((void *)0x10000000, 65536, MADV_DONTNEED) == 0,
+		  "unmapped range");
+}
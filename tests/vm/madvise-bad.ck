@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(madvise-bad) begin
+(madvise-bad) misaligned address
+(madvise-bad) kernel address
+(madvise-bad) range into the kernel
+(madvise-bad) unknown advice
+(madvise-bad) unmapped range
+(madvise-bad) end
+EOF
+pass;
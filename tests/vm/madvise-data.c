@@ -0,0 +1,38 @@
+/* Drops initialized data of the executable with MADV_DONTNEED after
+   writing over it.  It must read back as the executable has it, not
+   as zeros. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define INTS_PER_PAGE (PAGE_SIZE / sizeof(int))
+
+static int data[3 * INTS_PER_PAGE] __attribute__((aligned(PAGE_SIZE))) = {
+	[0] = 1,
+	[INTS_PER_PAGE] = 2,
+	[2 * INTS_PER_PAGE] = 3,
+	[3 * INTS_PER_PAGE - 1] = 4,
+};
+
+void test_main(void) {
+	size_t i;
+
+	memset(data, 0x55, sizeof data);
+	CHECK(madvise(data, sizeof data, MADV_DONTNEED) == 0,
+		  "madvise initialized data");
+	for (i = 0; i < 3 * INTS_PER_PAGE; i++) {
+		int expected = i == 0							  ? 1
+					   : i == INTS_PER_PAGE			  ? 2
+					   : i == 2 * INTS_PER_PAGE		  ? 3
+					   : i == 3 * INTS_PER_PAGE - 1 ? 4
+													  : 0;
+
+		if (data[i] != expected)
+			fail("data[%zu] is %d after MADV_DONTNEED (should be %d)", i,
+				 data[i], expected);
+	}
+	msg("initialized data read back from the executable");
+}
@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(madvise-data) begin
+(madvise-data) madvise initialized data
+(madvise-data) initialized data read back from the executable
+(madvise-data) end
+EOF
+pass;
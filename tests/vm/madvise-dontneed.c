@@ -0,0 +1,48 @@
+/* Drops anonymous memory and a written file mapping with
+   MADV_DONTNEED.  The anonymous pages must read back as zeros,
+   and the mapping must keep what was written to it, both in the
+   file and when it is read in again. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define ANON_PAGES 4
+#define ACTUAL ((void *)0x10000000)
+
+static char anon[ANON_PAGES * PAGE_SIZE] __attribute__((aligned(PAGE_SIZE)));
+
+void test_main(void) {
+	char buf[1024];
+	int handle;
+	void *map;
+	size_t i;
+
+	/* Anonymous memory. */
+	memset(anon, 'x', sizeof anon);
+	CHECK(madvise(anon, sizeof anon, MADV_DONTNEED) == 0,
+		  "madvise anonymous memory");
+	for (i = 0; i < sizeof anon; i++)
+		if (anon[i] != 0)
+			fail("byte %zu is %02hhx after MADV_DONTNEED (should be 0)", i,
+				 anon[i]);
+
+	/* A file mapping that was written to. */
+	CHECK(create("sample.txt", strlen(sample)), "create \"sample.txt\"");
+	CHECK((handle = open("sample.txt")) > 1, "open \"sample.txt\"");
+	CHECK((map = mmap(ACTUAL, PAGE_SIZE, 1, handle, 0)) != MAP_FAILED,
+		  "mmap \"sample.txt\"");
+	memcpy(ACTUAL, sample, strlen(sample));
+	CHECK(madvise(ACTUAL, PAGE_SIZE, MADV_DONTNEED) == 0, "madvise mapping");
+
+	read(handle, buf, strlen(sample));
+	CHECK(!memcmp(buf, sample, strlen(sample)),
+		  "compare file data against written data");
+	CHECK(!memcmp(ACTUAL, sample, strlen(sample)),
+		  "compare mapping against written data");
+	munmap(map);
+	close(handle);
+}
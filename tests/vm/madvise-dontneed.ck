@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(madvise-dontneed) begin
+(madvise-dontneed) madvise anonymous memory
+(madvise-dontneed) create "sample.txt"
+(madvise-dontneed) open "sample.txt"
+(madvise-dontneed) mmap "sample.txt"
+(madvise-dontneed) madvise mapping
+(madvise-dontneed) compare file data against written data
+(madvise-dontneed) compare mapping against written data
+(madvise-dontneed) end
+EOF
+pass;
@@ -0,0 +1,45 @@
+/* Drops anonymous memory with MADV_DONTNEED, writes to it again, and
+   then writes more memory than the machine has, so that the pages
+   that were dropped are evicted and swapped back in.  They must keep
+   what was written to them after the drop. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define DROP_SIZE (1024 * 1024)
+#define BIG_SIZE (12 * 1024 * 1024)
+
+static char dropped[DROP_SIZE] __attribute__((aligned(PAGE_SIZE)));
+static char big[BIG_SIZE];
+
+/* Fails unless each page of the SIZE bytes at P starts with its number
+   plus SEED. */
+static void check_pages(const char *p, size_t size, char seed,
+						const char *what) {
+	size_t i;
+
+	for (i = 0; i < size / PAGE_SIZE; i++)
+		if (p[i * PAGE_SIZE] != (char)(i + seed))
+			fail("page %zu of %s is %02hhx (should be %02hhx)", i, what,
+				 p[i * PAGE_SIZE], (char)(i + seed));
+}
+
+void test_main(void) {
+	size_t i;
+
+	memset(dropped, 'x', DROP_SIZE);
+	CHECK(madvise(dropped, DROP_SIZE, MADV_DONTNEED) == 0,
+		  "madvise anonymous memory");
+	for (i = 0; i < DROP_SIZE / PAGE_SIZE; i++)
+		dropped[i * PAGE_SIZE] = (char)(i + 1);
+
+	msg("write more memory than there is");
+	for (i = 0; i < BIG_SIZE / PAGE_SIZE; i++)
+		big[i * PAGE_SIZE] = (char)(i + 2);
+	check_pages(big, BIG_SIZE, 2, "big");
+	check_pages(dropped, DROP_SIZE, 1, "dropped memory");
+	msg("dropped memory survived eviction");
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(madvise-evict) begin
+(madvise-evict) madvise anonymous memory
+(madvise-evict) write more memory than there is
+(madvise-evict) dropped memory survived eviction
+(madvise-evict) end
+EOF
+pass;
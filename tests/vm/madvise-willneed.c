@@ -0,0 +1,33 @@
+/* Maps a file, advises that it will be read in order and is
+   needed soon, and checks that the data is right. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ACTUAL ((char *)0x10000000)
+
+void test_main(void) {
+	int handle;
+	void *map;
+	size_t i;
+
+	CHECK((handle = open("sample.txt")) > 1, "open \"sample.txt\"");
+	CHECK((map = mmap(ACTUAL, 4096, 0, handle, 0)) != MAP_FAILED,
+		  "mmap \"sample.txt\"");
+	CHECK(madvise(map, 4096, MADV_SEQUENTIAL) == 0, "madvise sequential");
+	CHECK(madvise(map, 4096, MADV_WILLNEED) == 0, "madvise willneed");
+
+	if (memcmp(ACTUAL, sample, strlen(sample)))
+		fail("read of mmap'd file reported bad data");
+	for (i = strlen(sample); i < 4096; i++)
+		if (ACTUAL[i] != 0)
+			fail("byte %zu of mmap'd region has value %02hhx (should be 0)", i,
+				 ACTUAL[i]);
+
+	CHECK(madvise(map, 4096, MADV_NORMAL) == 0, "madvise normal");
+	munmap(map);
+	close(handle);
+}
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(madvise-willneed) begin
+(madvise-willneed) open "sample.txt"
+(madvise-willneed) mmap "sample.txt"
+(madvise-willneed) madvise sequential
+(madvise-willneed) madvise willneed
+(madvise-willneed) madvise normal
+(madvise-willneed) end
+EOF
+pass;
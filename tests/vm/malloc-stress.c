@@ -0,0 +1,115 @@
+/* Exercises malloc(), calloc(), realloc() and free() with blocks
+   of random sizes, small and large, freed in random order.  Each
+   block is filled with a pattern of its own, which must survive
+   everything else that happens to the heap.  Freeing the large
+   blocks must give memory back to the system. */
+
+#include <malloc.h>
+#include <random.h>
+#include <stdint.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SLOT_CNT 512
+#define ROUND_CNT 20000
+#define LARGE_SIZE (64 * 1024)
+#define LARGE_CNT 32
+
+struct slot {
+	unsigned char *p;
+	size_t size;
+	unsigned char fill;
+};
+
+static struct slot slots[SLOT_CNT];
+
+/* Returns the size of a new block: mostly small, sometimes
+   large. */
+static size_t random_size(void) {
+	if (random_ulong() % 16 == 0)
+		return random_ulong() % LARGE_SIZE + 1;
+	return random_ulong() % 256 + 1;
+}
+
+/* Fails unless SLOT still holds its pattern. */
+static void check_slot(struct slot *slot) {
+	size_t i;
+
+	for (i = 0; i < slot->size; i++)
+		if (slot->p[i] != slot->fill)
+			fail("block of %zu bytes changed at byte %zu", slot->size, i);
+}
+
+static void fill_slot(struct slot *slot, size_t size) {
+	slot->size = size;
+	slot->fill = (unsigned char)random_ulong();
+	memset(slot->p, slot->fill, size);
+}
+
+void test_main(void) {
+	char *start = sbrk(0), *peak;
+	unsigned char *p;
+	int round;
+	size_t i;
+
+	for (round = 0; round < ROUND_CNT; round++) {
+		struct slot *slot = &slots[random_ulong() % SLOT_CNT];
+		size_t size = random_size();
+
+		if (slot->p != NULL)
+			check_slot(slot);
+		switch (random_ulong() % 3) {
+		case 0:
+			free(slot->p);
+			slot->p = malloc(size);
+			if (slot->p == NULL)
+				fail("malloc of %zu bytes failed", size);
+			if ((uintptr_t)slot->p % 16 != 0)
+				fail("block at %p is not aligned", slot->p);
+			break;
+		case 1:
+			p = realloc(slot->p, size);
+			if (p == NULL)
+				fail("realloc to %zu bytes failed", size);
+			slot->p = p;
+			if (slot->size > size)
+				slot->size = size;
+			check_slot(slot);
+			break;
+		default:
+			free(slot->p);
+			slot->p = calloc(size, 1);
+			if (slot->p == NULL)
+				fail("calloc of %zu bytes failed", size);
+			for (i = 0; i < size; i++)
+				if (slot->p[i] != 0)
+					fail("calloc'd block not zeroed at byte %zu", i);
+			break;
+		}
+		fill_slot(slot, size);
+	}
+	msg("%d rounds", ROUND_CNT);
+
+	for (i = 0; i < SLOT_CNT; i++)
+		if (slots[i].p != NULL)
+			check_slot(&slots[i]);
+	msg("blocks intact");
+
+	for (i = 0; i < SLOT_CNT; i++) {
+		free(slots[i].p);
+		slots[i].p = NULL;
+	}
+	peak = sbrk(0);
+	CHECK(peak > start, "heap grew");
+	for (i = 0; i < LARGE_CNT; i++) {
+		slots[i].p = malloc(LARGE_SIZE);
+		if (slots[i].p == NULL)
+			fail("malloc of large block %zu failed", i);
+	}
+	for (i = 0; i < LARGE_CNT; i++)
+		free(slots[i].p);
+	CHECK((char *)sbrk(0) < peak + 2 * LARGE_SIZE,
+		  "freed large blocks went back to the system");
+}
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(malloc-stress) begin
+(malloc-stress) 20000 rounds
+(malloc-stress) blocks intact
+(malloc-stress) heap grew
+(malloc-stress) freed large blocks went back to the system
+(malloc-stress) end
+EOF
+pass;
@@ -0,0 +1,75 @@
+/* Checks that memstat() accounts for what the process does:
+   writing fresh pages makes them resident and anonymous, reading
+   untouched ones maps them shared to the page of zeros, reading a
+   mapped file makes its pages resident as file pages with major
+   faults, and a forked child that writes to memory it shares with
+   its parent takes copy-on-write faults. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 16
+#define ACTUAL ((char *)0x10000000)
+
+static char dirty[PAGE_CNT * PAGE_SIZE] __attribute__((aligned(PAGE_SIZE)));
+static char clean[PAGE_CNT * PAGE_SIZE] __attribute__((aligned(PAGE_SIZE)));
+
+void test_main(void) {
+	struct memstat before, after;
+	volatile char c;
+	int handle;
+	pid_t child;
+	size_t i;
+
+	CHECK(memstat(&before) == 0, "memstat");
+	CHECK(before.wss == -1 && before.wss_peak == -1,
+		  "working set is not sampled");
+
+	for (i = 0; i < PAGE_CNT; i++)
+		dirty[i * PAGE_SIZE] = 1;
+	memstat(&after);
+	CHECK(after.rss_anon - before.rss_anon >= PAGE_CNT,
+		  "written pages are resident anonymous memory");
+	CHECK(after.minor_faults - before.minor_faults >= PAGE_CNT,
+		  "written pages took minor faults");
+
+	before = after;
+	for (i = 0; i < PAGE_CNT; i++)
+		c = clean[i * PAGE_SIZE];
+	memstat(&after);
+	CHECK(after.rss_shared - before.rss_shared >= PAGE_CNT,
+		  "untouched pages that were read are shared");
+
+	CHECK(create("sample.txt", strlen(sample)), "create \"sample.txt\"");
+	CHECK((handle = open("sample.txt")) > 1, "open \"sample.txt\"");
+	write(handle, sample, strlen(sample));
+	CHECK(mmap(ACTUAL, PAGE_SIZE, 0, handle, 0) != MAP_FAILED,
+		  "mmap \"sample.txt\"");
+	before = after;
+	c = ACTUAL[0];
+	memstat(&after);
+	CHECK(after.rss_file - before.rss_file == 1,
+		  "mapped page is resident file memory");
+	CHECK(after.major_faults - before.major_faults == 1,
+		  "mapped page took a major fault");
+	munmap(ACTUAL);
+	close(handle);
+
+	child = fork("child");
+	if (child == 0) {
+		memstat(&before);
+		for (i = 0; i < PAGE_CNT; i++)
+			dirty[i * PAGE_SIZE] = 2;
+		memstat(&after);
+		CHECK(after.cow_faults - before.cow_faults >= PAGE_CNT,
+			  "child took copy-on-write faults");
+		exit(0);
+	}
+	CHECK(child != PID_ERROR, "fork");
+	CHECK(wait(child) == 0, "wait for child");
+	(void)c;
+}
@@ -0,0 +1,22 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(memstat) begin
+(memstat) memstat
+(memstat) working set is not sampled
+(memstat) written pages are resident anonymous memory
+(memstat) written pages took minor faults
+(memstat) untouched pages that were read are shared
+(memstat) create "sample.txt"
+(memstat) open "sample.txt"
+(memstat) mmap "sample.txt"
+(memstat) mapped page is resident file memory
+(memstat) mapped page took a major fault
+(memstat) child took copy-on-write faults
+(memstat) fork
+(memstat) wait for child
+(memstat) end
+EOF
+pass;
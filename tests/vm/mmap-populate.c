@@ -0,0 +1,34 @@
+/* Maps a file with MAP_POPULATE and checks that the mapping
+   holds the file. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ACTUAL ((char *)0x10000000)
+
+static char buf[4096];
+
+void test_main(void) {
+	size_t size, ofs;
+	int handle;
+	void *map;
+
+	CHECK((handle = open("large.txt")) > 1, "open \"large.txt\"");
+	size = filesize(handle);
+	CHECK((map = mmap(ACTUAL, size, MAP_POPULATE, handle, 0)) != MAP_FAILED,
+		  "mmap \"large.txt\" populated");
+
+	for (ofs = 0; ofs < size; ofs += sizeof buf) {
+		size_t len = size - ofs < sizeof buf ? size - ofs : sizeof buf;
+
+		if ((size_t)read(handle, buf, len) != len)
+			fail("read at offset %zu failed", ofs);
+		if (memcmp(ACTUAL + ofs, buf, len))
+			fail("mapping differs from the file at offset %zu", ofs);
+	}
+	msg("compare mapping against file");
+	munmap(map);
+	close(handle);
+}
@@ -0,0 +1,27 @@
+/* Maps the running executable, which may not be written to, writes
+   to the mapping, and syncs it.  msync(MS_SYNC) must report that the
+   data did not reach the file, and the mapping must keep it. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ACTUAL ((void *)0x10000000)
+
+void test_main(void) {
+	char buffer[16];
+	int handle;
+
+	CHECK((handle = open("msync-denied")) > 1, "open \"msync-denied\"");
+	CHECK(mmap(ACTUAL, 4096, 1, handle, 0) != MAP_FAILED,
+		  "mmap \"msync-denied\"");
+	memset(ACTUAL, 'x', sizeof buffer);
+	CHECK(msync(ACTUAL, 4096, MS_SYNC) == -1, "msync fails");
+	CHECK(read(handle, buffer, sizeof buffer) == (int)sizeof buffer,
+		  "read \"msync-denied\"");
+	CHECK(memcmp(buffer, ACTUAL, sizeof buffer), "file is unchanged");
+	CHECK(!memcmp(ACTUAL, "xxxxxxxxxxxxxxxx", sizeof buffer),
+		  "mapping keeps the data");
+	CHECK(msync(ACTUAL, 4096, MS_SYNC) == -1, "msync fails again");
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(msync-denied) begin
+(msync-denied) open "msync-denied"
+(msync-denied) mmap "msync-denied"
+(msync-denied) msync fails
+(msync-denied) read "msync-denied"
+(msync-denied) file is unchanged
+(msync-denied) mapping keeps the data
+(msync-denied) msync fails again
+(msync-denied) end
+EOF
+pass;
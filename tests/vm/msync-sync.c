@@ -0,0 +1,35 @@
+/* Writes to a file through a mapping and msync()s it, then
+   reads the data back with the read system call while the file
+   is still mapped. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ACTUAL ((void *)0x10000000)
+
+void test_main(void) {
+	int handle;
+	void *map;
+	char buf[1024];
+
+	CHECK(create("sample.txt", strlen(sample)), "create \"sample.txt\"");
+	CHECK((handle = open("sample.txt")) > 1, "open \"sample.txt\"");
+	CHECK((map = mmap(ACTUAL, 4096, 1, handle, 0)) != MAP_FAILED,
+		  "mmap \"sample.txt\"");
+	memcpy(ACTUAL, sample, strlen(sample));
+	CHECK(msync(ACTUAL, 4096, MS_SYNC) == 0, "msync \"sample.txt\"");
+
+	read(handle, buf, strlen(sample));
+	CHECK(!memcmp(buf, sample, strlen(sample)),
+		  "compare read data against written data");
+
+	CHECK(msync(ACTUAL, 4096, MS_ASYNC) == 0, "msync asynchronously");
+	CHECK(msync(ACTUAL, 4096, MS_SYNC | MS_ASYNC) == -1, "msync bad flags");
+	CHECK(msync((char *)ACTUAL + 4096, 4096, MS_SYNC) == -1,
+		  "msync unmapped range");
+	munmap(map);
+	close(handle);
+}
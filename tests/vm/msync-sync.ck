@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(msync-sync) begin
+(msync-sync) create "sample.txt"
+(msync-sync) open "sample.txt"
+(msync-sync) mmap "sample.txt"
+(msync-sync) msync "sample.txt"
+(msync-sync) compare read data against written data
+(msync-sync) msync asynchronously
+(msync-sync) msync bad flags
+(msync-sync) msync unmapped range
+(msync-sync) end
+EOF
+pass;
@@ -0,0 +1,61 @@
+/* Runs a few processes that use little memory next to hogs that
+   want more than the user pool and swap hold between them.
+   Instead of failing whoever happens to allocate last, the kernel
+   should kill the hogs, which their parent sees as an exit status
+   of -1, and the others should run to the end with their memory
+   intact. */
+
+#include <mman.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define CALM_CNT 3
+#define CALM_PAGES 16
+#define HOG_CNT 2
+
+static char calm_buf[CALM_PAGES * PAGE_SIZE];
+
+/* Writes a few pages, waits until the hogs have been killed, and
+   exits with 0 if the pages kept their contents. */
+static void calm(int id) {
+	struct memstat st;
+	size_t i;
+
+	for (i = 0; i < CALM_PAGES; i++)
+		calm_buf[i * PAGE_SIZE] = (char)(i + id);
+	do {
+		if (memstat(&st) != 0)
+			exit(2);
+	} while (st.oom_kills < HOG_CNT);
+	for (i = 0; i < CALM_PAGES; i++)
+		if (calm_buf[i * PAGE_SIZE] != (char)(i + id))
+			exit(1);
+	exit(0);
+}
+
+void test_main(void) {
+	pid_t calms[CALM_CNT], hogs[HOG_CNT];
+	int i;
+
+	for (i = 0; i < CALM_CNT; i++) {
+		calms[i] = fork("calm");
+		if (calms[i] == 0)
+			calm(i);
+		if (calms[i] == PID_ERROR)
+			fail("fork child %d", i);
+	}
+	for (i = 0; i < HOG_CNT; i++) {
+		hogs[i] = fork("child-hog");
+		if (hogs[i] == 0 && exec("child-hog") == -1)
+			fail("exec \"child-hog\"");
+		if (hogs[i] == PID_ERROR)
+			fail("fork hog %d", i);
+	}
+
+	for (i = 0; i < HOG_CNT; i++)
+		CHECK(wait(hogs[i]) == -1, "hog %d was killed", i);
+	for (i = 0; i < CALM_CNT; i++)
+		CHECK(wait(calms[i]) == 0, "child %d survived", i);
+}
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(oom-kill) begin
+(oom-kill) hog 0 was killed
+(oom-kill) hog 1 was killed
+(oom-kill) child 0 survived
+(oom-kill) child 1 survived
+(oom-kill) child 2 survived
+(oom-kill) end
+EOF
+pass;
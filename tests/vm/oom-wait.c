@@ -0,0 +1,40 @@
+/* Has the process with the most memory block in wait() on a hog
+   that runs memory and swap out.  The blocked process is the one
+   to kill, and it should exit with -1 right away rather than at
+   some fault that never comes while it waits. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define BUF_SIZE (6 * 1024 * 1024)
+
+static char buf[BUF_SIZE];
+
+/* Fills BUF, then waits on a hog.  Exits with 0 if the wait ever
+   returns. */
+static void blocker(void) {
+	pid_t hog;
+	size_t i;
+
+	for (i = 0; i < BUF_SIZE; i += PAGE_SIZE)
+		buf[i] = (char)(i / PAGE_SIZE);
+	hog = fork("child-hog");
+	if (hog == 0 && exec("child-hog") == -1)
+		exit(2);
+	if (hog == PID_ERROR)
+		exit(3);
+	wait(hog);
+	exit(0);
+}
+
+void test_main(void) {
+	pid_t pid = fork("blocker");
+
+	if (pid == 0)
+		blocker();
+	if (pid == PID_ERROR)
+		fail("fork blocker");
+	CHECK(wait(pid) == -1, "blocker was killed while waiting");
+}
@@ -0,0 +1,10 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(oom-wait) begin
+(oom-wait) blocker was killed while waiting
+(oom-wait) end
+EOF
+pass;
@@ -0,0 +1,66 @@
+/* Grows and shrinks the heap with sbrk().  New heap memory reads
+   as zeros, memory given back and taken again is zeros again, a
+   forked child inherits the heap, and the break refuses to move
+   below the start of the heap, into a mapping, or near the
+   stack. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define HEAP_SIZE (3 * PAGE_SIZE + 100)
+
+/* Returns true if the SIZE bytes at P are all C. */
+static bool all_are(const char *p, size_t size, char c) {
+	size_t i;
+
+	for (i = 0; i < size; i++)
+		if (p[i] != c)
+			return false;
+	return true;
+}
+
+void test_main(void) {
+	char *start, *p, *end;
+	int handle;
+	pid_t child;
+
+	start = sbrk(0);
+	CHECK(start != (void *)-1, "sbrk(0)");
+	CHECK(sbrk(HEAP_SIZE) == start, "grow the heap");
+	CHECK(sbrk(0) == start + HEAP_SIZE, "break moved");
+	CHECK(all_are(start, HEAP_SIZE, 0), "new heap is zeros");
+	memset(start, 'h', HEAP_SIZE);
+
+	child = fork("child");
+	if (child == 0) {
+		CHECK(all_are(start, HEAP_SIZE, 'h'), "child sees the heap");
+		p = sbrk(PAGE_SIZE);
+		memset(p, 'c', PAGE_SIZE);
+		exit(0);
+	}
+	CHECK(child != PID_ERROR, "fork");
+	CHECK(wait(child) == 0, "wait for child");
+	CHECK(sbrk(0) == start + HEAP_SIZE, "child's heap is its own");
+
+	CHECK(sbrk(-HEAP_SIZE) == start + HEAP_SIZE, "shrink the heap");
+	CHECK(sbrk(PAGE_SIZE) == start, "grow it again");
+	CHECK(all_are(start, PAGE_SIZE, 0), "heap given back is zeros");
+
+	CHECK(brk(start - PAGE_SIZE) == -1, "no break below the heap");
+	CHECK(brk((void *)0x47400000) == -1, "no break near the stack");
+	CHECK(sbrk(0) == start + PAGE_SIZE, "break did not move");
+
+	end = start + 4 * PAGE_SIZE;
+	CHECK(create("sample.txt", strlen(sample)), "create \"sample.txt\"");
+	CHECK((handle = open("sample.txt")) > 1, "open \"sample.txt\"");
+	CHECK(mmap(end, PAGE_SIZE, 0, handle, 0) != MAP_FAILED,
+		  "mmap \"sample.txt\" past the break");
+	CHECK(sbrk(4 * PAGE_SIZE) == (void *)-1, "no break over the mapping");
+	CHECK(sbrk(2 * PAGE_SIZE) == start + PAGE_SIZE, "grow up to the mapping");
+	memset(start, 'x', 3 * PAGE_SIZE);
+	CHECK(!memcmp(end, sample, strlen(sample)), "mapping is intact");
+}
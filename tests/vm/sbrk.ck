@@ -0,0 +1,29 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(sbrk) begin
+(sbrk) sbrk(0)
+(sbrk) grow the heap
+(sbrk) break moved
+(sbrk) new heap is zeros
+(sbrk) child sees the heap
+(sbrk) fork
+(sbrk) wait for child
+(sbrk) child's heap is its own
+(sbrk) shrink the heap
+(sbrk) grow it again
+(sbrk) heap given back is zeros
+(sbrk) no break below the heap
+(sbrk) no break near the stack
+(sbrk) break did not move
+(sbrk) create "sample.txt"
+(sbrk) open "sample.txt"
+(sbrk) mmap "sample.txt" past the break
+(sbrk) no break over the mapping
+(sbrk) grow up to the mapping
+(sbrk) mapping is intact
+(sbrk) end
+EOF
+pass;
@@ -0,0 +1,53 @@
+/* Grows the stack by most of its 1 MB limit through recursion
+   and checks what was written there, then checks that mmap()
+   keeps out of the guard gap below the limit but may map right
+   below it. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define USER_STACK 0x47480000
+#define STACK_LIMIT (USER_STACK - 1024 * 1024)
+#define GUARD_SIZE (64 * 1024)
+#define FRAME_SIZE 1000
+#define DEPTH 768
+
+/* Fills a frame of its own with DEPTH, recurses, and checks that
+   the frame still holds DEPTH.  Returns the sum of the depths. */
+static int recurse(int depth) {
+	volatile char frame[FRAME_SIZE];
+	int sum = depth, i;
+
+	memset((char *)frame, depth, sizeof frame);
+	if (depth > 0)
+		sum += recurse(depth - 1);
+	for (i = 0; i < FRAME_SIZE; i++)
+		if (frame[i] != (char)depth)
+			fail("frame at depth %d changed", depth);
+	return sum;
+}
+
+void test_main(void) {
+	int handle;
+
+	CHECK(recurse(DEPTH) == DEPTH * (DEPTH + 1) / 2, "recurse %d deep", DEPTH);
+
+	CHECK(create("sample.txt", strlen(sample)), "create \"sample.txt\"");
+	CHECK((handle = open("sample.txt")) > 1, "open \"sample.txt\"");
+	CHECK(mmap((void *)(STACK_LIMIT - PAGE_SIZE), PAGE_SIZE, 0, handle, 0) ==
+			  MAP_FAILED,
+		  "mmap in the guard gap fails");
+	CHECK(mmap((void *)(STACK_LIMIT - GUARD_SIZE - 2 * PAGE_SIZE),
+			   2 * PAGE_SIZE, 0, handle, 0) == MAP_FAILED,
+		  "mmap reaching into the guard gap fails");
+	CHECK(mmap((void *)(STACK_LIMIT - GUARD_SIZE - PAGE_SIZE), PAGE_SIZE, 0,
+			   handle, 0) != MAP_FAILED,
+		  "mmap below the guard gap");
+	CHECK(!memcmp((void *)(STACK_LIMIT - GUARD_SIZE - PAGE_SIZE), sample,
+				  strlen(sample)),
+		  "compare mapping against file");
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(stack-gap) begin
+(stack-gap) recurse 768 deep
+(stack-gap) create "sample.txt"
+(stack-gap) open "sample.txt"
+(stack-gap) mmap in the guard gap fails
+(stack-gap) mmap reaching into the guard gap fails
+(stack-gap) mmap below the guard gap
+(stack-gap) compare mapping against file
+(stack-gap) end
+EOF
+pass;
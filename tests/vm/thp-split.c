@@ -0,0 +1,82 @@
+/* Writes an aligned 2 MB of heap, which -o thp=1 maps with one 2 MB
+   page, then makes the kernel split it back into 4 kB pages in each
+   way it may: by sharing it with a forked child that writes to its
+   copy, by dropping one page of it with MADV_DONTNEED, and by
+   shrinking the heap into the middle of it.  Every page must keep
+   its contents throughout. */
+
+#include <round.h>
+#include <stdint.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define HUGE_SIZE (2 * 1024 * 1024)
+#define PAGE_CNT (HUGE_SIZE / PAGE_SIZE)
+
+/* Fills each page of BLOCK with its number plus SEED. */
+static void fill(char *block, char seed) {
+	size_t i;
+
+	for (i = 0; i < PAGE_CNT; i++)
+		memset(block + i * PAGE_SIZE, (char)(i + seed), PAGE_SIZE);
+}
+
+/* Returns true if pages FIRST up to LAST of BLOCK still hold what
+   fill() put there with SEED. */
+static bool check(const char *block, size_t first, size_t last, char seed) {
+	size_t i, j;
+
+	for (i = first; i < last; i++)
+		for (j = 0; j < PAGE_SIZE; j++)
+			if (block[i * PAGE_SIZE + j] != (char)(i + seed))
+				return false;
+	return true;
+}
+
+void test_main(void) {
+	char *start, *block;
+	pid_t child;
+	size_t i;
+
+	/* Room for two aligned 2 MB blocks wherever the heap starts. */
+	start = sbrk(3 * HUGE_SIZE);
+	CHECK(start != (void *)-1, "grow the heap by 6 MB");
+	block = (char *)ROUND_UP((uintptr_t)start, HUGE_SIZE);
+	fill(block, 1);
+	CHECK(check(block, 0, PAGE_CNT, 1), "fill 2 MB");
+
+	child = fork("child");
+	if (child == 0) {
+		CHECK(check(block, 0, PAGE_CNT, 1), "child sees the 2 MB");
+		fill(block, 2);
+		CHECK(check(block, 0, PAGE_CNT, 2), "child writes its copy");
+		exit(0);
+	}
+	CHECK(child != PID_ERROR, "fork");
+	CHECK(wait(child) == 0, "wait for child");
+	CHECK(check(block, 0, PAGE_CNT, 1), "parent's copy is intact");
+
+	CHECK(madvise(block + 100 * PAGE_SIZE, PAGE_SIZE, MADV_DONTNEED) == 0,
+		  "drop one page");
+	for (i = 0; i < PAGE_SIZE; i++)
+		if (block[100 * PAGE_SIZE + i] != 0)
+			fail("byte %zu of the dropped page is %02hhx (should be 0)", i,
+				 block[100 * PAGE_SIZE + i]);
+	CHECK(check(block, 0, 100, 1) && check(block, 101, PAGE_CNT, 1),
+		  "other pages are intact");
+
+	CHECK(brk(block + HUGE_SIZE / 2) == 0, "shrink the heap to 1 MB in");
+	CHECK(check(block, 0, 100, 1) && check(block, 101, PAGE_CNT / 2, 1),
+		  "pages below the break are intact");
+	CHECK(brk(start + 3 * HUGE_SIZE) == 0, "grow it again");
+	for (i = HUGE_SIZE / 2; i < HUGE_SIZE; i++)
+		if (block[i] != 0)
+			fail("byte %zu given back is %02hhx (should be 0)", i, block[i]);
+
+	/* The next 2 MB was never touched. */
+	fill(block + HUGE_SIZE, 3);
+	CHECK(check(block + HUGE_SIZE, 0, PAGE_CNT, 3), "fill the next 2 MB");
+}
@@ -0,0 +1,22 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(thp-split) begin
+(thp-split) grow the heap by 6 MB
+(thp-split) fill 2 MB
+(thp-split) child sees the 2 MB
+(thp-split) child writes its copy
+(thp-split) fork
+(thp-split) wait for child
+(thp-split) parent's copy is intact
+(thp-split) drop one page
+(thp-split) other pages are intact
+(thp-split) shrink the heap to 1 MB in
+(thp-split) pages below the break are intact
+(thp-split) grow it again
+(thp-split) fill the next 2 MB
+(thp-split) end
+EOF
+pass;
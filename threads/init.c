@@ -17,6 +17,7 @@
 #include "threads/io.h"
 #include "threads/loader.h"
 #include "threads/malloc.h"
+#include "threads/memstat.h"
 #include "threads/mmu.h"
 #include "threads/palloc.h"
 #include "threads/pte.h"
@@ -84,6 +85,7 @@ int main(void) {
 	mem_end = palloc_init();
 	malloc_init();
 	paging_init(mem_end);
+	pcid_init();
 
 #ifdef USERPROG
 	tss_init();
@@ -93,12 +95,14 @@ int main(void) {
 
 	/* Initialize interrupt handlers. */
 	intr_init();
+	memstat_init();
 	timer_init();
 	kbd_init();
 	input_init();
 #ifdef USERPROG
 	exception_init();
 	syscall_init();
+	process_init_exec_cache();
 #endif
 	/* Start thread scheduler and enable interrupts. */
 	thread_start();
@@ -216,11 +220,19 @@ static char **parse_options(char **argv) {
 			random_init(atoi(value));
 		else if (!strcmp(name, "-mlfqs"))
 			thread_mlfqs = true;
+		else if (!strcmp(name, "-nopcid"))
+			pcid_disabled = true;
 #ifdef USERPROG
 		else if (!strcmp(name, "-ul"))
 			user_page_limit = atoi(value);
 		else if (!strcmp(name, "-threads-tests"))
 			thread_tests = true;
+		else if (!strcmp(name, "-noexeccache"))
+			exec_cache_disabled = true;
+#endif
+#ifdef VM
+		else if (!strcmp(name, "-o") && argv[1] != NULL)
+			vm_set_option(*++argv);
 #endif
 		else
 			PANIC("unknown option `%s' (use -h for help)", name);
@@ -318,8 +330,20 @@ static void usage(void) {
 		   "  -f                 Format file system disk during startup.\n"
 		   "  -rs=SEED           Set random number seed to SEED.\n"
 		   "  -mlfqs             Use multi-level feedback queue scheduler.\n"
+		   "  -nopcid            Flush the TLB on every address space switch.\n"
 #ifdef USERPROG
 		   "  -ul=COUNT          Limit user memory to COUNT pages.\n"
+		   "  -noexeccache       Read an executable's headers at every exec.\n"
+#endif
+#ifdef VM
+		   "  -o zswap=N%%        Keep up to N%% of user memory as compressed swap.\n"
+		   "  -o writeback=MS     Write back dirty mmap pages every MS ms, 0 for never.\n"
+		   "  -o wss=MS           Sample working sets every MS ms, 0 for never.\n"
+		   "  -o memstat=1        Print the memory statistics of processes at exit.\n"
+		   "  -o ksm=N            Scan N frames every 20 ms for pages to merge, 0 for never.\n"
+		   "  -o evict=POLICY     Evict pages by POLICY: clock (default) or 2q.\n"
+		   "  -o stack=KB         Let the stack grow to KB kB (default 1024).\n"
+		   "  -o thp=1            Map 2 MB pages for large anonymous memory.\n"
 #endif
 	);
 	power_off();
@@ -344,12 +368,18 @@ void power_off(void) {
 static void print_stats(void) {
 	timer_print_stats();
 	thread_print_stats();
+	mmu_print_stats();
 #ifdef FILESYS
 	disk_print_stats();
 #endif
+	memstat_print_stats();
 	console_print_stats();
 	kbd_print_stats();
 #ifdef USERPROG
 	exception_print_stats();
+	process_print_stats();
+#endif
+#ifdef VM
+	vm_print_stats();
 #endif
 }
@@ -32,7 +32,13 @@
    because they're too big to fit in a single page with a
    descriptor.  We handle those by allocating contiguous pages
    with the page allocator and sticking the allocation size at
-   the beginning of the allocated block's arena header. */
+   the beginning of the allocated block's arena header.
+
+   When kernel memory is accounted (see threads/memstat.h), each
+   subsystem tag has its own set of descriptors, so an arena only
+   ever holds blocks of one tag and free() can tell whom to credit
+   without a per-block header.  Otherwise all tags share one set,
+   and no arena sits partly empty for a tag of its own. */
 
 /* Descriptor. */
 struct desc {
@@ -40,6 +46,7 @@ struct desc {
 	size_t blocks_per_arena; /* Number of blocks in an arena. */
 	struct list free_list;   /* List of free blocks. */
 	struct lock lock;		 /* Lock. */
+	enum mem_tag tag;		 /* Subsystem charged for the blocks. */
 };
 
 /* Magic number for detecting arena corruption. */
@@ -48,6 +55,7 @@ struct desc {
 /* Arena. */
 struct arena {
 	unsigned magic;	/* Always set to ARENA_MAGIC. */
+	enum mem_tag tag;  /* Subsystem charged for a big block. */
 	struct desc *desc; /* Owning descriptor, null for big block. */
 	size_t free_cnt;   /* Free blocks; pages in big block. */
 };
@@ -57,9 +65,17 @@ struct block {
 	struct list_elem free_elem; /* Free list element. */
 };
 
-/* Our set of descriptors. */
-static struct desc descs[10]; /* Descriptors. */
-static size_t desc_cnt;		  /* Number of descriptors. */
+/* Our set of descriptors, one row per tag if memory is accounted,
+   or else a single row that DESC_ROW() picks for every tag. */
+#ifdef MEMSTAT
+#define DESC_ROWS MEM_TAG_CNT
+#define DESC_ROW(TAG) (TAG)
+#else
+#define DESC_ROWS 1
+#define DESC_ROW(TAG) 0
+#endif
+static struct desc descs[DESC_ROWS][10]; /* Descriptors. */
+static size_t desc_cnt;					 /* Descriptors per row. */
 
 static struct arena *block_to_arena(struct block *);
 static struct block *arena_to_block(struct arena *, size_t idx);
@@ -67,20 +83,27 @@ static struct block *arena_to_block(struct arena *, size_t idx);
 /* Initializes the malloc() descriptors. */
 void malloc_init(void) {
 	size_t block_size;
+	int tag;
 
 	for (block_size = 16; block_size < PGSIZE / 2; block_size *= 2) {
-		struct desc *d = &descs[desc_cnt++];
-		ASSERT(desc_cnt <= sizeof descs / sizeof *descs);
-		d->block_size = block_size;
-		d->blocks_per_arena = (PGSIZE - sizeof(struct arena)) / block_size;
-		list_init(&d->free_list);
-		lock_init(&d->lock);
+		for (tag = 0; tag < DESC_ROWS; tag++) {
+			struct desc *d = &descs[tag][desc_cnt];
+			d->block_size = block_size;
+			d->blocks_per_arena = (PGSIZE - sizeof(struct arena)) / block_size;
+			list_init(&d->free_list);
+			lock_init(&d->lock);
+			d->tag = tag;
+		}
+		desc_cnt++;
+		ASSERT(desc_cnt <= sizeof *descs / sizeof **descs);
 	}
 }
 
-/* Obtains and returns a new block of at least SIZE bytes.
+/* Obtains and returns a new block of at least SIZE bytes,
+   charged to subsystem TAG.
    Returns a null pointer if memory is not available. */
-void *malloc(size_t size) {
+void *malloc_tagged(size_t size, enum mem_tag tag) {
+	struct desc *row = descs[DESC_ROW(tag)];
 	struct desc *d;
 	struct block *b;
 	struct arena *a;
@@ -89,24 +112,30 @@ void *malloc(size_t size) {
 	if (size == 0)
 		return NULL;
 
+	ASSERT(tag < MEM_TAG_CNT);
+
 	/* Find the smallest descriptor that satisfies a SIZE-byte
 	   request. */
-	for (d = descs; d < descs + desc_cnt; d++)
+	for (d = row; d < row + desc_cnt; d++)
 		if (d->block_size >= size)
 			break;
-	if (d == descs + desc_cnt) {
+	if (d == row + desc_cnt) {
 		/* SIZE is too big for any descriptor.
 		   Allocate enough pages to hold SIZE plus an arena. */
 		size_t page_cnt = DIV_ROUND_UP(size + sizeof *a, PGSIZE);
-		a = palloc_get_multiple(0, page_cnt);
-		if (a == NULL)
+		a = palloc_get_multiple_tagged(0, page_cnt, tag);
+		if (a == NULL) {
+			memstat_fail(tag, MEM_HEAP);
 			return NULL;
+		}
 
 		/* Initialize the arena to indicate a big block of PAGE_CNT
 		   pages, and return it. */
 		a->magic = ARENA_MAGIC;
+		a->tag = tag;
 		a->desc = NULL;
 		a->free_cnt = page_cnt;
+		memstat_add(tag, MEM_HEAP, page_cnt * PGSIZE);
 		return a + 1;
 	}
 
@@ -117,14 +146,16 @@ void *malloc(size_t size) {
 		size_t i;
 
 		/* Allocate a page. */
-		a = palloc_get_page(0);
+		a = palloc_get_multiple_tagged(0, 1, tag);
 		if (a == NULL) {
 			lock_release(&d->lock);
+			memstat_fail(tag, MEM_HEAP);
 			return NULL;
 		}
 
 		/* Initialize arena and add its blocks to the free list. */
 		a->magic = ARENA_MAGIC;
+		a->tag = tag;
 		a->desc = d;
 		a->free_cnt = d->blocks_per_arena;
 		for (i = 0; i < d->blocks_per_arena; i++) {
@@ -138,12 +169,14 @@ void *malloc(size_t size) {
 	a = block_to_arena(b);
 	a->free_cnt--;
 	lock_release(&d->lock);
+	memstat_add(tag, MEM_HEAP, d->block_size);
 	return b;
 }
 
-/* Allocates and return A times B bytes initialized to zeroes.
+/* Allocates and return A times B bytes initialized to zeroes,
+   charged to subsystem TAG.
    Returns a null pointer if memory is not available. */
-void *calloc(size_t a, size_t b) {
+void *calloc_tagged(size_t a, size_t b, enum mem_tag tag) {
 	void *p;
 	size_t size;
 
@@ -153,7 +186,7 @@ void *calloc(size_t a, size_t b) {
 		return NULL;
 
 	/* Allocate and zero memory. */
-	p = malloc(size);
+	p = malloc_tagged(size, tag);
 	if (p != NULL)
 		memset(p, 0, size);
 
@@ -174,13 +207,14 @@ static size_t block_size(void *block) {
    If successful, returns the new block; on failure, returns a
    null pointer.
    A call with null OLD_BLOCK is equivalent to malloc(NEW_SIZE).
-   A call with zero NEW_SIZE is equivalent to free(OLD_BLOCK). */
-void *realloc(void *old_block, size_t new_size) {
+   A call with zero NEW_SIZE is equivalent to free(OLD_BLOCK).
+   The new block is charged to subsystem TAG. */
+void *realloc_tagged(void *old_block, size_t new_size, enum mem_tag tag) {
 	if (new_size == 0) {
 		free(old_block);
 		return NULL;
 	} else {
-		void *new_block = malloc(new_size);
+		void *new_block = malloc_tagged(new_size, tag);
 		if (old_block != NULL && new_block != NULL) {
 			size_t old_size = block_size(old_block);
 			size_t min_size = new_size < old_size ? new_size : old_size;
@@ -206,6 +240,7 @@ void free(void *p) {
 			/* Clear the block to help detect use-after-free bugs. */
 			memset(b, 0xcc, d->block_size);
 #endif
+			memstat_sub(d->tag, MEM_HEAP, d->block_size);
 
 			lock_acquire(&d->lock);
 
@@ -227,6 +262,7 @@ void free(void *p) {
 			lock_release(&d->lock);
 		} else {
 			/* It's a big block.  Free its pages. */
+			memstat_sub(a->tag, MEM_HEAP, a->free_cnt * PGSIZE);
 			palloc_free_multiple(a, a->free_cnt);
 			return;
 		}
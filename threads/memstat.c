@@ -0,0 +1,112 @@
+#include "threads/memstat.h"
+#include <debug.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "threads/interrupt.h"
+
+/* Per-subsystem accounting of kernel memory.
+
+   palloc and malloc report every allocation, release and failure
+   here, charged to the subsystem tag of the caller.  Updating a
+   counter is a couple of additions with interrupts off, but malloc
+   also keeps separate arenas for each tag to tell whom a block
+   belongs to, so all of it is only built in with -DMEMSTAT.
+   Without it, the inspect interrupt answers -1 to everything. */
+
+#ifdef MEMSTAT
+static size_t counters[MEM_TAG_CNT][MEM_COUNTER_CNT];
+
+static const char *tag_names[MEM_TAG_CNT] = {
+	[MEM_THREADS] = "threads",	 [MEM_FILESYS] = "filesys",
+	[MEM_USERPROG] = "userprog", [MEM_VM] = "vm",
+	[MEM_LIB] = "lib",
+};
+#endif
+
+static void inspect_memstat(struct intr_frame *);
+
+/* Tool for reading the counters from user programs.  Calling this
+   function via int 0x45.  Must be called after intr_init().
+   Input:
+     @RDX - enum mem_tag to inspect
+     @RCX - enum mem_counter to inspect
+   Output:
+     @RAX - Value of the counter, or -1 if the input is invalid or
+            the kernel was built without -DMEMSTAT. */
+void memstat_init(void) {
+	intr_register_int(0x45, 3, INTR_OFF, inspect_memstat,
+					  "Inspect Memory Usage");
+}
+
+#ifdef MEMSTAT
+
+/* Adds AMOUNT to counter CNT of TAG, which must be MEM_PAGES or
+   MEM_HEAP, and raises its high-water mark if needed. */
+void memstat_add(enum mem_tag tag, enum mem_counter cnt, size_t amount) {
+	enum intr_level old_level;
+	size_t *c;
+
+	ASSERT(tag < MEM_TAG_CNT);
+	ASSERT(cnt == MEM_PAGES || cnt == MEM_HEAP);
+
+	c = counters[tag];
+	old_level = intr_disable();
+	c[cnt] += amount;
+	if (c[cnt] > c[cnt + 1])
+		c[cnt + 1] = c[cnt];
+	intr_set_level(old_level);
+}
+
+/* Subtracts AMOUNT from counter CNT of TAG. */
+void memstat_sub(enum mem_tag tag, enum mem_counter cnt, size_t amount) {
+	enum intr_level old_level;
+
+	ASSERT(tag < MEM_TAG_CNT);
+	ASSERT(cnt == MEM_PAGES || cnt == MEM_HEAP);
+
+	old_level = intr_disable();
+	ASSERT(counters[tag][cnt] >= amount);
+	counters[tag][cnt] -= amount;
+	intr_set_level(old_level);
+}
+
+/* Counts a failed allocation of kind CNT, either MEM_PAGES or
+   MEM_HEAP, for TAG. */
+void memstat_fail(enum mem_tag tag, enum mem_counter cnt) {
+	enum intr_level old_level;
+
+	ASSERT(tag < MEM_TAG_CNT);
+	ASSERT(cnt == MEM_PAGES || cnt == MEM_HEAP);
+
+	old_level = intr_disable();
+	counters[tag][cnt + 2]++;
+	intr_set_level(old_level);
+}
+
+/* Prints memory usage of each subsystem. */
+void memstat_print_stats(void) {
+	int tag;
+
+	printf("Memory: pages (current/peak/failed), heap bytes "
+		   "(current/peak/failed)\n");
+	for (tag = 0; tag < MEM_TAG_CNT; tag++) {
+		size_t *c = counters[tag];
+		printf("  %-8s %zu/%zu/%zu pages, %zu/%zu/%zu bytes\n",
+			   tag_names[tag], c[MEM_PAGES], c[MEM_PAGES_PEAK],
+			   c[MEM_PAGES_FAIL], c[MEM_HEAP], c[MEM_HEAP_PEAK],
+			   c[MEM_HEAP_FAIL]);
+	}
+}
+#endif /* MEMSTAT */
+
+static void inspect_memstat(struct intr_frame *f) {
+#ifdef MEMSTAT
+	uint64_t tag = f->R.rdx;
+	uint64_t cnt = f->R.rcx;
+
+	f->R.rax = tag < MEM_TAG_CNT && cnt < MEM_COUNTER_CNT ? counters[tag][cnt]
+														  : (uint64_t)-1;
+#else
+	f->R.rax = (uint64_t)-1;
+#endif
+}
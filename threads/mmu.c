@@ -1,16 +1,258 @@
+#include <bitmap.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdio.h>
 #include <string.h>
 #include "threads/init.h"
+#include "threads/interrupt.h"
 #include "threads/pte.h"
 #include "threads/palloc.h"
 #include "threads/thread.h"
 #include "threads/mmu.h"
 #include "intrinsic.h"
 
+/* Process-context identifiers (PCIDs).
+
+   When the CPU supports them, every user pml4 is tagged with a
+   PCID so that pml4_activate() reloads CR3 without flushing the
+   TLB: the entries of other address spaces stay cached under their
+   own tag.  PCID 0 belongs to base_pml4.
+
+   The tag of a pml4 lives in its last entry, which is never
+   present and therefore ignored by the MMU.  When all identifiers
+   of a generation are handed out, a new generation starts: the
+   whole TLB is flushed once and each pml4 picks up a fresh PCID on
+   its next activation. */
+#define PCID_CNT 4096				/* Number of PCIDs. */
+#define PCID_SLOT 511				/* pml4 entry that holds the tag. */
+#define CR3_NOFLUSH (1UL << 63)		/* CR3: keep entries of the PCID. */
+#define CR4_PGE (1 << 7)			/* CR4: global pages. */
+#define CR4_PCIDE (1 << 17)			/* CR4: PCIDs enabled. */
+#define CPUID_1_ECX_PCID (1 << 17)	/* CPUID.1:ECX, PCID supported. */
+#define CPUID_7_EBX_INVPCID (1 << 10) /* CPUID.7:EBX, INVPCID supported. */
+
+/* INVPCID types. */
+#define INVPCID_ADDR 0	 /* One address in one PCID. */
+#define INVPCID_SINGLE 1 /* Every entry of one PCID. */
+#define INVPCID_ALL 2	/* Every entry of every PCID, globals too. */
+
+/* Tag layout.  Bit 0 (PTE_P) always stays clear. */
+#define PCID_TAG(gen, pcid) (((uint64_t)(gen) << 13) | ((uint64_t)(pcid) << 1))
+#define PCID_TAG_PCID(tag) (((tag) >> 1) & (PCID_CNT - 1))
+#define PCID_TAG_GEN(tag) ((tag) >> 13)
+
+/* -nopcid: Never use PCIDs, even if the CPU supports them. */
+bool pcid_disabled;
+
+static bool pcid_enabled;			  /* CR4.PCIDE is set. */
+static bool invpcid_enabled;		  /* INVPCID can be used. */
+static uint64_t pcid_generation = 1; /* Current generation. */
+static struct bitmap *pcid_used;	  /* PCIDs of this generation in use. */
+static struct bitmap *pcid_stale;	 /* PCIDs that need a flush on load. */
+
+/* Statistics. */
+static long long cr3_load_cnt;  /* # of address space switches. */
+static long long tlb_flush_cnt; /* # of switches that flushed the TLB. */
+
+/* 2 MB pages.
+
+   pml4_collapse() replaces a page table whose entries map one
+   aligned, contiguous 2 MB of memory alike with a single page
+   directory entry with PTE_PS set, which takes one TLB entry where
+   the page table took 512.  Everything else here still works on
+   4 kB PTEs: the first walk that reaches such an entry splits it,
+   putting the page table back with the accessed and dirty bits of
+   the large page, so that partial unmaps, protection changes and
+   the clock all see 4 kB pages as before.  The page table is kept
+   aside while the large page is mapped so that splitting never has
+   to allocate. */
+#define HUGE_SLOT_CNT 64			/* Most 2 MB pages mapped at once. */
+
+struct huge_slot {
+	uint64_t *pde; /* Entry mapping a 2 MB page, or null if free. */
+	uint64_t *pt;  /* Page table it replaced. */
+};
+static struct huge_slot huge_slots[HUGE_SLOT_CNT];
+
+static long long huge_map_cnt;   /* # of page tables collapsed. */
+static long long huge_split_cnt; /* # of 2 MB pages split again. */
+
+/* Enables PCIDs if the CPU supports them.  Must be called after
+ * paging_init() loaded base_pml4, with malloc() available. */
+void pcid_init(void) {
+	uint32_t regs[4];
+	uint32_t max_leaf;
+
+	if (pcid_disabled)
+		return;
+
+	cpuid(0, 0, regs);
+	max_leaf = regs[0];
+	cpuid(1, 0, regs);
+	if (!(regs[2] & CPUID_1_ECX_PCID))
+		return;
+	if (max_leaf >= 7) {
+		cpuid(7, 0, regs);
+		invpcid_enabled = (regs[1] & CPUID_7_EBX_INVPCID) != 0;
+	}
+
+	pcid_used = bitmap_create(PCID_CNT);
+	pcid_stale = bitmap_create(PCID_CNT);
+	if (pcid_used == NULL || pcid_stale == NULL) {
+		bitmap_destroy(pcid_used);
+		bitmap_destroy(pcid_stale);
+		return;
+	}
+	bitmap_mark(pcid_used, 0);
+
+	/* CR3 must carry PCID 0 when PCIDE is turned on. */
+	ASSERT(pg_ofs(rcr3()) == 0);
+	lcr4(rcr4() | CR4_PCIDE);
+	pcid_enabled = true;
+}
+
+/* Flushes every TLB entry of every PCID. */
+static void tlb_flush_all(void) {
+	if (invpcid_enabled)
+		invpcid(INVPCID_ALL, 0, 0);
+	else {
+		/* Toggling CR4.PGE flushes all PCIDs, see [IA32-v3a] 4.10.4.1. */
+		uint64_t cr4 = rcr4();
+		lcr4(cr4 ^ CR4_PGE);
+		lcr4(cr4);
+	}
+}
+
+/* Returns the PCID of PML4, assigning a new one if PML4 has none
+ * in the current generation.  Sets *FLUSH if the TLB may still hold
+ * stale entries under that PCID.  Interrupts must be off. */
+static uint64_t pcid_get(uint64_t *pml4, bool *flush) {
+	uint64_t tag = pml4[PCID_SLOT];
+	size_t pcid;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	if (tag != 0 && PCID_TAG_GEN(tag) == pcid_generation)
+		pcid = PCID_TAG_PCID(tag);
+	else {
+		pcid = bitmap_scan_and_flip(pcid_used, 1, 1, false);
+		if (pcid == BITMAP_ERROR) {
+			/* Out of identifiers: recycle all of them at once. */
+			pcid_generation++;
+			bitmap_set_all(pcid_used, false);
+			bitmap_set_all(pcid_stale, false);
+			bitmap_mark(pcid_used, 0);
+			tlb_flush_all();
+			tlb_flush_cnt++;
+			pcid = bitmap_scan_and_flip(pcid_used, 1, 1, false);
+		}
+		pml4[PCID_SLOT] = PCID_TAG(pcid_generation, pcid);
+	}
+
+	*flush = bitmap_test(pcid_stale, pcid);
+	if (*flush)
+		bitmap_reset(pcid_stale, pcid);
+	return pcid;
+}
+
+/* Gives the PCID of PML4 back and drops its TLB entries. */
+static void pcid_release(uint64_t *pml4) {
+	enum intr_level old_level;
+	uint64_t tag = pml4[PCID_SLOT];
+	size_t pcid;
+
+	if (!pcid_enabled || tag == 0)
+		return;
+
+	old_level = intr_disable();
+	if (PCID_TAG_GEN(tag) == pcid_generation) {
+		pcid = PCID_TAG_PCID(tag);
+		if (invpcid_enabled)
+			invpcid(INVPCID_SINGLE, pcid, 0);
+		else
+			bitmap_mark(pcid_stale, pcid);
+		bitmap_reset(pcid_used, pcid);
+	}
+	pml4[PCID_SLOT] = 0;
+	intr_set_level(old_level);
+}
+
+/* Invalidates the TLB entry of user page VA in PML4.  PML4 need not
+ * be the active page table: with PCIDs, an inactive address space
+ * may still have entries cached under its own tag. */
+static void tlb_invalidate(uint64_t *pml4, const void *va) {
+	enum intr_level old_level;
+	uint64_t tag;
+
+	if (PTE_ADDR(rcr3()) == vtop(pml4)) {
+		invlpg((uint64_t)va);
+		return;
+	}
+	if (!pcid_enabled)
+		return;
+
+	old_level = intr_disable();
+	tag = pml4[PCID_SLOT];
+	if (tag != 0 && PCID_TAG_GEN(tag) == pcid_generation) {
+		if (invpcid_enabled)
+			invpcid(INVPCID_ADDR, PCID_TAG_PCID(tag), (uint64_t)va);
+		else
+			bitmap_mark(pcid_stale, PCID_TAG_PCID(tag));
+	}
+	intr_set_level(old_level);
+}
+
+/* Prints address space switching statistics. */
+void mmu_print_stats(void) {
+	printf("MMU: %lld address space switches, %lld TLB flushes, PCID %s\n",
+		   cr3_load_cnt, tlb_flush_cnt,
+		   !pcid_enabled ? "off" : invpcid_enabled ? "on" : "on (no INVPCID)");
+	if (huge_map_cnt > 0)
+		printf("MMU: %lld 2 MB pages mapped, %lld split into 4 kB pages\n",
+			   huge_map_cnt, huge_split_cnt);
+}
+
+/* Returns the slot of PDE, or of a free slot if PDE is null.  Returns
+ * a null pointer if there is none.  Interrupts must be off. */
+static struct huge_slot *huge_slot_find(const uint64_t *pde) {
+	size_t i;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+	for (i = 0; i < HUGE_SLOT_CNT; i++)
+		if (huge_slots[i].pde == pde)
+			return &huge_slots[i];
+	return NULL;
+}
+
+/* If PDE maps a 2 MB page, maps the same memory through the page table
+ * it replaced again. */
+static void huge_split(uint64_t *pde) {
+	enum intr_level old_level = intr_disable();
+
+	if (*pde & PTE_PS) {
+		struct huge_slot *slot = huge_slot_find(pde);
+		uint64_t bits = *pde & (PTE_A | PTE_D);
+		size_t i;
+
+		ASSERT(slot != NULL);
+		for (i = 0; i < HUGE_PGCNT; i++)
+			slot->pt[i] |= bits;
+
+		/* A TLB entry for the large page maps the same memory the same
+		 * way, until the next change to one of its PTEs invalidates
+		 * it. */
+		*pde = vtop(slot->pt) | PTE_U | PTE_W | PTE_P;
+		slot->pde = NULL;
+		huge_split_cnt++;
+	}
+	intr_set_level(old_level);
+}
+
 static uint64_t *pgdir_walk(uint64_t *pdp, const uint64_t va, int create) {
 	int idx = PDX(va);
 	if (pdp) {
+		if (pdp[idx] & PTE_PS)
+			huge_split(&pdp[idx]);
 		uint64_t *pte = (uint64_t *)pdp[idx];
 		if (!((uint64_t)pte & PTE_P)) {
 			if (create) {
@@ -116,6 +358,8 @@ static bool pt_for_each(uint64_t *pt, pte_for_each_func *func, void *aux,
 static bool pgdir_for_each(uint64_t *pdp, pte_for_each_func *func, void *aux,
 						   unsigned pml4_index, unsigned pdp_index) {
 	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
+		if (pdp[i] & PTE_PS)
+			huge_split(&pdp[i]);
 		uint64_t *pte = ptov((uint64_t *)pdp[i]);
 		if (((uint64_t)pte) & PTE_P)
 			if (!pt_for_each((uint64_t *)PTE_ADDR(pte), func, aux, pml4_index,
@@ -159,6 +403,8 @@ static void pt_destroy(uint64_t *pt) {
 
 static void pgdir_destroy(uint64_t *pdp) {
 	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
+		if (pdp[i] & PTE_PS)
+			huge_split(&pdp[i]);
 		uint64_t *pte = ptov((uint64_t *)pdp[i]);
 		if (((uint64_t)pte) & PTE_P)
 			pt_destroy(PTE_ADDR(pte));
@@ -182,6 +428,7 @@ void pml4_destroy(uint64_t *pml4) {
 	ASSERT(pml4 != base_pml4);
 
 	/* if PML4 (vaddr) >= 1, it's kernel space by define. */
+	pcid_release(pml4);
 	uint64_t *pdpe = ptov((uint64_t *)pml4[0]);
 	if (((uint64_t)pdpe) & PTE_P)
 		pdpe_destroy((void *)PTE_ADDR(pdpe));
@@ -189,8 +436,39 @@ void pml4_destroy(uint64_t *pml4) {
 }
 
 /* Loads page directory PD into the CPU's page directory base
- * register. */
-void pml4_activate(uint64_t *pml4) { lcr3(vtop(pml4 ? pml4 : base_pml4)); }
+ * register.  With PCIDs the load keeps the TLB, unless the PCID of
+ * PML4 may still hold stale entries. */
+void pml4_activate(uint64_t *pml4) {
+	enum intr_level old_level;
+	uint64_t pcid;
+	bool flush;
+
+	if (pml4 == NULL)
+		pml4 = base_pml4;
+
+	old_level = intr_disable();
+	if (!pcid_enabled) {
+		if (PTE_ADDR(rcr3()) != vtop(pml4)) {
+			lcr3(vtop(pml4));
+			cr3_load_cnt++;
+			tlb_flush_cnt++;
+		}
+	} else if (pml4 == base_pml4) {
+		if (PTE_ADDR(rcr3()) != vtop(pml4)) {
+			lcr3(vtop(pml4) | CR3_NOFLUSH);
+			cr3_load_cnt++;
+		}
+	} else {
+		pcid = pcid_get(pml4, &flush);
+		if (flush || PTE_ADDR(rcr3()) != vtop(pml4)) {
+			lcr3(vtop(pml4) | pcid | (flush ? 0 : CR3_NOFLUSH));
+			cr3_load_cnt++;
+			if (flush)
+				tlb_flush_cnt++;
+		}
+	}
+	intr_set_level(old_level);
+}
 
 /* Looks up the physical address that corresponds to user virtual
  * address UADDR in pml4.  Returns the kernel virtual address
@@ -206,6 +484,73 @@ void *pml4_get_page(uint64_t *pml4, const void *uaddr) {
 	return NULL;
 }
 
+/* Returns the page directory entry for user virtual address UADDR in
+ * PML4, or a null pointer if there is no page directory for it. */
+static uint64_t *pml4_pde(uint64_t *pml4, const void *uaddr) {
+	uint64_t *pdpe, *pd;
+
+	if (!(pml4[PML4(uaddr)] & PTE_P))
+		return NULL;
+	pdpe = ptov(PTE_ADDR(pml4[PML4(uaddr)]));
+	if (!(pdpe[PDPE(uaddr)] & PTE_P))
+		return NULL;
+	pd = ptov(PTE_ADDR(pdpe[PDPE(uaddr)]));
+	return &pd[PDX(uaddr)];
+}
+
+/* Maps the 2 MB of user virtual memory at UPAGE, which must be aligned
+ * to 2 MB, in PML4 with a single 2 MB page, if every page of it is
+ * mapped already, with the same permissions, to the page of an
+ * aligned, physically contiguous 2 MB of memory at the same offset.
+ * Returns true if successful, false if the pages are not mapped like
+ * that or too many 2 MB pages are mapped already. */
+bool pml4_collapse(uint64_t *pml4, void *upage) {
+	uint64_t *pde = pml4_pde(pml4, upage);
+	struct huge_slot *slot = NULL;
+	enum intr_level old_level;
+	uint64_t *pt;
+	uint64_t base, flags, bits = 0;
+	size_t i;
+
+	ASSERT((uint64_t)upage % HUGE_PGSIZE == 0);
+	ASSERT(is_user_vaddr(upage));
+	ASSERT(pml4 != base_pml4);
+
+	if (pde == NULL)
+		return false;
+
+	/* The page table must not change between the check and the switch. */
+	old_level = intr_disable();
+	if ((*pde & (PTE_P | PTE_PS)) != PTE_P)
+		goto done;
+	pt = ptov(PTE_ADDR(*pde));
+	base = PTE_ADDR(pt[0]);
+	flags = pt[0] & (PTE_P | PTE_W | PTE_U);
+	if (!(flags & PTE_P) || base % HUGE_PGSIZE != 0)
+		goto done;
+	for (i = 0; i < HUGE_PGCNT; i++) {
+		if (PTE_ADDR(pt[i]) != base + i * PGSIZE ||
+			(pt[i] & (PTE_P | PTE_W | PTE_U)) != flags)
+			goto done;
+		bits |= pt[i] & (PTE_A | PTE_D);
+	}
+	slot = huge_slot_find(NULL);
+	if (slot != NULL) {
+		slot->pde = pde;
+		slot->pt = pt;
+		*pde = base | flags | bits | PTE_PS;
+		huge_map_cnt++;
+	}
+
+done:
+	intr_set_level(old_level);
+	if (slot == NULL)
+		return false;
+	for (i = 0; i < HUGE_PGCNT; i++)
+		tlb_invalidate(pml4, (uint8_t *)upage + i * PGSIZE);
+	return true;
+}
+
 /* Adds a mapping in page map level 4 PML4 from user virtual page
  * UPAGE to the physical frame identified by kernel virtual address KPAGE.
  * UPAGE must not already be mapped. KPAGE should probably be a page obtained
@@ -222,8 +567,12 @@ bool pml4_set_page(uint64_t *pml4, void *upage, void *kpage, bool rw) {
 
 	uint64_t *pte = pml4e_walk(pml4, (uint64_t)upage, 1);
 
-	if (pte)
+	if (pte) {
+		bool was_present = (*pte & PTE_P) != 0;
 		*pte = vtop(kpage) | PTE_P | (rw ? PTE_W : 0) | PTE_U;
+		if (was_present)
+			tlb_invalidate(pml4, upage);
+	}
 	return pte != NULL;
 }
 
@@ -240,8 +589,7 @@ void pml4_clear_page(uint64_t *pml4, void *upage) {
 
 	if (pte != NULL && (*pte & PTE_P) != 0) {
 		*pte &= ~PTE_P;
-		if (rcr3() == vtop(pml4))
-			invlpg((uint64_t)upage);
+		tlb_invalidate(pml4, upage);
 	}
 }
 
@@ -264,8 +612,22 @@ void pml4_set_dirty(uint64_t *pml4, const void *vpage, bool dirty) {
 		else
 			*pte &= ~(uint32_t)PTE_D;
 
-		if (rcr3() == vtop(pml4))
-			invlpg((uint64_t)vpage);
+		tlb_invalidate(pml4, vpage);
+	}
+}
+
+/* Sets the user bit to USER in the PTE for virtual page VPAGE in PML4.
+ * Without it, the page is still mapped but only the kernel may access
+ * it: user accesses fault. */
+void pml4_set_user(uint64_t *pml4, const void *vpage, bool user) {
+	uint64_t *pte = pml4e_walk(pml4, (uint64_t)vpage, false);
+	if (pte) {
+		if (user)
+			*pte |= PTE_U;
+		else
+			*pte &= ~(uint64_t)PTE_U;
+
+		tlb_invalidate(pml4, vpage);
 	}
 }
 
@@ -288,7 +650,6 @@ void pml4_set_accessed(uint64_t *pml4, const void *vpage, bool accessed) {
 		else
 			*pte &= ~(uint32_t)PTE_A;
 
-		if (rcr3() == vtop(pml4))
-			invlpg((uint64_t)vpage);
+		tlb_invalidate(pml4, vpage);
 	}
 }
@@ -30,6 +30,9 @@
 struct pool {
 	struct lock lock;		 /* Mutual exclusion. */
 	struct bitmap *used_map; /* Bitmap of free pages. */
+#ifdef MEMSTAT
+	uint8_t *tag_map;		 /* enum mem_tag of each allocated page. */
+#endif
 	uint8_t *base;			 /* Base of pool. */
 };
 
@@ -253,17 +256,38 @@ uint64_t palloc_init(void) {
 	return ext_mem.end;
 }
 
-/* Obtains and returns a group of PAGE_CNT contiguous free pages.
-   If PAL_USER is set, the pages are obtained from the user pool,
-   otherwise from the kernel pool.  If PAL_ZERO is set in FLAGS,
-   then the pages are filled with zeros.  If too few pages are
-   available, returns a null pointer, unless PAL_ASSERT is set in
-   FLAGS, in which case the kernel panics. */
-void *palloc_get_multiple(enum palloc_flags flags, size_t page_cnt) {
+/* Returns the index of the first run of PAGE_CNT free pages in POOL
+   whose physical address is a multiple of ALIGN pages, or
+   BITMAP_ERROR if there is none.  An ALIGN of 1 takes the first fit
+   after the last allocation.  POOL's lock must be held. */
+static size_t scan_pool(struct pool *pool, size_t page_cnt, size_t align) {
+	size_t pool_cnt = bitmap_size(pool->used_map);
+	size_t page_idx;
+
+	if (align == 1)
+		return bitmap_scan_from_hint(pool->used_map, page_cnt, false);
+
+	page_idx = (align - pg_no(vtop(pool->base)) % align) % align;
+	for (; page_idx + page_cnt <= pool_cnt; page_idx += align)
+		if (bitmap_none(pool->used_map, page_idx, page_cnt))
+			return page_idx;
+	return BITMAP_ERROR;
+}
+
+/* Obtains PAGE_CNT contiguous free pages, aligned to ALIGN pages,
+   for palloc_get_multiple_tagged() and palloc_get_aligned_tagged(). */
+static void *get_pages(enum palloc_flags flags, size_t page_cnt, size_t align,
+					   enum mem_tag tag UNUSED) {
 	struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
 
 	lock_acquire(&pool->lock);
-	size_t page_idx = bitmap_scan_and_flip(pool->used_map, 0, page_cnt, false);
+	size_t page_idx = scan_pool(pool, page_cnt, align);
+	if (page_idx != BITMAP_ERROR) {
+		bitmap_set_multiple(pool->used_map, page_idx, page_cnt, true);
+#ifdef MEMSTAT
+		memset(pool->tag_map + page_idx, tag, page_cnt);
+#endif
+	}
 	lock_release(&pool->lock);
 	void *pages;
 
@@ -273,9 +297,11 @@ void *palloc_get_multiple(enum palloc_flags flags, size_t page_cnt) {
 		pages = NULL;
 
 	if (pages) {
+		memstat_add(tag, MEM_PAGES, page_cnt);
 		if (flags & PAL_ZERO)
 			memset(pages, 0, PGSIZE * page_cnt);
 	} else {
+		memstat_fail(tag, MEM_PAGES);
 		if (flags & PAL_ASSERT)
 			PANIC("palloc_get: out of pages");
 	}
@@ -283,15 +309,31 @@ void *palloc_get_multiple(enum palloc_flags flags, size_t page_cnt) {
 	return pages;
 }
 
-/* Obtains a single free page and returns its kernel virtual
-   address.
-   If PAL_USER is set, the page is obtained from the user pool,
+/* Obtains and returns a group of PAGE_CNT contiguous free pages,
+   charged to subsystem TAG.
+   If PAL_USER is set, the pages are obtained from the user pool,
    otherwise from the kernel pool.  If PAL_ZERO is set in FLAGS,
-   then the page is filled with zeros.  If no pages are
+   then the pages are filled with zeros.  If too few pages are
    available, returns a null pointer, unless PAL_ASSERT is set in
-   FLAGS, in which case the kernel panics. */
-void *palloc_get_page(enum palloc_flags flags) {
-	return palloc_get_multiple(flags, 1);
+   FLAGS, in which case the kernel panics.
+
+   palloc_get_page() and palloc_get_multiple() call this with the
+   tag of the calling subsystem. */
+void *palloc_get_multiple_tagged(enum palloc_flags flags, size_t page_cnt,
+								 enum mem_tag tag) {
+	return get_pages(flags, page_cnt, 1, tag);
+}
+
+/* Like palloc_get_multiple_tagged(), but the physical address of the
+   pages is a multiple of PAGE_CNT pages, which must be a power of 2,
+   so that they can be mapped with one large page.  Only aligned
+   runs are considered, so this fails far more often than an
+   unaligned request of the same size.  The pages may be freed one at
+   a time. */
+void *palloc_get_aligned_tagged(enum palloc_flags flags, size_t page_cnt,
+								enum mem_tag tag) {
+	ASSERT(page_cnt > 0 && (page_cnt & (page_cnt - 1)) == 0);
+	return get_pages(flags, page_cnt, page_cnt, tag);
 }
 
 /* Frees the PAGE_CNT pages starting at PAGES. */
@@ -316,29 +358,46 @@ void palloc_free_multiple(void *pages, size_t page_cnt) {
 	memset(pages, 0xcc, PGSIZE * page_cnt);
 #endif
 	ASSERT(bitmap_all(pool->used_map, page_idx, page_cnt));
+	memstat_sub(pool->tag_map[page_idx], MEM_PAGES, page_cnt);
 	bitmap_set_multiple(pool->used_map, page_idx, page_cnt, false);
 }
 
 /* Frees the page at PAGE. */
 void palloc_free_page(void *page) { palloc_free_multiple(page, 1); }
 
+/* Returns the first page of the user pool, and stores the number
+   of pages in the pool in *PAGE_CNT.  Every page that
+   palloc_get_page(PAL_USER) returns lies in that range. */
+void *palloc_user_pool(size_t *page_cnt) {
+	*page_cnt = bitmap_size(user_pool.used_map);
+	return user_pool.base;
+}
+
 /* Initializes pool P as starting at START and ending at END */
 static void init_pool(struct pool *p, void **bm_base, uint64_t start,
 					  uint64_t end) {
-	/* We'll put the pool's used_map at its base.
-	   Calculate the space needed for the bitmap
-	   and subtract it from the pool's size. */
+	/* We'll put the pool's used_map at its base, followed by
+	   its tag_map if memory is accounted.  Calculate the space
+	   needed for both and subtract it from the pool's size. */
 	uint64_t pgcnt = (end - start) / PGSIZE;
 	size_t bm_pages = DIV_ROUND_UP(bitmap_buf_size(pgcnt), PGSIZE) * PGSIZE;
+#ifdef MEMSTAT
+	size_t tm_pages = DIV_ROUND_UP(pgcnt, PGSIZE) * PGSIZE;
+#else
+	size_t tm_pages = 0;
+#endif
 
 	lock_init(&p->lock);
 	p->used_map = bitmap_create_in_buf(pgcnt, *bm_base, bm_pages);
+#ifdef MEMSTAT
+	p->tag_map = (uint8_t *)*bm_base + bm_pages;
+#endif
 	p->base = (void *)start;
 
 	// Mark all to unusable.
 	bitmap_set_all(p->used_map, true);
 
-	*bm_base += bm_pages;
+	*bm_base += bm_pages + tm_pages;
 }
 
 /* Returns true if PAGE was allocated from POOL,
@@ -119,6 +119,11 @@ static void page_fault(struct intr_frame *f) {
 	bool write;		  /* True: access was write, false: access was read. */
 	bool user;		  /* True: access by user, false: access by kernel. */
 	void *fault_addr; /* Fault address. */
+#ifdef VM
+	bool handled; /* True: resolved by the virtual memory system. */
+
+	FAULT_PROF_BEGIN();
+#endif
 
 	/* Obtain faulting address, the virtual address that was
 	   accessed to cause the fault.  It may point to code or to
@@ -138,7 +143,9 @@ static void page_fault(struct intr_frame *f) {
 
 #ifdef VM
 	/* For project 3 and later. */
-	if (vm_try_handle_fault(f, fault_addr, user, write, not_present))
+	handled = vm_try_handle_fault(f, fault_addr, user, write, not_present);
+	FAULT_PROF_END(handled);
+	if (handled)
 		return;
 #endif
 
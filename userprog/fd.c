@@ -110,6 +110,21 @@ unsigned fd_tell(int fd, fd_list fd_list) {
 	return file_tell(file);
 }
 
+/* Returns the file open as FD, or NULL if FD is not open or is the
+ * console. */
+struct file *fd_get_file(int fd, fd_list fd_list) {
+	struct file *file;
+
+	if (!check_fd(fd)) {
+		return NULL;
+	}
+	file = fd_list[fd];
+	if (file == stdin || file == stdout) {
+		return NULL;
+	}
+	return file;
+}
+
 void fd_close(int fd, fd_list fd_list) {
 	struct file *file;
 	int ret;
@@ -10,8 +10,10 @@
 #include "filesys/directory.h"
 #include "filesys/file.h"
 #include "filesys/filesys.h"
+#include "filesys/inode.h"
 #include "threads/flags.h"
 #include "threads/init.h"
+#include "threads/malloc.h"
 #include "threads/interrupt.h"
 #include "threads/palloc.h"
 #include "threads/thread.h"
@@ -27,6 +29,7 @@ static void process_cleanup(void);
 static bool load(const char *file_name, struct intr_frame *if_);
 static void initd(void *f_name);
 static void __do_fork(void *);
+static void __do_spawn(void *);
 
 /* Struct for give argument to __do_fork */
 static struct process_fork_arg {
@@ -36,6 +39,22 @@ static struct process_fork_arg {
 	int fork_result;
 };
 
+/* Struct for give argument to __do_spawn */
+struct process_spawn_arg {
+	char *cmd_line;
+	const struct spawn_action *actions;
+	size_t action_cnt;
+	struct thread *parent;
+	struct semaphore spawn_done;
+	tid_t spawn_result;
+};
+
+/* The descriptors a child of spawn() gets when the caller names none. */
+static const struct spawn_action console_actions[] = {
+	{STDIN_FILENO, STDIN_FILENO},
+	{STDOUT_FILENO, STDOUT_FILENO},
+};
+
 /* Similar macro to is_thread and running_thread */
 #define is_process(p) ((p) != NULL && (p)->magic == PROCESS_MAGIC)
 #define running_process() ((struct process *)(pg_round_down(rrsp())))
@@ -64,6 +83,7 @@ void process_init_in_thread_init(struct process *new) {
 
 	sema_init(&new->parent_waited, 0);
 	sema_init(&new->exist_status_setted, 0);
+	new->wait_sema = NULL;
 	lock_init(&new->data_access_lock);
 
 	list_init(&new->child_list);
@@ -83,6 +103,7 @@ void process_init_of_initial_thread(void) {
 
 	sema_init(&current->parent_waited, 1);
 	sema_init(&current->exist_status_setted, 0);
+	current->wait_sema = NULL;
 	lock_init(&current->data_access_lock);
 
 	list_init(&current->child_list);
@@ -271,6 +292,139 @@ error:
 	thread_exit();
 }
 
+/* Starts a new process running CMD_LINE, a page that this function
+ * frees, as a child of the current one.  Unlike fork() and exec(), the
+ * child is loaded straight from the executable: the caller's address
+ * space is not copied, and the child gets only the descriptors that
+ * the ACTION_CNT ACTIONS name, or the console if there are none.
+ * ACTIONS may be in user memory.  Returns the child's thread id once it
+ * is loaded, or TID_ERROR if it cannot be. */
+tid_t process_spawn(char *cmd_line, const struct spawn_action *actions,
+					size_t action_cnt) {
+	struct process_spawn_arg spawn_arg;
+	char name[sizeof spawn_arg.parent->name];
+	struct spawn_action *actions_copy = NULL;
+	char *temp_ptr;
+	size_t i;
+	tid_t tid;
+
+	/* The child cannot see the parent's user memory, nor tell it that a
+	 * descriptor is bad without exiting first. */
+	if (action_cnt == 0) {
+		actions = console_actions;
+		action_cnt = sizeof console_actions / sizeof *console_actions;
+	} else {
+		actions_copy = malloc(action_cnt * sizeof *actions_copy);
+		if (actions_copy == NULL) {
+			palloc_free_page(cmd_line);
+			return TID_ERROR;
+		}
+		memcpy(actions_copy, actions, action_cnt * sizeof *actions_copy);
+		actions = actions_copy;
+	}
+	for (i = 0; i < action_cnt; i++) {
+		const struct spawn_action *a = &actions[i];
+
+		if (a->parent_fd < 0 || a->parent_fd >= FDSIZE || a->child_fd < 0 ||
+			a->child_fd >= FDSIZE ||
+			(*process_current()->fd_list)[a->parent_fd] == NULL) {
+			palloc_free_page(cmd_line);
+			free(actions_copy);
+			return TID_ERROR;
+		}
+	}
+
+	strlcpy(name, cmd_line, sizeof name);
+	temp_ptr = strchr(name, ' ');
+	if (temp_ptr) {
+		*temp_ptr = '\0';
+	}
+
+	spawn_arg.cmd_line = cmd_line;
+	spawn_arg.actions = actions;
+	spawn_arg.action_cnt = action_cnt;
+	spawn_arg.parent = thread_current();
+	sema_init(&spawn_arg.spawn_done, 0);
+
+	tid = thread_create(name, PRI_DEFAULT, __do_spawn, &spawn_arg);
+	if (tid == TID_ERROR) {
+		palloc_free_page(cmd_line);
+	} else {
+		sema_down(&spawn_arg.spawn_done);
+		tid = spawn_arg.spawn_result;
+	}
+	free(actions_copy);
+	return tid;
+}
+
+/* Gives the current process the descriptors of PARENT that the
+ * ACTION_CNT ACTIONS name, which process_spawn() checked are open.
+ * Returns false if memory runs out. */
+static bool spawn_fds(struct process *parent,
+					  const struct spawn_action *actions, size_t action_cnt) {
+	struct process *current = process_current();
+	struct file *file;
+	size_t i;
+
+	for (i = 0; i < action_cnt; i++) {
+		const struct spawn_action *a = &actions[i];
+
+		file = file_duplicate((*parent->fd_list)[a->parent_fd]);
+		if (file == NULL)
+			return false;
+		fd_close(a->child_fd, *current->fd_list);
+		(*current->fd_list)[a->child_fd] = file;
+	}
+	return true;
+}
+
+/* A thread function that loads the program for process_spawn(). */
+static void __do_spawn(void *aux) {
+	struct process_spawn_arg *spawn_arg = (struct process_spawn_arg *)aux;
+	struct process *parent_process = (struct process *)spawn_arg->parent;
+	struct process *current_process = process_current();
+	struct intr_frame if_;
+	bool success;
+
+	if_.ds = if_.es = if_.ss = SEL_UDSEG;
+	if_.cs = SEL_UCSEG;
+	if_.eflags = FLAG_IF | FLAG_MBS;
+
+#ifdef VM
+	supplemental_page_table_init(&thread_current()->spt);
+#endif
+
+	/* Load before becoming a process, so that a child that fails to load
+	 * does not print an exit message. */
+	success = load(spawn_arg->cmd_line, &if_);
+	palloc_free_page(spawn_arg->cmd_line);
+	if (!success)
+		goto error;
+
+	process_init();
+	if (!current_process->fd_list ||
+		!spawn_fds(parent_process, spawn_arg->actions, spawn_arg->action_cnt)) {
+		current_process->exist_status = -1;
+		goto error;
+	}
+
+	spawn_arg->spawn_result = current_process->thread.tid;
+	sema_up(&spawn_arg->spawn_done);
+	do_iret(&if_);
+	NOT_REACHED();
+
+error:
+	spawn_arg->spawn_result = TID_ERROR;
+	sema_up(&current_process->parent_waited);
+
+	lock_acquire(&parent_process->data_access_lock);
+	list_remove(&current_process->child_elem);
+	lock_release(&parent_process->data_access_lock);
+
+	sema_up(&spawn_arg->spawn_done);
+	thread_exit();
+}
+
 /* Switch the current execution context to the f_name.
  * Returns -1 on fail. */
 int process_exec(void *f_name) {
@@ -317,6 +471,8 @@ int process_wait(tid_t child_tid) {
 	// temp code for check execution result of child process
 	struct process *current, *child, *temp_child;
 	struct list_elem *child_elem;
+	enum intr_level old_level;
+	bool killed = false;
 	int exist_status;
 
 	current = process_current();
@@ -336,7 +492,28 @@ int process_wait(tid_t child_tid) {
 	if (!child) {
 		return -1;
 	}
-	sema_down(&child->exist_status_setted);
+
+	/* Interrupts are off while WAIT_SEMA is set up, so that
+	 * process_wake() either sees it or comes before the check. */
+	old_level = intr_disable();
+	current->wait_sema = &child->exist_status_setted;
+#ifdef VM
+	killed = current->thread.spt.oom_killed;
+#endif
+	intr_set_level(old_level);
+	if (!killed)
+		sema_down(&child->exist_status_setted);
+	current->wait_sema = NULL;
+
+#ifdef VM
+	/* Killed for lack of memory while waiting: give up on the child and
+	 * exit, so that the memory is given back now. */
+	if (current->thread.spt.oom_killed) {
+		sema_up(&child->parent_waited);
+		current->exist_status = -1;
+		thread_exit();
+	}
+#endif
 	exist_status = child->exist_status;
 	sema_up(&child->parent_waited);
 	return exist_status;
@@ -353,6 +530,9 @@ void process_exit(void) {
 	/* Check this thread did process_init() */
 	if (curr->is_process) {
 		printf("%s: exit(%d)\n", curr->thread.name, curr->exist_status);
+#ifdef VM
+		vm_print_memstat();
+#endif
 		sema_up(&curr->exist_status_setted);
 
 		fd_close_all(curr->fd_list);
@@ -464,63 +644,164 @@ static bool load_segment(struct file *file, off_t ofs, uint8_t *upage,
 						 uint32_t read_bytes, uint32_t zero_bytes,
 						 bool writable);
 
-/* Loads an ELF executable from FILE_NAME into the current thread.
- * Stores the executable's entry point into *RIP
- * and its initial stack pointer into *RSP.
- * Returns true if successful, false otherwise. */
-static bool load(const char *file_name, struct intr_frame *if_) {
-	struct thread *t = thread_current();
-	struct process *p = process_current();
-	struct ELF ehdr;
-	struct file *file = NULL;
-	off_t file_ofs;
-	bool success = false;
-	int i;
-	char *temp_ptr;
+/* A loadable segment of an executable, in the terms of load_segment(). */
+struct exec_segment {
+	uint64_t file_page;
+	uint64_t mem_page;
+	uint32_t read_bytes;
+	uint32_t zero_bytes;
+	bool writable;
+};
 
-	/* Allocate and activate page directory. */
-	t->pml4 = pml4_create();
-	if (t->pml4 == NULL)
-		goto done;
-	process_activate(thread_current());
+/* The layout of an executable as its ELF headers give it: where it starts
+ * and which segments to load. */
+struct exec_image {
+	struct list_elem elem;		 /* Element in exec_cache. */
+	struct inode *inode;		 /* Executable, kept open by the cache. */
+	unsigned write_cnt;			 /* inode_write_cnt() when it was read. */
+	uint64_t entry;				 /* Entry point. */
+	size_t seg_cnt;				 /* Number of segments. */
+	struct exec_segment segs[]; /* Segments to load. */
+};
 
-	/* Open executable file. */
-	temp_ptr = strchr(file_name, ' ');
-	if (temp_ptr) {
-		*temp_ptr = '\0';
-	}
-	file = filesys_open(file_name);
-	if (file == NULL) {
-		printf("load: %s: open failed\n", file_name);
-		goto done;
-	}
-	p->loaded_file = file;
-	file_deny_write(file);
-	if (temp_ptr) {
-		*temp_ptr = ' ';
+#define EXEC_CACHE_SIZE 16 /* Most executables to keep the layout of. */
+
+/* Layouts of executables run lately, most recent first, so that running
+ * the same program again does not read its headers again.  An entry is
+ * dropped when its executable is written to or removed. */
+static struct list exec_cache;
+static struct lock exec_cache_lock;
+static size_t exec_cache_cnt;
+
+/* Statistics. */
+static long long exec_hit_cnt;	 /* # of execs that found their layout. */
+static long long exec_miss_cnt;	 /* # of execs that read it. */
+static long long exec_stale_cnt; /* # of layouts dropped as out of date. */
+
+/* Read the headers at every exec? */
+bool exec_cache_disabled;
+
+/* Returns the size of an exec_image with SEG_CNT segments. */
+static size_t image_size(size_t seg_cnt) {
+	return sizeof(struct exec_image) + seg_cnt * sizeof(struct exec_segment);
+}
+
+/* Drops IMAGE from the cache and frees it. */
+static void exec_cache_drop(struct exec_image *image) {
+	list_remove(&image->elem);
+	exec_cache_cnt--;
+	inode_close(image->inode);
+	free(image);
+}
+
+/* Returns a copy of the layout of the executable INODE that the caller
+ * must free, or a null pointer if the cache does not have it. */
+static struct exec_image *exec_cache_get(struct inode *inode) {
+	struct exec_image *copy = NULL;
+	struct list_elem *e, *next;
+
+	if (exec_cache_disabled)
+		return NULL;
+
+	lock_acquire(&exec_cache_lock);
+	for (e = list_begin(&exec_cache); e != list_end(&exec_cache); e = next) {
+		struct exec_image *image = list_entry(e, struct exec_image, elem);
+
+		next = list_next(e);
+		if (inode_is_removed(image->inode) ||
+			inode_write_cnt(image->inode) != image->write_cnt) {
+			exec_cache_drop(image);
+			exec_stale_cnt++;
+		} else if (image->inode == inode && copy == NULL) {
+			copy = malloc(image_size(image->seg_cnt));
+			if (copy != NULL) {
+				memcpy(copy, image, image_size(image->seg_cnt));
+				list_remove(e);
+				list_push_front(&exec_cache, e);
+			}
+		}
 	}
+	if (copy != NULL)
+		exec_hit_cnt++;
+	else
+		exec_miss_cnt++;
+	lock_release(&exec_cache_lock);
+	return copy;
+}
+
+/* Enters IMAGE, just read from the executable INODE, into the cache,
+ * making room if it is full. */
+static void exec_cache_put(struct inode *inode, const struct exec_image *image) {
+	struct exec_image *entry;
+
+	if (exec_cache_disabled)
+		return;
+	entry = malloc(image_size(image->seg_cnt));
+	if (entry == NULL)
+		return;
+	memcpy(entry, image, image_size(image->seg_cnt));
+	entry->inode = inode_reopen(inode);
+
+	lock_acquire(&exec_cache_lock);
+	if (exec_cache_cnt == EXEC_CACHE_SIZE)
+		exec_cache_drop(
+			list_entry(list_back(&exec_cache), struct exec_image, elem));
+	list_push_front(&exec_cache, &entry->elem);
+	exec_cache_cnt++;
+	lock_release(&exec_cache_lock);
+}
+
+/* Initializes the exec cache. */
+void process_init_exec_cache(void) {
+	list_init(&exec_cache);
+	lock_init(&exec_cache_lock);
+}
+
+/* Prints statistics about the exec cache. */
+void process_print_stats(void) {
+	printf("Exec: %lld layouts cached, %lld read, %lld out of date\n",
+		   exec_hit_cnt, exec_miss_cnt, exec_stale_cnt);
+}
+
+/* Reads the ELF headers of FILE, the executable FILE_NAME, and returns its
+ * layout, which the caller must free, or a null pointer if it is not an
+ * executable that can be loaded. */
+static struct exec_image *read_image(struct file *file, const char *file_name) {
+	struct exec_image *image;
+	struct ELF ehdr;
+	off_t file_ofs;
+	int i;
 
 	/* Read and verify executable header. */
+	file_seek(file, 0);
 	if (file_read(file, &ehdr, sizeof ehdr) != sizeof ehdr ||
 		memcmp(ehdr.e_ident, "\177ELF\2\1\1", 7) || ehdr.e_type != 2 ||
 		ehdr.e_machine != 0x3E // amd64
 		|| ehdr.e_version != 1 || ehdr.e_phentsize != sizeof(struct Phdr) ||
 		ehdr.e_phnum > 1024) {
 		printf("load: %s: error loading executable\n", file_name);
-		goto done;
+		return NULL;
 	}
 
+	image = malloc(image_size(ehdr.e_phnum));
+	if (image == NULL)
+		return NULL;
+	image->inode = file_get_inode(file);
+	image->write_cnt = inode_write_cnt(image->inode);
+	image->entry = ehdr.e_entry;
+	image->seg_cnt = 0;
+
 	/* Read program headers. */
 	file_ofs = ehdr.e_phoff;
 	for (i = 0; i < ehdr.e_phnum; i++) {
 		struct Phdr phdr;
 
 		if (file_ofs < 0 || file_ofs > file_length(file))
-			goto done;
+			goto error;
 		file_seek(file, file_ofs);
 
 		if (file_read(file, &phdr, sizeof phdr) != sizeof phdr)
-			goto done;
+			goto error;
 		file_ofs += sizeof phdr;
 		switch (phdr.p_type) {
 		case PT_NULL:
@@ -533,41 +814,106 @@ static bool load(const char *file_name, struct intr_frame *if_) {
 		case PT_DYNAMIC:
 		case PT_INTERP:
 		case PT_SHLIB:
-			goto done;
+			goto error;
 		case PT_LOAD:
 			if (validate_segment(&phdr, file)) {
-				bool writable = (phdr.p_flags & PF_W) != 0;
-				uint64_t file_page = phdr.p_offset & ~PGMASK;
-				uint64_t mem_page = phdr.p_vaddr & ~PGMASK;
+				struct exec_segment *seg = &image->segs[image->seg_cnt++];
 				uint64_t page_offset = phdr.p_vaddr & PGMASK;
-				uint32_t read_bytes, zero_bytes;
+
+				seg->writable = (phdr.p_flags & PF_W) != 0;
+				seg->file_page = phdr.p_offset & ~PGMASK;
+				seg->mem_page = phdr.p_vaddr & ~PGMASK;
 				if (phdr.p_filesz > 0) {
 					/* Normal segment.
 					 * Read initial part from disk and zero the rest. */
-					read_bytes = page_offset + phdr.p_filesz;
-					zero_bytes = (ROUND_UP(page_offset + phdr.p_memsz, PGSIZE) -
-								  read_bytes);
+					seg->read_bytes = page_offset + phdr.p_filesz;
+					seg->zero_bytes =
+						(ROUND_UP(page_offset + phdr.p_memsz, PGSIZE) -
+						 seg->read_bytes);
 				} else {
 					/* Entirely zero.
 					 * Don't read anything from disk. */
-					read_bytes = 0;
-					zero_bytes = ROUND_UP(page_offset + phdr.p_memsz, PGSIZE);
+					seg->read_bytes = 0;
+					seg->zero_bytes = ROUND_UP(page_offset + phdr.p_memsz, PGSIZE);
 				}
-				if (!load_segment(file, file_page, (void *)mem_page, read_bytes,
-								  zero_bytes, writable))
-					goto done;
 			} else
-				goto done;
+				goto error;
 			break;
 		}
 	}
+	return image;
+
+error:
+	free(image);
+	return NULL;
+}
+
+/* Loads an ELF executable from FILE_NAME into the current thread.
+ * Stores the executable's entry point into *RIP
+ * and its initial stack pointer into *RSP.
+ * Returns true if successful, false otherwise. */
+static bool load(const char *file_name, struct intr_frame *if_) {
+	struct thread *t = thread_current();
+	struct process *p = process_current();
+	struct exec_image *image = NULL;
+	struct file *file = NULL;
+	bool success = false;
+	size_t i;
+	char *temp_ptr;
+
+	/* Allocate and activate page directory. */
+	t->pml4 = pml4_create();
+	if (t->pml4 == NULL)
+		goto done;
+	process_activate(thread_current());
+
+	/* Open executable file. */
+	temp_ptr = strchr(file_name, ' ');
+	if (temp_ptr) {
+		*temp_ptr = '\0';
+	}
+	file = filesys_open(file_name);
+	if (file == NULL) {
+		printf("load: %s: open failed\n", file_name);
+		goto done;
+	}
+	p->loaded_file = file;
+	file_deny_write(file);
+	if (temp_ptr) {
+		*temp_ptr = ' ';
+	}
+
+	/* Find the layout of the executable, reading it in only if the cache
+	 * does not have it. */
+	image = exec_cache_get(file_get_inode(file));
+	if (image == NULL) {
+		image = read_image(file, file_name);
+		if (image == NULL)
+			goto done;
+		exec_cache_put(file_get_inode(file), image);
+	}
+
+	for (i = 0; i < image->seg_cnt; i++) {
+		const struct exec_segment *seg = &image->segs[i];
+
+		if (!load_segment(file, seg->file_page, (void *)seg->mem_page,
+						  seg->read_bytes, seg->zero_bytes, seg->writable))
+			goto done;
+#ifdef VM
+		/* The heap starts right after the last segment. */
+		if ((void *)(seg->mem_page + seg->read_bytes + seg->zero_bytes) >
+			t->spt.heap_start)
+			t->spt.heap_start = t->spt.brk =
+				(void *)(seg->mem_page + seg->read_bytes + seg->zero_bytes);
+#endif
+	}
 
 	/* Set up stack. */
 	if (!setup_stack(if_))
 		goto done;
 
 	/* Start address. */
-	if_->rip = ehdr.e_entry;
+	if_->rip = image->entry;
 
 	/* TODO: Your code goes here.
 	 * TODO: Implement argument passing (see project2/argument_passing.html). */
@@ -613,7 +959,9 @@ done:
 	if (!success && p->loaded_file) {
 		file_allow_write(p->loaded_file);
 		file_close(p->loaded_file);
+		p->loaded_file = NULL;
 	}
+	free(image);
 	return success;
 }
 
@@ -762,10 +1110,34 @@ static bool install_page(void *upage, void *kpage, bool writable) {
  * If you want to implement the function for only project 2, implement it on the
  * upper block. */
 
+/* Where lazy_load_segment() finds the contents of a page: READ_BYTES bytes
+ * at offset OFS of the executable, and zeros after them.  Both are packed
+ * into the aux pointer itself, so that fork can hand it to the child as is
+ * and nothing has to be freed if the page is never touched. */
+#define SEGMENT_AUX(OFS, READ_BYTES)                                           \
+	((void *)(((uint64_t)(OFS) << 16) | (READ_BYTES)))
+#define SEGMENT_AUX_OFS(AUX) ((off_t)((uint64_t)(AUX) >> 16))
+#define SEGMENT_AUX_READ_BYTES(AUX) ((size_t)((uint64_t)(AUX)&0xffff))
+
 static bool lazy_load_segment(struct page *page, void *aux) {
-	/* TODO: Load the segment from the file */
-	/* TODO: This called when the first page fault occurs on address VA. */
-	/* TODO: VA is available when calling this function. */
+	struct file *file = process_current()->loaded_file;
+	void *kva = page->frame->kva;
+	off_t ofs = SEGMENT_AUX_OFS(aux);
+	size_t read_bytes = SEGMENT_AUX_READ_BYTES(aux);
+
+	/* The executable is the one of the process that faults, which also
+	 * keeps a forked child away from its parent's file. */
+	if (file_read_at(file, kva, read_bytes, ofs) != (int)read_bytes)
+		return false;
+	memset(kva + read_bytes, 0, PGSIZE - read_bytes);
+
+	/* Other processes running the same executable may map a read-only
+	 * page as it is. */
+	if (!page->writable) {
+		struct text_key key = {file_get_inode(file), ofs, read_bytes};
+		vm_text_insert(page, &key);
+	}
+	return true;
 }
 
 /* Loads a segment starting at offset OFS in FILE at address
@@ -780,6 +1152,11 @@ static bool lazy_load_segment(struct page *page, void *aux) {
  * The pages initialized by this function must be writable by the
  * user process if WRITABLE is true, read-only otherwise.
  *
+ * Nothing is read here: every page is created lazy, and the whole
+ * segment goes into the supplemental page table in one bulk insert.
+ * Pages of a read-only segment that another process running FILE has
+ * read in already are mapped to the same frames right away.
+ *
  * Return true if successful, false if a memory allocation error
  * or disk read error occurs. */
 static bool load_segment(struct file *file, off_t ofs, uint8_t *upage,
@@ -789,25 +1166,56 @@ static bool load_segment(struct file *file, off_t ofs, uint8_t *upage,
 	ASSERT(pg_ofs(upage) == 0);
 	ASSERT(ofs % PGSIZE == 0);
 
-	while (read_bytes > 0 || zero_bytes > 0) {
+	size_t page_cnt = (read_bytes + zero_bytes) / PGSIZE;
+	struct page **pages;
+	size_t i;
+	bool success = false;
+
+	if (page_cnt == 0)
+		return true;
+	pages = calloc(page_cnt, sizeof *pages);
+	if (pages == NULL)
+		return false;
+
+	for (i = 0; i < page_cnt; i++) {
 		/* Do calculate how to fill this page.
 		 * We will read PAGE_READ_BYTES bytes from FILE
 		 * and zero the final PAGE_ZERO_BYTES bytes. */
 		size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
-		size_t page_zero_bytes = PGSIZE - page_read_bytes;
 
-		/* TODO: Set up aux to pass information to the lazy_load_segment. */
-		void *aux = NULL;
-		if (!vm_alloc_page_with_initializer(VM_ANON, upage, writable,
-											lazy_load_segment, aux))
-			return false;
+		/* A page with nothing to read is plain zero-fill memory, which a
+		 * read fault can map to the zero page. */
+		if (page_read_bytes > 0)
+			pages[i] = vm_new_page(VM_ANON, upage, writable, lazy_load_segment,
+								   SEGMENT_AUX(ofs, page_read_bytes));
+		else
+			pages[i] = vm_new_page(VM_ANON, upage, writable, NULL, NULL);
+		if (pages[i] == NULL)
+			goto done;
 
 		/* Advance. */
 		read_bytes -= page_read_bytes;
-		zero_bytes -= page_zero_bytes;
+		ofs += page_read_bytes;
 		upage += PGSIZE;
 	}
-	return true;
+	success = spt_insert_pages(&thread_current()->spt, pages, page_cnt);
+
+	if (success && !writable)
+		for (i = 0; i < page_cnt; i++) {
+			void *aux = pages[i]->uninit.aux;
+			struct text_key key = {file_get_inode(file), SEGMENT_AUX_OFS(aux),
+								   SEGMENT_AUX_READ_BYTES(aux)};
+
+			if (pages[i]->uninit.init != NULL)
+				vm_text_map(pages[i], &key);
+		}
+
+done:
+	if (!success)
+		for (i = 0; i < page_cnt && pages[i] != NULL; i++)
+			vm_dealloc_page(pages[i]);
+	free(pages);
+	return success;
 }
 
 /* Create a PAGE of stack at the USER_STACK. Return true on success. */
@@ -815,10 +1223,14 @@ static bool setup_stack(struct intr_frame *if_) {
 	bool success = false;
 	void *stack_bottom = (void *)(((uint8_t *)USER_STACK) - PGSIZE);
 
-	/* TODO: Map the stack on stack_bottom and claim the page immediately.
-	 * TODO: If success, set the rsp accordingly.
-	 * TODO: You should mark the page is stack. */
-	/* TODO: Your code goes here */
+	/* The stack is touched right away by argument passing, so there is
+	 * no point in faulting it in. */
+	if (vm_alloc_page(VM_ANON | VM_MARKER_0, stack_bottom, true) &&
+		vm_claim_page(stack_bottom)) {
+		if_->rsp = USER_STACK;
+		thread_current()->spt.stack_bottom = stack_bottom;
+		success = true;
+	}
 
 	return success;
 }
@@ -832,4 +1244,17 @@ struct process *process_current(void) {
 	ASSERT(p->thread.status == THREAD_RUNNING);
 
 	return p;
-}
\ No newline at end of file
+}
+/* Wakes up the process of T if it is blocked in process_wait(), so that it
+ * notices it has been killed and exits instead of waiting on. */
+void process_wake(struct thread *t) {
+	struct process *p = (struct process *)t;
+	enum intr_level old_level;
+
+	ASSERT(is_process(p));
+
+	old_level = intr_disable();
+	if (p->wait_sema != NULL)
+		sema_up(p->wait_sema);
+	intr_set_level(old_level);
+}
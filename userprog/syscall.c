@@ -12,6 +12,10 @@
 #include "userprog/process.h"
 #include <string.h>
 #include "threads/palloc.h"
+#ifdef VM
+#include <mman.h>
+#include "vm/vm.h"
+#endif
 
 void syscall_entry(void);
 void syscall_handler(struct intr_frame *);
@@ -42,6 +46,17 @@ void syscall_init(void) {
 			  FLAG_IF | FLAG_TF | FLAG_DF | FLAG_IOPL | FLAG_AC | FLAG_NT);
 }
 
+#ifdef VM
+/* Exits the current process, CURR, if the out-of-memory killer chose it,
+ * so that it gives its memory back without waiting for its next fault. */
+static void oom_check(struct process *curr) {
+	if (curr->thread.spt.oom_killed) {
+		curr->exist_status = -1;
+		thread_exit();
+	}
+}
+#endif
+
 void syscall_check_vaddr(uint64_t va, struct process *curr) {
 	int temp;
 	if (!is_user_vaddr(va)) {
@@ -62,6 +77,13 @@ void syscall_check_vaddr(uint64_t va, struct process *curr) {
 */
 void syscall_handler(struct intr_frame *f) {
 	struct process *current = process_current();
+
+#ifdef VM
+	/* A page fault in the kernel on behalf of the process may need it to
+	 * tell stack growth from a bad access. */
+	thread_current()->user_rsp = f->rsp;
+	oom_check(current);
+#endif
 	// Projects 2 syscall
 	switch (f->R.rax) {
 	case SYS_HALT:
@@ -129,10 +151,67 @@ void syscall_handler(struct intr_frame *f) {
 	case SYS_DUP2:
 		f->R.rax = fd_dup2(f->R.rdi, f->R.rsi, *current->fd_list);
 		break;
+	case SYS_SPAWN: {
+		size_t action_cnt = f->R.rdx;
+		char *cmd_copy;
+
+		syscall_check_vaddr(f->R.rdi, current);
+		if (action_cnt > FDSIZE) {
+			f->R.rax = TID_ERROR;
+			break;
+		}
+		if (action_cnt > 0) {
+			syscall_check_vaddr(f->R.rsi, current);
+			syscall_check_vaddr(
+				f->R.rsi + action_cnt * sizeof(struct spawn_action) - 1, current);
+		}
+		cmd_copy = palloc_get_page(0);
+		if (cmd_copy == NULL) {
+			f->R.rax = TID_ERROR;
+			break;
+		}
+		strlcpy(cmd_copy, (const char *)f->R.rdi, PGSIZE);
+		f->R.rax = process_spawn(cmd_copy, (const void *)f->R.rsi, action_cnt);
+		break;
+	}
 
 	// Projects 3 syscall
+#ifdef VM
+	case SYS_MMAP:
+		f->R.rax = (uint64_t)do_mmap((void *)f->R.rdi, f->R.rsi, f->R.rdx,
+									 fd_get_file(f->R.r10, *current->fd_list),
+									 f->R.r8);
+		break;
+	case SYS_MUNMAP:
+		do_munmap((void *)f->R.rdi);
+		break;
+	case SYS_MADVISE:
+		f->R.rax = vm_madvise((void *)f->R.rdi, f->R.rsi, f->R.rdx);
+		break;
+	case SYS_MSYNC:
+		f->R.rax = do_msync((void *)f->R.rdi, f->R.rsi, f->R.rdx);
+		break;
+	case SYS_MEMSTAT: {
+		struct memstat st;
+
+		syscall_check_vaddr(f->R.rdi, current);
+		syscall_check_vaddr(f->R.rdi + sizeof st - 1, current);
+		vm_memstat(&st);
+		memcpy((void *)f->R.rdi, &st, sizeof st);
+		f->R.rax = 0;
+		break;
+	}
+	case SYS_BRK:
+		f->R.rax = (uint64_t)vm_brk((void *)f->R.rdi);
+		break;
+#else
 	case SYS_MMAP:
 	case SYS_MUNMAP:
+	case SYS_MADVISE:
+	case SYS_MSYNC:
+	case SYS_MEMSTAT:
+	case SYS_BRK:
+#endif
 
 	// Projects 4 syscall
 	case SYS_CHDIR:
@@ -147,4 +226,9 @@ void syscall_handler(struct intr_frame *f) {
 		printf("system call %lld not maid\n", f->R.rax);
 		thread_exit();
 	}
+
+#ifdef VM
+	/* Chosen while in the system call, blocked or not. */
+	oom_check(current);
+#endif
 }
@@ -2,6 +2,8 @@
 
 #include "vm/vm.h"
 #include "devices/disk.h"
+#include "vm/swap.h"
+#include "vm/zswap.h"
 
 /* DO NOT MODIFY BELOW LINE */
 static struct disk *swap_disk;
@@ -19,29 +21,120 @@ static const struct page_operations anon_ops = {
 
 /* Initialize the data for anonymous pages */
 void vm_anon_init(void) {
-	/* TODO: Set up the swap_disk. */
-	swap_disk = NULL;
+	swap_disk = disk_get(1, 1);
+	swap_init(swap_disk);
+	zswap_init();
 }
 
 /* Initialize the file mapping */
-bool anon_initializer(struct page *page, enum vm_type type, void *kva) {
+bool anon_initializer(struct page *page, enum vm_type type UNUSED,
+					  void *kva UNUSED) {
 	/* Set up the handler */
 	page->operations = &anon_ops;
 
 	struct anon_page *anon_page = &page->anon;
+	anon_page->slot = SWAP_SLOT_NONE;
+	anon_page->zentry = NULL;
+	anon_page->init = NULL;
+	anon_page->aux = NULL;
+	return true;
 }
 
-/* Swap in the page by read contents from the swap disk. */
+/* Returns the swap slot that holds anonymous PAGE, or SWAP_SLOT_NONE if
+ * PAGE is not an anonymous page or is not swapped out. */
+size_t anon_swap_slot(struct page *page) {
+	if (page->operations->type != VM_ANON)
+		return SWAP_SLOT_NONE;
+	return page->anon.slot;
+}
+
+/* Returns true if anonymous PAGE is swapped out, either to the compressed
+ * cache or to the swap disk. */
+bool anon_is_swapped_out(struct page *page) {
+	return zswap_contains(page) || page->anon.slot != SWAP_SLOT_NONE;
+}
+
+/* Swap in the page by read contents from the compressed cache or the swap
+ * disk. */
 static bool anon_swap_in(struct page *page, void *kva) {
 	struct anon_page *anon_page = &page->anon;
+
+	if (zswap_load(page, kva))
+		return true;
+	if (anon_page->slot == SWAP_SLOT_NONE)
+		return false;
+	swap_read(anon_page->slot, kva);
+	swap_free(anon_page->slot);
+	anon_page->slot = SWAP_SLOT_NONE;
+	anon_page->zentry = NULL;
+	anon_page->init = NULL;
+	anon_page->aux = NULL;
+	return true;
 }
 
 /* Swap out the page by writing contents to the swap disk. */
 static bool anon_swap_out(struct page *page) {
-	struct anon_page *anon_page = &page->anon;
+	return anon_swap_out_batch(&page, 1) == 1;
+}
+
+/* Swaps out the CNT anonymous pages in PAGES, which must be unmapped, at
+ * most SWAP_BATCH of them.  Each page goes to the compressed cache if it
+ * takes it and the page's frame is not shared, since an entry of the cache
+ * belongs to a single page.  The rest go to consecutive swap slots in the order given,
+ * written in one pass, unless swap is too fragmented for that, in which
+ * case they are split over the longest runs that can be found.  Returns
+ * the number of pages swapped out; fewer than CNT means that swap is full,
+ * and anon_is_swapped_out() tells which pages were not. */
+size_t anon_swap_out_batch(struct page **pages, size_t cnt) {
+	struct page *disk_pages[SWAP_BATCH];
+	void *kvas[SWAP_BATCH];
+	size_t disk_cnt = 0;
+	size_t done = 0;
+	size_t i;
+
+	ASSERT(cnt <= SWAP_BATCH);
+
+	for (i = 0; i < cnt; i++) {
+		struct page *page = pages[i];
+
+		ASSERT(page->operations->type == VM_ANON);
+		if (page->frame->refcnt == 1 && zswap_store(page, page->frame->kva))
+			done++;
+		else
+			disk_pages[disk_cnt++] = page;
+	}
+
+	pages = disk_pages;
+	cnt = disk_cnt;
+	while (cnt > 0) {
+		size_t run = cnt;
+		size_t slot;
+
+		while ((slot = swap_alloc(run)) == SWAP_SLOT_NONE)
+			if ((run /= 2) == 0)
+				return done;
+
+		for (i = 0; i < run; i++) {
+			kvas[i] = pages[i]->frame->kva;
+			pages[i]->anon.slot = slot + i;
+		}
+		swap_write(slot, kvas, run);
+		done += run;
+		pages += run;
+		cnt -= run;
+	}
+	return done;
 }
 
 /* Destroy the anonymous page. PAGE will be freed by the caller. */
 static void anon_destroy(struct page *page) {
 	struct anon_page *anon_page = &page->anon;
+
+	/* Free the frame first: this waits for an eviction of PAGE that is
+	 * under way, which may still be assigning it a slot.  Dropping it from the
+	 * compressed cache then waits for a spill of it to disk. */
+	vm_free_frame(page);
+	zswap_invalidate(page);
+	if (anon_page->slot != SWAP_SLOT_NONE)
+		swap_free(anon_page->slot);
 }
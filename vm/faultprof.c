@@ -0,0 +1,144 @@
+/* faultprof.c: Page fault profiling.  See vm/faultprof.h. */
+
+#ifdef FAULT_PROFILE
+#include "vm/faultprof.h"
+#include <debug.h>
+#include <stdio.h>
+#include "intrinsic.h"
+#include "threads/interrupt.h"
+#include "threads/thread.h"
+
+/* Rows of a histogram: one per phase, then the cycles that no phase
+ * accounts for, then the whole fault. */
+#define ROW_OTHER FAULT_PHASE_CNT
+#define ROW_TOTAL (FAULT_PHASE_CNT + 1)
+#define ROW_CNT (FAULT_PHASE_CNT + 2)
+
+/* Bucket B counts samples of 2**B to 2**(B + 1) - 1 cycles; bucket 0
+ * takes 0 too. */
+#define BUCKET_CNT 40
+
+/* Samples of one kind of fault. */
+struct fault_hist {
+	long long cnt;						   /* # of faults. */
+	uint64_t sum[ROW_CNT];				   /* Cycles in total. */
+	long long buckets[ROW_CNT][BUCKET_CNT]; /* Distribution. */
+};
+
+static struct fault_hist hists[FAULT_TYPE_CNT];
+
+static const char *type_names[FAULT_TYPE_CNT] = {
+	[FAULT_ANON] = "anonymous", [FAULT_FILE] = "file",
+	[FAULT_SWAP] = "swap-in",	[FAULT_STACK] = "stack growth",
+	[FAULT_COW] = "copy-on-write",
+};
+
+static const char *row_names[ROW_CNT] = {
+	[FAULT_LOOKUP] = "lookup",	 [FAULT_ALLOC] = "alloc",
+	[FAULT_EVICT] = "evict",	 [FAULT_IO] = "io",
+	[FAULT_INSTALL] = "install", [ROW_OTHER] = "other",
+	[ROW_TOTAL] = "total",
+};
+
+/* Returns the bucket that CYCLES fall into. */
+static int bucket_of(uint64_t cycles) {
+	int b = 0;
+
+	while (cycles > 1 && b < BUCKET_CNT - 1) {
+		cycles >>= 1;
+		b++;
+	}
+	return b;
+}
+
+/* Adds CYCLES to ROW of HIST. */
+static void record(struct fault_hist *hist, int row, uint64_t cycles) {
+	hist->sum[row] += cycles;
+	hist->buckets[row][bucket_of(cycles)]++;
+}
+
+/* Starts timing the page fault that the current thread just took.  It
+ * counts as anonymous until faultprof_set_type() says otherwise. */
+void faultprof_begin(void) {
+	struct fault_sample *s = &thread_current()->fault_sample;
+	int i;
+
+	ASSERT(!s->active);
+	s->active = true;
+	s->type = FAULT_ANON;
+	for (i = 0; i < FAULT_PHASE_CNT; i++)
+		s->cycles[i] = 0;
+	s->start = rdtsc();
+}
+
+/* Stops timing the current thread's page fault, and records it if it was
+ * HANDLED. */
+void faultprof_end(bool handled) {
+	uint64_t end = rdtsc();
+	struct fault_sample *s = &thread_current()->fault_sample;
+	struct fault_hist *hist = &hists[s->type];
+	uint64_t total = end - s->start, phases = 0;
+	enum intr_level old_level;
+	int i;
+
+	ASSERT(s->active);
+	s->active = false;
+	if (!handled)
+		return;
+
+	old_level = intr_disable();
+	hist->cnt++;
+	for (i = 0; i < FAULT_PHASE_CNT; i++) {
+		record(hist, i, s->cycles[i]);
+		phases += s->cycles[i];
+	}
+	record(hist, ROW_OTHER, total > phases ? total - phases : 0);
+	record(hist, ROW_TOTAL, total);
+	intr_set_level(old_level);
+}
+
+/* Sets the kind of the current thread's page fault. */
+void faultprof_set_type(enum fault_type type) {
+	struct fault_sample *s = &thread_current()->fault_sample;
+
+	if (s->active)
+		s->type = type;
+}
+
+/* Returns the TSC, as a starting point for faultprof_add(). */
+uint64_t faultprof_now(void) {
+	return rdtsc();
+}
+
+/* Charges the cycles since START to PHASE of the current thread's page
+ * fault, if it is handling one. */
+void faultprof_add(enum fault_phase phase, uint64_t start) {
+	struct fault_sample *s = &thread_current()->fault_sample;
+
+	if (s->active)
+		s->cycles[phase] += rdtsc() - start;
+}
+
+/* Prints the histograms of the kinds of faults that happened.  Each row
+ * gives the average in cycles, then the count of each nonempty bucket as
+ * LOG2:COUNT. */
+void faultprof_print_stats(void) {
+	int t, r, b;
+
+	for (t = 0; t < FAULT_TYPE_CNT; t++) {
+		struct fault_hist *hist = &hists[t];
+
+		if (hist->cnt == 0)
+			continue;
+		printf("Fault profile: %lld %s faults\n", hist->cnt, type_names[t]);
+		for (r = 0; r < ROW_CNT; r++) {
+			printf("  %-7s avg %10llu |", row_names[r],
+				   (unsigned long long)(hist->sum[r] / hist->cnt));
+			for (b = 0; b < BUCKET_CNT; b++)
+				if (hist->buckets[r][b] != 0)
+					printf(" %d:%lld", b, hist->buckets[r][b]);
+			printf("\n");
+		}
+	}
+}
+#endif /* FAULT_PROFILE */
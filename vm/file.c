@@ -1,10 +1,20 @@
 /* file.c: Implementation of memory backed file object (mmaped object). */
 
 #include "vm/vm.h"
+#include <mman.h>
+#include <round.h>
+#include <stdio.h>
+#include <string.h>
+#include "devices/timer.h"
+#include "threads/malloc.h"
+#include "threads/mmu.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
 
 static bool file_backed_swap_in(struct page *page, void *kva);
 static bool file_backed_swap_out(struct page *page);
 static void file_backed_destroy(struct page *page);
+static void writeback_daemon(void *aux);
 
 /* DO NOT MODIFY this struct */
 static const struct page_operations file_ops = {
@@ -14,35 +24,428 @@ static const struct page_operations file_ops = {
 	.type = VM_FILE,
 };
 
+/* Writeback.  A daemon wakes up every WRITEBACK_MS milliseconds and writes
+ * back the pages of every mapping that were written to since, so that
+ * munmap() and exit have little left to write and data does not sit in
+ * memory only for long.  Dirty pages are written in file order, up to
+ * WB_CLUSTER of them with one request when they follow each other. */
+#define WB_CLUSTER 16
+
+/* -o writeback=MS: Milliseconds between writeback passes, 0 for none. */
+unsigned writeback_ms = 500;
+
+/* Every region of every process, for the daemon.  The lock is held only
+ * to pick the next region, which the daemon then writes under the
+ * region's own lock.  An unmap of the region that is being written waits
+ * for that region alone, on WB_DONE. */
+static struct list all_regions;
+static struct lock regions_lock;
+static struct mmap_region *wb_region; /* Region the daemon is writing. */
+static struct condition wb_done;	  /* Signaled when it is done. */
+
+/* Statistics. */
+static long long daemon_cnt; /* # of pages written back by the daemon. */
+static long long sync_cnt;	 /* # of pages written back by msync, munmap. */
+static long long write_cnt;	 /* # of write requests for them. */
+
 /* The initializer of file vm */
-void vm_file_init(void) {}
+void vm_file_init(void) {
+	list_init(&all_regions);
+	lock_init(&regions_lock);
+	cond_init(&wb_done);
+	if (writeback_ms > 0)
+		thread_create("writeback", PRI_DEFAULT, writeback_daemon, NULL);
+}
+
+/* Initialize the file backed page.  The page's region is the aux of its
+ * uninit page, which this overwrites. */
+bool file_backed_initializer(struct page *page, enum vm_type type UNUSED,
+							 void *kva UNUSED) {
+	struct mmap_region *region = page->uninit.aux;
+	off_t ofs = (uint8_t *)page->va - (uint8_t *)region->start;
 
-/* Initialize the file backed page */
-bool file_backed_initializer(struct page *page, enum vm_type type, void *kva) {
 	/* Set up the handler */
 	page->operations = &file_ops;
 
 	struct file_page *file_page = &page->file;
+	file_page->region = region;
+	file_page->offset = region->offset + ofs;
+	if (ofs >= region->length)
+		file_page->read_bytes = 0;
+	else if (region->length - ofs < PGSIZE)
+		file_page->read_bytes = region->length - ofs;
+	else
+		file_page->read_bytes = PGSIZE;
+	return true;
+}
+
+/* Reads the contents of PAGE the first time it is touched. */
+static bool lazy_load_file(struct page *page, void *aux UNUSED) {
+	return file_backed_swap_in(page, page->frame->kva);
 }
 
 /* Swap in the page by read contents from the file. */
 static bool file_backed_swap_in(struct page *page, void *kva) {
-	struct file_page *file_page UNUSED = &page->file;
+	struct file_page *file_page = &page->file;
+	size_t read_bytes = file_page->read_bytes;
+
+	if (file_read_at(file_page->region->file, kva, read_bytes,
+					 file_page->offset) != (off_t)read_bytes)
+		return false;
+	memset((uint8_t *)kva + read_bytes, 0, PGSIZE - read_bytes);
+	return true;
+}
+
+/* Writes PAGE, whose contents are at KVA, back to its file if it was
+ * written to, and marks it clean.  Returns false, leaving it dirty, if
+ * the file took less than all of it. */
+static bool write_back(struct page *page, void *kva) {
+	struct file_page *file_page = &page->file;
+
+	if (!pml4_is_dirty(page->pml4, page->va))
+		return true;
+	if (file_write_at(file_page->region->file, kva, file_page->read_bytes,
+					  file_page->offset) != (off_t)file_page->read_bytes)
+		return false;
+	pml4_set_dirty(page->pml4, page->va, false);
+	return true;
 }
 
-/* Swap out the page by writeback contents to the file. */
+/* Swap out the page by writeback contents to the file.  A page that cannot
+ * be written back stays in memory. */
 static bool file_backed_swap_out(struct page *page) {
-	struct file_page *file_page UNUSED = &page->file;
+	return write_back(page, page->frame->kva);
 }
 
-/* Destory the file backed page. PAGE will be freed by the caller. */
+/* Destory the file backed page. PAGE will be freed by the caller.  What
+ * cannot be written back is lost with it. */
 static void file_backed_destroy(struct page *page) {
-	struct file_page *file_page UNUSED = &page->file;
+	if (!file_page_drop(page))
+		vm_free_frame(page);
+}
+
+/* Writes file backed PAGE back if it was written to and lets go of its
+ * frame.  PAGE stays mapped and is read in again when it is touched.
+ * Returns false, keeping the frame and the page dirty, if it cannot be
+ * written back. */
+bool file_page_drop(struct page *page) {
+	struct mmap_region *region = page->file.region;
+	struct frame *frame;
+	bool success = true;
+
+	/* Keep the frame from being evicted, and reused, while it is being
+	 * written back, and the daemon from writing it at the same time. */
+	lock_acquire(&region->lock);
+	frame = vm_pin_resident(page);
+	if (frame != NULL)
+		success = write_back(page, frame->kva);
+	if (success)
+		vm_free_frame(page);
+	else
+		vm_unpin_page(page);
+	lock_release(&region->lock);
+	return success;
+}
+
+/* Writes the CNT pages in RUN, which follow each other in the file and are
+ * pinned, back to the file of REGION and unpins them.  With BUF, a buffer
+ * of WB_CLUSTER pages, they go in one request; without it, CNT must be
+ * 1.  Pages that the file did not take all of are marked dirty again.
+ * Returns the number of pages written in full. */
+static size_t write_run(struct mmap_region *region, struct page **run,
+						size_t cnt, uint8_t *buf) {
+	off_t size = 0, written;
+	size_t i, done = 0;
+
+	if (buf == NULL) {
+		ASSERT(cnt == 1);
+		size = run[0]->file.read_bytes;
+		written = file_write_at(region->file, run[0]->frame->kva, size,
+								run[0]->file.offset);
+	} else {
+		for (i = 0; i < cnt; i++) {
+			memcpy(buf + size, run[i]->frame->kva, run[i]->file.read_bytes);
+			size += run[i]->file.read_bytes;
+		}
+		written = file_write_at(region->file, buf, size, run[0]->file.offset);
+	}
+	write_cnt++;
+
+	size = 0;
+	for (i = 0; i < cnt; i++) {
+		size += run[i]->file.read_bytes;
+		if (size <= written)
+			done++;
+		else
+			pml4_set_dirty(run[i]->pml4, run[i]->va, true);
+		vm_unpin_page(run[i]);
+	}
+	return done;
+}
+
+/* Writes back the pages of REGION in [START, END) that were written to, in
+ * file order, and marks them clean.  BUF is a buffer of WB_CLUSTER pages
+ * to write runs of dirty pages through, or a null pointer to write each
+ * page from its frame.  Returns the number of pages written, and sets
+ * *FAILED, if it is not null, if some page could not be written in full. */
+static size_t writeback_range(struct mmap_region *region, uint8_t *start,
+							  uint8_t *end, uint8_t *buf, bool *failed) {
+	size_t run_max = buf != NULL ? WB_CLUSTER : 1;
+	struct page *run[WB_CLUSTER];
+	size_t run_cnt = 0, written = 0, done;
+	uint8_t *va;
+
+	lock_acquire(&region->lock);
+	for (va = start; va < end; va += PGSIZE) {
+		struct page *page = spt_find_page(region->spt, va);
+		bool dirty = page != NULL && page->operations->type == VM_FILE &&
+					 vm_pin_dirty(page) != NULL;
+
+		if (dirty)
+			run[run_cnt++] = page;
+		if (run_cnt > 0 && (!dirty || run_cnt == run_max || va + PGSIZE >= end)) {
+			done = write_run(region, run, run_cnt, buf);
+			if (done < run_cnt && failed != NULL)
+				*failed = true;
+			written += done;
+			run_cnt = 0;
+		}
+	}
+	lock_release(&region->lock);
+	return written;
+}
+
+/* Returns the end of REGION. */
+static uint8_t *region_end(struct mmap_region *region) {
+	return (uint8_t *)region->start + region->page_cnt * PGSIZE;
+}
+
+/* Writes back the dirty pages of all regions every WRITEBACK_MS
+ * milliseconds.  A pass takes the regions from the front of the list and
+ * puts them at the back, one at a time, so that regions may come and go
+ * while it writes. */
+static void writeback_daemon(void *aux UNUSED) {
+	uint8_t *buf = palloc_get_multiple(PAL_ASSERT, WB_CLUSTER);
+
+	for (;;) {
+		size_t cnt;
+
+		timer_msleep(writeback_ms);
+		lock_acquire(&regions_lock);
+		for (cnt = list_size(&all_regions); cnt > 0; cnt--) {
+			if (list_empty(&all_regions))
+				break;
+			wb_region = list_entry(list_pop_front(&all_regions),
+								   struct mmap_region, all_elem);
+			list_push_back(&all_regions, &wb_region->all_elem);
+			lock_release(&regions_lock);
+
+			daemon_cnt += writeback_range(wb_region, wb_region->start,
+										  region_end(wb_region), buf, NULL);
+
+			lock_acquire(&regions_lock);
+			wb_region = NULL;
+			cond_broadcast(&wb_done, &regions_lock);
+		}
+		lock_release(&regions_lock);
+	}
+}
+
+/* Prints writeback statistics. */
+void file_print_stats(void) {
+	printf("Writeback: %lld pages by the daemon, %lld by msync and munmap, "
+		   "in %lld writes\n",
+		   daemon_cnt, sync_cnt, write_cnt);
 }
 
-/* Do the mmap */
+/* Do the mmap.  WRITABLE may have MAP_POPULATE OR'd in, to read the whole
+ * mapping in right away. */
 void *do_mmap(void *addr, size_t length, int writable, struct file *file,
-			  off_t offset) {}
+			  off_t offset) {
+	struct supplemental_page_table *spt = &thread_current()->spt;
+	bool populate = (writable & MAP_POPULATE) != 0;
+	struct mmap_region *region;
+	struct page **pages;
+	off_t file_len;
+	size_t page_cnt, i;
+	uint8_t *upage;
+	bool success = false;
+
+	writable &= ~MAP_POPULATE;
+
+	if (file == NULL || addr == NULL || pg_ofs(addr) != 0 ||
+		offset % PGSIZE != 0 || offset < 0 || length == 0)
+		return NULL;
+	page_cnt = DIV_ROUND_UP(length, PGSIZE);
+	if (!is_user_vaddr(addr) ||
+		page_cnt > ((uint64_t)KERN_BASE - (uint64_t)addr) / PGSIZE)
+		return NULL;
+	/* Keep out of the stack and its guard gap. */
+	if ((uint8_t *)addr < (uint8_t *)USER_STACK &&
+		(uint8_t *)addr + page_cnt * PGSIZE > (uint8_t *)vm_stack_limit())
+		return NULL;
+	file_len = file_length(file);
+	if (file_len == 0)
+		return NULL;
+	for (i = 0; i < page_cnt; i++)
+		if (spt_find_page(spt, (uint8_t *)addr + i * PGSIZE) != NULL)
+			return NULL;
+
+	region = calloc(1, sizeof *region);
+	pages = calloc(page_cnt, sizeof *pages);
+	if (region == NULL || pages == NULL)
+		goto done;
+	region->file = file_reopen(file);
+	if (region->file == NULL)
+		goto done;
+	region->start = addr;
+	region->page_cnt = page_cnt;
+	region->offset = offset;
+	region->length = offset >= file_len ? 0 : file_len - offset;
+	if ((size_t)region->length > length)
+		region->length = length;
+	region->ra = (struct readahead){0};
+	region->spt = spt;
+	lock_init(&region->lock);
+
+	upage = addr;
+	for (i = 0; i < page_cnt; i++, upage += PGSIZE) {
+		pages[i] =
+			vm_new_page(VM_FILE, upage, writable, lazy_load_file, region);
+		if (pages[i] == NULL)
+			goto done;
+	}
+	success = spt_insert_pages(spt, pages, page_cnt);
+
+done:
+	if (!success) {
+		for (i = 0; pages != NULL && i < page_cnt && pages[i] != NULL; i++)
+			vm_dealloc_page(pages[i]);
+		if (region != NULL && region->file != NULL)
+			file_close(region->file);
+		free(region);
+	} else {
+		list_push_back(&spt->mmaps, &region->elem);
+		lock_acquire(&regions_lock);
+		list_push_back(&all_regions, &region->all_elem);
+		lock_release(&regions_lock);
+	}
+	free(pages);
+
+	/* A page that cannot be read in now faults like any other later. */
+	if (success && populate)
+		for (i = 0, upage = addr; i < page_cnt; i++, upage += PGSIZE)
+			vm_claim_page(upage);
+	return success ? addr : NULL;
+}
+
+/* Removes PAGE, given SPT as AUX, from SPT. */
+static bool remove_page(struct page *page, void *spt) {
+	spt_remove_page(spt, page);
+	return true;
+}
+
+/* Writes back the dirty pages of REGION in [START, END), clustered if a
+ * buffer can be had.  Returns false if some page could not be written
+ * back in full. */
+static bool sync_range(struct mmap_region *region, uint8_t *start,
+					   uint8_t *end) {
+	uint8_t *buf = palloc_get_multiple(0, WB_CLUSTER);
+	bool failed = false;
+
+	sync_cnt += writeback_range(region, start, end, buf, &failed);
+	if (buf != NULL)
+		palloc_free_multiple(buf, WB_CLUSTER);
+	return !failed;
+}
+
+/* Unmaps REGION from SPT, writing back the pages that were changed. */
+static void unmap_region(struct supplemental_page_table *spt,
+						 struct mmap_region *region) {
+	lock_acquire(&regions_lock);
+	list_remove(&region->all_elem);
+	while (wb_region == region)
+		cond_wait(&wb_done, &regions_lock);
+	lock_release(&regions_lock);
+
+	/* Write in clusters what the daemon has not written yet, before the
+	 * pages go one by one. */
+	sync_range(region, region->start, region_end(region));
+	spt_for_each(spt, region->start, region_end(region), remove_page, spt);
+	list_remove(&region->elem);
+	file_close(region->file);
+	free(region);
+}
 
 /* Do the munmap */
-void do_munmap(void *addr) {}
+void do_munmap(void *addr) {
+	struct supplemental_page_table *spt = &thread_current()->spt;
+	struct list_elem *e;
+
+	for (e = list_begin(&spt->mmaps); e != list_end(&spt->mmaps);
+		 e = list_next(e)) {
+		struct mmap_region *region = list_entry(e, struct mmap_region, elem);
+
+		if (region->start == addr) {
+			unmap_region(spt, region);
+			return;
+		}
+	}
+}
+
+/* Do the msync: writes back the pages of the mappings in [ADDR, ADDR +
+ * LENGTH) that were written to.  With MS_SYNC this is done before
+ * returning; with MS_ASYNC it is left to the writeback daemon's next pass,
+ * or to munmap() if there is no daemon.  Returns 0 if successful, or -1
+ * if ADDR is not page-aligned, FLAGS is not one of the two, no mapping
+ * overlaps the range, or with MS_SYNC, some page could not be written
+ * back in full; it stays dirty. */
+int do_msync(void *addr, size_t length, int flags) {
+	struct supplemental_page_table *spt = &thread_current()->spt;
+	uint8_t *start = addr, *end;
+	bool found = false, synced = true;
+	struct list_elem *e;
+
+	if (pg_ofs(addr) != 0 || !is_user_vaddr(addr) ||
+		length > (uint64_t)KERN_BASE - (uint64_t)addr ||
+		(flags != MS_SYNC && flags != MS_ASYNC))
+		return -1;
+	end = start + ROUND_UP(length, PGSIZE);
+
+	for (e = list_begin(&spt->mmaps); e != list_end(&spt->mmaps);
+		 e = list_next(e)) {
+		struct mmap_region *region = list_entry(e, struct mmap_region, elem);
+		uint8_t *first = (uint8_t *)region->start > start ? region->start : start;
+		uint8_t *last = region_end(region) < end ? region_end(region) : end;
+
+		if (first >= last)
+			continue;
+		found = true;
+		if (flags == MS_SYNC && !sync_range(region, first, last))
+			synced = false;
+	}
+	return found && synced ? 0 : -1;
+}
+
+/* Marks the regions of SPT that overlap [START, END) as read in order, or
+ * not, for madvise(). */
+void file_set_sequential(struct supplemental_page_table *spt, void *start,
+						 void *end, bool sequential) {
+	struct list_elem *e;
+
+	for (e = list_begin(&spt->mmaps); e != list_end(&spt->mmaps);
+		 e = list_next(e)) {
+		struct mmap_region *region = list_entry(e, struct mmap_region, elem);
+
+		if ((uint8_t *)region->start < (uint8_t *)end &&
+			region_end(region) > (uint8_t *)start)
+			region->ra.sequential = sequential;
+	}
+}
+
+/* Unmaps every region of SPT. */
+void file_munmap_all(struct supplemental_page_table *spt) {
+	while (!list_empty(&spt->mmaps))
+		unmap_region(spt, list_entry(list_front(&spt->mmaps),
+									 struct mmap_region, elem));
+}
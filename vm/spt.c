@@ -0,0 +1,216 @@
+/* spt.c: Supplemental page table.
+ *
+ * The supplemental page table is a radix tree that mirrors the x86-64 page
+ * table: a virtual address is split into the same four 9-bit indexes
+ * (PML4, PDPT, PD, PT) that the MMU uses, and each level is a page-sized node
+ * of 512 slots.  The slots of the last level hold the struct page pointers.
+ *
+ * Interior nodes are allocated lazily, the first time a page is inserted
+ * below them, and are only freed when the whole table is destroyed, just
+ * like the page tables in threads/mmu.c.  Lookup is therefore a fixed
+ * four-step walk with no hashing and no key comparison, and walking a range
+ * of addresses visits pages in address order while skipping whole unmapped
+ * subtrees at once. */
+
+#include "vm/vm.h"
+#include <debug.h>
+#include <stdint.h>
+#include "threads/mmu.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+/* Number of slots in a node, and number of levels. */
+#define SPT_FANOUT 512
+#define SPT_LEVELS 4
+
+/* A node of the tree.  Slots of interior nodes point to the node of the
+ * next level; slots of leaf nodes point to struct page. */
+struct spt_node {
+	void *slots[SPT_FANOUT];
+};
+
+/* Returns the number of address bits below the slots of LEVEL, where level 0
+ * is the leaf (PT) level and level SPT_LEVELS - 1 is the root (PML4)
+ * level. */
+static inline size_t level_shift(int level) {
+	return PTXSHIFT + 9 * level;
+}
+
+/* Returns the slot index of VA at LEVEL. */
+static inline size_t slot_index(uint64_t va, int level) {
+	return (va >> level_shift(level)) & (SPT_FANOUT - 1);
+}
+
+/* Allocates a new, empty node. */
+static struct spt_node *node_create(void) {
+	ASSERT(sizeof(struct spt_node) == PGSIZE);
+	return palloc_get_page(PAL_ZERO);
+}
+
+/* Returns the leaf node covering VA in SPT.  If CREATE is true, missing
+ * nodes are allocated on the way down; otherwise returns a null pointer as
+ * soon as one is missing.  Also returns a null pointer if allocation
+ * fails. */
+static struct spt_node *find_leaf(struct supplemental_page_table *spt,
+								  uint64_t va, bool create) {
+	void **slot = (void **)&spt->root;
+	int level;
+
+	for (level = SPT_LEVELS - 1; level >= 0; level--) {
+		if (*slot == NULL) {
+			if (!create || (*slot = node_create()) == NULL)
+				return NULL;
+			spt->node_cnt++;
+		}
+		if (level == 0)
+			break;
+		slot = &((struct spt_node *)*slot)->slots[slot_index(va, level)];
+	}
+	return *slot;
+}
+
+/* Find VA from spt and return page. On error, return NULL. */
+struct page *spt_find_page(struct supplemental_page_table *spt, void *va) {
+	struct spt_node *node = spt->root;
+	uint64_t addr = (uint64_t)va;
+	int level;
+
+	/* Unrolled version of find_leaf(), since this sits on the page fault
+	 * path. */
+	for (level = SPT_LEVELS - 1; level > 0; level--) {
+		if (node == NULL)
+			return NULL;
+		node = node->slots[slot_index(addr, level)];
+	}
+	return node != NULL ? node->slots[slot_index(addr, 0)] : NULL;
+}
+
+/* Insert PAGE into spt with validation.  Fails if a page is already mapped
+ * at PAGE's address or if memory for the tree cannot be allocated. */
+bool spt_insert_page(struct supplemental_page_table *spt, struct page *page) {
+	return spt_insert_pages(spt, &page, 1);
+}
+
+/* Inserts the CNT pages in PAGES, which must be at consecutive virtual
+ * addresses starting at PAGES[0]->va, into SPT.  This walks the tree once
+ * per leaf node instead of once per page, which is what loading a large ELF
+ * segment wants.  Either all of the pages are inserted and true is
+ * returned, or none of them are and false is returned. */
+bool spt_insert_pages(struct supplemental_page_table *spt, struct page **pages,
+					  size_t cnt) {
+	struct spt_node *leaf = NULL;
+	size_t i;
+
+	for (i = 0; i < cnt; i++) {
+		uint64_t va = (uint64_t)pages[i]->va;
+		size_t idx = slot_index(va, 0);
+
+		ASSERT(pg_ofs(pages[i]->va) == 0);
+		ASSERT(i == 0 || pages[i]->va == pages[i - 1]->va + PGSIZE);
+
+		if (leaf == NULL || idx == 0) {
+			leaf = find_leaf(spt, va, true);
+			if (leaf == NULL)
+				goto rollback;
+		}
+		if (leaf->slots[idx] != NULL)
+			goto rollback;
+		leaf->slots[idx] = pages[i];
+		pages[i]->spt = spt;
+	}
+	spt->page_cnt += cnt;
+	return true;
+
+rollback:
+	while (i-- > 0) {
+		leaf = find_leaf(spt, (uint64_t)pages[i]->va, false);
+		leaf->slots[slot_index((uint64_t)pages[i]->va, 0)] = NULL;
+	}
+	return false;
+}
+
+/* Removes PAGE from SPT and deallocates it. */
+void spt_remove_page(struct supplemental_page_table *spt, struct page *page) {
+	struct spt_node *leaf = find_leaf(spt, (uint64_t)page->va, false);
+	size_t idx = slot_index((uint64_t)page->va, 0);
+
+	ASSERT(leaf != NULL && leaf->slots[idx] == page);
+	leaf->slots[idx] = NULL;
+	spt->page_cnt--;
+	vm_dealloc_page(page);
+}
+
+/* Calls ACTION on each page of NODE, which is at LEVEL and covers addresses
+ * starting at BASE, whose address is in [START, END).  Stops and returns
+ * false as soon as ACTION returns false. */
+static bool walk(struct spt_node *node, int level, uint64_t base,
+				 uint64_t start, uint64_t end, spt_action_func *action,
+				 void *aux) {
+	size_t shift = level_shift(level);
+	size_t first = start > base ? (start - base) >> shift : 0;
+	size_t last = (end - 1 - base) >> shift;
+	size_t i;
+
+	if (last >= SPT_FANOUT)
+		last = SPT_FANOUT - 1;
+	for (i = first; i <= last; i++) {
+		void *slot = node->slots[i];
+
+		if (slot == NULL)
+			continue;
+		if (level == 0) {
+			if (!action(slot, aux))
+				return false;
+		} else if (!walk(slot, level - 1, base + ((uint64_t)i << shift), start,
+						 end, action, aux))
+			return false;
+	}
+	return true;
+}
+
+/* Calls ACTION on each page of SPT whose address is in [START, END), in
+ * ascending address order, passing AUX along.  Unmapped parts of the range
+ * are skipped a subtree at a time.  ACTION may remove the page it is
+ * given.  Returns false if ACTION returned false for some page, which also
+ * stops the walk, and true otherwise. */
+bool spt_for_each(struct supplemental_page_table *spt, void *start, void *end,
+				  spt_action_func *action, void *aux) {
+	if (spt->root == NULL || start >= end)
+		return true;
+	return walk(spt->root, SPT_LEVELS - 1, 0, (uint64_t)start, (uint64_t)end,
+				action, aux);
+}
+
+/* Frees NODE at LEVEL and everything below it, calling DESTRUCTOR on each
+ * page if it is non-null. */
+static void destroy_node(struct spt_node *node, int level,
+						 void (*destructor)(struct page *)) {
+	size_t i;
+
+	for (i = 0; i < SPT_FANOUT; i++) {
+		void *slot = node->slots[i];
+
+		if (slot == NULL)
+			continue;
+		if (level > 0)
+			destroy_node(slot, level - 1, destructor);
+		else if (destructor != NULL)
+			destructor(slot);
+	}
+	palloc_free_page(node);
+}
+
+/* Calls DESTRUCTOR, if non-null, on each page of SPT and frees the tree.
+ * SPT is left empty and may be used again. */
+void spt_destroy(struct supplemental_page_table *spt,
+				 void (*destructor)(struct page *)) {
+	struct spt_node *root = spt->root;
+
+	/* Detach the tree first, so that DESTRUCTOR never sees a half-freed
+	 * table. */
+	spt->root = NULL;
+	spt->page_cnt = 0;
+	spt->node_cnt = 0;
+	if (root != NULL)
+		destroy_node(root, SPT_LEVELS - 1, destructor);
+}
@@ -0,0 +1,132 @@
+/* swap.c: Swap slot allocator for the swap disk.
+ *
+ * The swap disk is divided into slots of SECTORS_PER_SLOT consecutive
+ * sectors, one page each.  Slots are handed out in runs, so that a batch of
+ * pages that is evicted together lands in one contiguous stretch of the
+ * disk and can be written in a single pass, and read back in the same
+ * order.
+ *
+ * A slot can be shared: when a page that fork shared between processes is
+ * swapped out, every sharer refers to the same slot, which is freed when the
+ * last of them lets go of it. */
+
+#include "vm/swap.h"
+#include <bitmap.h>
+#include <debug.h>
+#include <stdio.h>
+#include <stdint.h>
+#include "devices/disk.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* Number of sectors in a slot. */
+#define SECTORS_PER_SLOT (PGSIZE / DISK_SECTOR_SIZE)
+
+static struct disk *swap_disk;
+static struct bitmap *used_slots; /* One bit per slot, true if in use. */
+static uint16_t *slot_refs;		  /* Number of users of each slot. */
+static size_t slot_cnt;
+static struct lock swap_lock; /* Protects the above and the counters. */
+
+/* Statistics. */
+static size_t used_cnt;		 /* # of slots in use. */
+static size_t used_peak;	 /* Highest USED_CNT so far. */
+static long long out_cnt;	 /* # of pages written. */
+static long long batch_cnt;	 /* # of swap_write() calls. */
+static long long in_cnt;	 /* # of pages read. */
+
+/* Sets up swapping to DISK, which may be null if there is no swap
+ * disk.  In that case every allocation fails. */
+void swap_init(struct disk *disk) {
+	swap_disk = disk;
+	slot_cnt = disk != NULL ? disk_size(disk) / SECTORS_PER_SLOT : 0;
+	lock_init(&swap_lock);
+	if (slot_cnt == 0)
+		return;
+	used_slots = bitmap_create(slot_cnt);
+	slot_refs = calloc(slot_cnt, sizeof *slot_refs);
+	if (used_slots == NULL || slot_refs == NULL)
+		PANIC("swap_init: no memory for %zu slots", slot_cnt);
+}
+
+/* Allocates CNT consecutive slots, each with one user, and returns the
+ * first one, or SWAP_SLOT_NONE if there is no run of that length free. */
+size_t swap_alloc(size_t cnt) {
+	size_t slot, i;
+
+	ASSERT(cnt > 0);
+
+	if (cnt > slot_cnt)
+		return SWAP_SLOT_NONE;
+	lock_acquire(&swap_lock);
+	slot = bitmap_scan_from_hint(used_slots, cnt, false);
+	if (slot != BITMAP_ERROR) {
+		bitmap_set_multiple(used_slots, slot, cnt, true);
+		for (i = 0; i < cnt; i++)
+			slot_refs[slot + i] = 1;
+		used_cnt += cnt;
+		if (used_cnt > used_peak)
+			used_peak = used_cnt;
+	} else
+		slot = SWAP_SLOT_NONE;
+	lock_release(&swap_lock);
+	return slot;
+}
+
+/* Adds a user to SLOT, which must be in use, and returns SLOT. */
+size_t swap_dup(size_t slot) {
+	lock_acquire(&swap_lock);
+	ASSERT(bitmap_test(used_slots, slot));
+	ASSERT(slot_refs[slot] < UINT16_MAX);
+	slot_refs[slot]++;
+	lock_release(&swap_lock);
+	return slot;
+}
+
+/* Drops a user of SLOT, and frees it if that was the last one. */
+void swap_free(size_t slot) {
+	lock_acquire(&swap_lock);
+	ASSERT(bitmap_test(used_slots, slot));
+	if (--slot_refs[slot] == 0) {
+		bitmap_reset(used_slots, slot);
+		used_cnt--;
+	}
+	lock_release(&swap_lock);
+}
+
+/* Writes the CNT pages at KVAS to the CNT consecutive slots starting at
+ * SLOT, in order, so that the disk sees one sequential pass. */
+void swap_write(size_t slot, void *const kvas[], size_t cnt) {
+	size_t i;
+
+	ASSERT(slot + cnt <= slot_cnt);
+
+	for (i = 0; i < cnt; i++)
+		disk_write_multiple(swap_disk, (slot + i) * SECTORS_PER_SLOT,
+							SECTORS_PER_SLOT, kvas[i]);
+
+	lock_acquire(&swap_lock);
+	out_cnt += cnt;
+	batch_cnt++;
+	lock_release(&swap_lock);
+}
+
+/* Reads SLOT into the page at KVA. */
+void swap_read(size_t slot, void *kva) {
+	ASSERT(slot < slot_cnt);
+
+	disk_read_multiple(swap_disk, slot * SECTORS_PER_SLOT, SECTORS_PER_SLOT,
+					   kva);
+
+	lock_acquire(&swap_lock);
+	in_cnt++;
+	lock_release(&swap_lock);
+}
+
+/* Prints swap statistics. */
+void swap_print_stats(void) {
+	printf("Swap: %zu of %zu slots in use (peak %zu), %lld pages out in "
+		   "%lld batches, %lld pages in\n",
+		   used_cnt, slot_cnt, used_peak, out_cnt, batch_cnt, in_cnt);
+}
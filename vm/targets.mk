@@ -3,3 +3,7 @@ vm_SRC += vm/uninit.c     # Uninitialized page
 vm_SRC += vm/anon.c       # Anonymous page
 vm_SRC += vm/file.c       # File mapped page
 vm_SRC += vm/inspect.c    # Testing utility
+vm_SRC += vm/spt.c        # Supplemental page table
+vm_SRC += vm/swap.c       # Swap slot allocator
+vm_SRC += vm/zswap.c      # Compressed swap cache
+vm_SRC += vm/faultprof.c  # Page fault profiling
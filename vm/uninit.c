@@ -10,6 +10,8 @@
 
 #include "vm/vm.h"
 #include "vm/uninit.h"
+#include <string.h>
+#include "threads/vaddr.h"
 
 static bool uninit_initialize(struct page *page, void *kva);
 static void uninit_destroy(struct page *page);
@@ -47,9 +49,23 @@ static bool uninit_initialize(struct page *page, void *kva) {
 	vm_initializer *init = uninit->init;
 	void *aux = uninit->aux;
 
-	/* TODO: You may need to fix this function. */
-	return uninit->page_initializer(page, uninit->type, kva) &&
-		   (init ? init(page, aux) : true);
+	if (!uninit->page_initializer(page, uninit->type, kva))
+		return false;
+
+	/* An anonymous page remembers where it came from, so that it can be
+	 * filled the same way again once its contents are dropped. */
+	if (page->operations->type == VM_ANON) {
+		page->anon.init = init;
+		page->anon.aux = aux;
+	}
+
+	/* A page without an initializer starts out zeroed, the frame may hold
+	 * anything. */
+	if (init == NULL) {
+		memset(kva, 0, PGSIZE);
+		return true;
+	}
+	return init(page, aux);
 }
 
 /* Free the resources hold by uninit_page. Although most of pages are transmuted
@@ -58,6 +74,7 @@ static bool uninit_initialize(struct page *page, void *kva) {
  * PAGE will be freed by the caller. */
 static void uninit_destroy(struct page *page) {
 	struct uninit_page *uninit UNUSED = &page->uninit;
-	/* TODO: Fill this function.
-	 * TODO: If you don't have anything to do, just return. */
+
+	/* Nothing to do: AUX of every initializer so far is a plain value
+	 * rather than an allocation. */
 }
@@ -2,7 +2,38 @@
 
 #include "threads/malloc.h"
 #include "vm/vm.h"
+#include <mman.h>
+#include <round.h>
+#include <stdio.h>
+#include <string.h>
+#include "devices/timer.h"
+#include "threads/mmu.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+#include "userprog/process.h"
 #include "vm/inspect.h"
+#include "vm/swap.h"
+#include "vm/zswap.h"
+
+/* Helpers */
+static void frame_table_init(void);
+static struct frame *vm_get_victim(void);
+static bool vm_do_claim_page(struct page *page);
+static bool claim_pinned(struct page *page, struct frame *frame,
+						 uint64_t *pml4);
+static struct frame *vm_evict_frame(void);
+static void wss_sampler(void *aux);
+static void ksm_scanner(void *aux);
+static bool anon_grow(struct supplemental_page_table *spt, enum vm_type type,
+					  uint8_t *upage, size_t page_cnt);
+
+/* Per-process statistics. */
+static unsigned wss_ms;		  /* Working-set sampling interval, 0 if off. */
+static unsigned ws_pass;	  /* # of sampling passes done. */
+static bool memstat_at_exit;  /* Print them when a process exits? */
+
+/* Same-page merging. */
+static unsigned ksm_pages;	  /* Frames to scan per pass, 0 if off. */
 
 /* Initializes the virtual memory subsystem by invoking each subsystem's
  * intialize codes. */
@@ -14,7 +45,11 @@ void vm_init(void) {
 #endif
 	register_inspect_intr();
 	/* DO NOT MODIFY UPPER LINES. */
-	/* TODO: Your code goes here. */
+	frame_table_init();
+	if (wss_ms > 0)
+		thread_create("wss", PRI_DEFAULT, wss_sampler, NULL);
+	if (ksm_pages > 0)
+		thread_create("ksm", PRI_DEFAULT, ksm_scanner, NULL);
 }
 
 /* Get the type of the page. This function is useful if you want to know the
@@ -30,10 +65,37 @@ enum vm_type page_get_type(struct page *page) {
 	}
 }
 
-/* Helpers */
-static struct frame *vm_get_victim(void);
-static bool vm_do_claim_page(struct page *page);
-static struct frame *vm_evict_frame(void);
+/* Creates the pending page object for UPAGE with initializer, without
+ * inserting it into any supplemental page table.  Returns a null pointer if
+ * memory cannot be allocated. */
+struct page *vm_new_page(enum vm_type type, void *upage, bool writable,
+						 vm_initializer *init, void *aux) {
+	bool (*initializer)(struct page *, enum vm_type, void *);
+	struct page *page;
+
+	ASSERT(VM_TYPE(type) != VM_UNINIT)
+	ASSERT(pg_ofs(upage) == 0);
+
+	switch (VM_TYPE(type)) {
+	case VM_ANON:
+		initializer = anon_initializer;
+		break;
+	case VM_FILE:
+		initializer = file_backed_initializer;
+		break;
+	default:
+		NOT_REACHED();
+	}
+
+	page = malloc(sizeof *page);
+	if (page == NULL)
+		return NULL;
+	uninit_new(page, upage, init, type, aux, initializer);
+	page->writable = writable;
+	page->pml4 = NULL;
+	page->spt = NULL;
+	return page;
+}
 
 /* Create the pending page object with initializer. If you want to create a
  * page, do not create it directly and make it through this function or
@@ -45,88 +107,1685 @@ bool vm_alloc_page_with_initializer(enum vm_type type, void *upage,
 	ASSERT(VM_TYPE(type) != VM_UNINIT)
 
 	struct supplemental_page_table *spt = &thread_current()->spt;
+	struct page *page;
 
 	/* Check wheter the upage is already occupied or not. */
-	if (spt_find_page(spt, upage) == NULL) {
-		/* TODO: Create the page, fetch the initialier according to the VM type,
-		 * TODO: and then create "uninit" page struct by calling uninit_new. You
-		 * TODO: should modify the field after calling the uninit_new. */
+	if (spt_find_page(spt, upage) != NULL)
+		return false;
+
+	page = vm_new_page(type, upage, writable, init, aux);
+	if (page == NULL)
+		return false;
+	if (!spt_insert_page(spt, page)) {
+		free(page);
+		return false;
+	}
+	return true;
+}
+
+/* Frame table.  There is one entry per page of the user pool, indexed by
+ * physical frame number relative to the start of the pool, so that going
+ * from a kernel virtual address to its frame is a subtraction.  Free frames
+ * are still tracked by palloc; here they just have no pages. */
+static struct frame *frames; /* The entries. */
+static size_t frame_cnt;	 /* Number of entries. */
+static uint8_t *frame_base;	 /* Kernel virtual address of frames[0]. */
+static size_t clock_hand;	 /* Next entry the clock looks at. */
+static struct lock frame_lock;
+
+/* Eviction writes its victims out without frame_lock.  They are pinned
+ * and marked evicting meanwhile, and anyone who needs the frame of one of
+ * their pages waits on EVICT_DONE with frame_wait() until it is done. */
+static struct condition evict_done;
+static unsigned evict_busy;	 /* # of evictions writing out victims. */
+
+/* The zero page.  It is not part of the user pool, is never evicted, and is
+ * mapped read-only by every anonymous page that has only been read so far,
+ * all of which are on its pages list. */
+static struct frame zero_frame;
+
+/* The text cache: the frames that hold pages of read-only segments of
+ * executables, keyed by their contents, so that a process that runs an
+ * executable that is already running maps them instead of reading them
+ * again.  A frame leaves it when it is freed or evicted.  Protected by
+ * frame_lock. */
+static struct hash text_cache;
+
+/* Statistics. */
+static long long fault_cnt;		/* # of faults resolved. */
+static long long evict_cnt;		/* # of frames evicted. */
+static long long scan_cnt;		/* # of frames looked at to find victims. */
+static long long readahead_cnt; /* # of pages swapped in ahead of use. */
+static long long file_fault_cnt; /* # of faults on pages from files. */
+static long long around_cnt;	 /* # of pages faulted around. */
+static long long avoided_cnt;	 /* # of faults that fault-around avoided. */
+static long long share_cnt;		/* # of pages shared by fork. */
+static long long zero_map_cnt;	/* # of pages mapped to the zero page. */
+static long long cow_copy_cnt;	/* # of shared pages copied on write. */
+static long long cow_reuse_cnt; /* # of pages made writable in place. */
+static long long text_map_cnt;	/* # of pages mapped from the text cache. */
+static long long willneed_cnt;	/* # of pages read in for MADV_WILLNEED. */
+static long long dontneed_cnt;	/* # of pages dropped for MADV_DONTNEED. */
+static size_t used_cnt;			/* # of frames in use. */
+static size_t used_peak;		/* Most frames ever in use at once. */
+static long long pressure_cnt;	/* # of frames that had to be reclaimed. */
+
+/* Out-of-memory killing.  When neither memory nor swap has room for
+ * another page, the process with the most pages in both is killed and the
+ * allocation waits for it to give them back.  Another process is chosen
+ * only if that takes longer than OOM_GRACE ticks. */
+#define OOM_WAIT_MS 10			/* Time between allocation attempts. */
+#define OOM_GRACE TIMER_FREQ	/* Time a victim gets to exit. */
+static int64_t oom_tick;		/* When the last victim was chosen. */
+static long long oom_kill_cnt;	/* # of processes killed. */
+
+/* Same-page merging.  The table holds a frame for each checksum that
+ * stayed the same between two scans. */
+#define KSM_SLEEP_MS 20			/* Time between passes. */
+static struct hash ksm_table;
+static size_t ksm_cursor;		/* Next frame to scan. */
+static uint64_t zero_sum;		/* Checksum of a page of zeros. */
+static long long ksm_scan_cnt;	/* # of frames scanned. */
+static long long ksm_merge_cnt; /* # of frames freed by merging. */
+static long long ksm_zero_cnt;	/* # of those merged into the zero page. */
+static long long ksm_copy_cnt;	/* # of merged pages copied on write. */
+static size_t ksm_saved;		/* Frames merged frames stand in for. */
+static size_t ksm_saved_peak;	/* Most of them at once. */
+
+/* 2Q page replacement, after Johnson and Shasha, as an alternative to the
+ * clock.  A frame whose page is brought in goes on the in queue, which is
+ * first in, first out, and the pages evicted from there are remembered as
+ * ghosts, up to one per frame.  A page that is brought back while its
+ * ghost is remembered was reused, just further apart than the in queue
+ * could see, and its frame goes on the hot queue, which the clock sweeps.
+ * Victims come from the in queue while it holds more than a quarter of
+ * the frames, so that a scan through more memory than there is passes
+ * through it and leaves the hot pages alone. */
+static bool evict_2q;			/* Use 2Q instead of the clock? */
+static struct list in_queue;	/* Frames brought in once. */
+static struct list hot_queue;	/* Frames brought in again. */
+static size_t in_cnt;			/* # of frames in IN_QUEUE. */
+static long long ghost_hit_cnt; /* # of frames put in HOT_QUEUE. */
+
+/* Stack growth.  A fault just below the stack grows it down to the page
+ * that faulted.  When faults come one page below the other, as deep
+ * recursion makes them, each grows the stack further ahead than the last,
+ * doubling up to STACK_AHEAD_MAX pages.  Up to that many of the pages
+ * that a fault adds besides its own, nearest the fault first, are brought
+ * in right away if there are free frames for them: growing the stack never
+ * evicts. */
+#define STACK_AHEAD_MAX 32
+static size_t stack_max = STACK_MAX; /* Most the stack may grow to. */
+static long long stack_fault_cnt;	 /* # of faults that grew the stack. */
+static long long stack_ahead_cnt;	 /* # of pages brought in with them. */
+
+/* Transparent 2 MB pages, with -o thp=1.  The first write to an aligned
+ * 2 MB of zero-fill anonymous memory that is all untouched brings all of
+ * it in at once, into an aligned 2 MB of the user pool, and maps it with
+ * one large page; see pml4_collapse().  The frames and pages are still
+ * 4 kB each, and the large page goes back to 4 kB pages as soon as one
+ * of them is unmapped, shared, protected or looked at by the clock. */
+static bool thp_enabled;		/* Map 2 MB pages? */
+static long long thp_map_cnt;	/* # of faults that mapped one. */
+static long long thp_miss_cnt;	/* # that found no aligned 2 MB free. */
+
+/* A page evicted from the in queue: the inode and offset of a page of a
+ * file, or the swap slot of an anonymous page, or the page itself if it
+ * went to the compressed cache. */
+struct ghost {
+	struct inode *inode;
+	uint64_t id;
+	struct hash_elem elem;
+	bool remembered;			/* In GHOST_TABLE? */
+};
+static struct ghost *ghosts;	/* Ring of FRAME_CNT ghosts. */
+static size_t ghost_next;		/* Next one to reuse. */
+static struct hash ghost_table;
+
+/* Hashes the fields of the key one by one, as text_less() compares
+   them: the padding after OFS is garbage in keys built on the stack. */
+static uint64_t text_hash(const struct hash_elem *e, void *aux UNUSED) {
+	const struct text_key *key = &hash_entry(e, struct frame, text_elem)->text;
+	return hash_bytes(&key->inode, sizeof key->inode) ^
+		   hash_bytes(&key->ofs, sizeof key->ofs) ^
+		   hash_bytes(&key->read_bytes, sizeof key->read_bytes);
+}
+
+static bool text_less(const struct hash_elem *a_, const struct hash_elem *b_,
+					  void *aux UNUSED) {
+	const struct text_key *a = &hash_entry(a_, struct frame, text_elem)->text;
+	const struct text_key *b = &hash_entry(b_, struct frame, text_elem)->text;
+
+	if (a->inode != b->inode)
+		return a->inode < b->inode;
+	if (a->ofs != b->ofs)
+		return a->ofs < b->ofs;
+	return a->read_bytes < b->read_bytes;
+}
+
+static uint64_t ksm_hash(const struct hash_elem *e, void *aux UNUSED) {
+	return hash_entry(e, struct frame, ksm_elem)->ksm_sum;
+}
+
+static bool ksm_less(const struct hash_elem *a, const struct hash_elem *b,
+					 void *aux UNUSED) {
+	return hash_entry(a, struct frame, ksm_elem)->ksm_sum <
+		   hash_entry(b, struct frame, ksm_elem)->ksm_sum;
+}
+
+static uint64_t ghost_hash(const struct hash_elem *e, void *aux UNUSED) {
+	const struct ghost *g = hash_entry(e, struct ghost, elem);
+	return hash_bytes(&g->id, sizeof g->id) ^
+		   hash_bytes(&g->inode, sizeof g->inode);
+}
+
+static bool ghost_less(const struct hash_elem *a_, const struct hash_elem *b_,
+					   void *aux UNUSED) {
+	const struct ghost *a = hash_entry(a_, struct ghost, elem);
+	const struct ghost *b = hash_entry(b_, struct ghost, elem);
+
+	if (a->inode != b->inode)
+		return a->inode < b->inode;
+	return a->id < b->id;
+}
+
+/* Sets up the frame table for the user pool. */
+static void frame_table_init(void) {
+	size_t i;
+
+	frame_base = palloc_user_pool(&frame_cnt);
+	frames = calloc(frame_cnt, sizeof *frames);
+	if (frames == NULL)
+		PANIC("vm_init: no memory for %zu frame table entries", frame_cnt);
+	for (i = 0; i < frame_cnt; i++) {
+		frames[i].kva = frame_base + i * PGSIZE;
+		list_init(&frames[i].pages);
+	}
+	lock_init(&frame_lock);
+	cond_init(&evict_done);
+	if (!hash_init(&text_cache, text_hash, text_less, NULL))
+		PANIC("vm_init: no memory for the text cache");
+	if (!hash_init(&ksm_table, ksm_hash, ksm_less, NULL))
+		PANIC("vm_init: no memory for the same-page table");
+	list_init(&in_queue);
+	list_init(&hot_queue);
+	if (evict_2q) {
+		ghosts = calloc(frame_cnt, sizeof *ghosts);
+		if (ghosts == NULL || !hash_init(&ghost_table, ghost_hash, ghost_less,
+										 NULL))
+			PANIC("vm_init: no memory for %zu ghosts", frame_cnt);
+	}
+
+	zero_frame.kva = palloc_get_page(PAL_ASSERT | PAL_ZERO);
+	list_init(&zero_frame.pages);
+	zero_sum = hash_bytes(zero_frame.kva, PGSIZE);
+}
+
+/* Returns the frame table entry of KVA, a page of the user pool. */
+static struct frame *frame_of(void *kva) {
+	size_t idx = ((uint8_t *)kva - frame_base) / PGSIZE;
+
+	ASSERT(pg_ofs(kva) == 0);
+	ASSERT(idx < frame_cnt);
+	return &frames[idx];
+}
+
+/* Returns the first page that maps FRAME, or a null pointer if FRAME is
+ * free. */
+static struct page *frame_page(struct frame *frame) {
+	if (list_empty(&frame->pages))
+		return NULL;
+	return list_entry(list_front(&frame->pages), struct page, frame_elem);
+}
+
+/* Sets the identity of PAGE, which is about to be brought in or was just
+ * evicted, in G.  Returns false if it has none, because it was never
+ * brought in before. */
+static bool page_ghost(struct page *page, struct ghost *g) {
+	switch (page->operations->type) {
+	case VM_FILE:
+		g->inode = file_get_inode(page->file.region->file);
+		g->id = page->file.offset;
+		return true;
+	case VM_ANON:
+		g->inode = NULL;
+		g->id = page->anon.slot != SWAP_SLOT_NONE ? page->anon.slot
+												  : (uintptr_t)page;
+		return true;
+	default:
+		return false;
+	}
+}
+
+/* Remembers PAGE, which was just evicted from the in queue, in place of
+ * the oldest ghost. */
+static void ghost_add(struct page *page) {
+	struct ghost *g = &ghosts[ghost_next];
 
-		/* TODO: Insert the page into the spt. */
+	ghost_next = (ghost_next + 1) % frame_cnt;
+	if (g->remembered)
+		hash_delete(&ghost_table, &g->elem);
+	g->remembered = page_ghost(page, g) &&
+					hash_insert(&ghost_table, &g->elem) == NULL;
+}
+
+/* Puts FRAME, which PAGE is about to be brought into, on the hot queue if
+ * PAGE is remembered as a ghost, or else on the in queue. */
+static void queue_admit(struct frame *frame, struct page *page) {
+	struct ghost probe;
+	struct hash_elem *e = NULL;
+
+	if (page_ghost(page, &probe))
+		e = hash_find(&ghost_table, &probe.elem);
+	if (e != NULL) {
+		hash_entry(e, struct ghost, elem)->remembered = false;
+		hash_delete(&ghost_table, e);
+		frame->queue = &hot_queue;
+		ghost_hit_cnt++;
+	} else {
+		frame->queue = &in_queue;
+		in_cnt++;
+	}
+	list_push_back(frame->queue, &frame->queue_elem);
+}
+
+/* Takes FRAME, which no page maps any more, off its queue. */
+static void queue_remove(struct frame *frame) {
+	if (frame->queue == NULL)
+		return;
+	if (frame->queue == &in_queue)
+		in_cnt--;
+	list_remove(&frame->queue_elem);
+	frame->queue = NULL;
+}
+
+/* Makes PAGE, which will be mapped into PML4, one of the pages of
+ * FRAME.  Must be called with frame_lock held. */
+static void frame_add_page(struct frame *frame, struct page *page,
+						   uint64_t *pml4) {
+	if (frame->merged && frame->refcnt > 0 && ++ksm_saved > ksm_saved_peak)
+		ksm_saved_peak = ksm_saved;
+	if (evict_2q && frame->refcnt == 0 && frame != &zero_frame)
+		queue_admit(frame, page);
+	list_push_back(&frame->pages, &page->frame_elem);
+	frame->refcnt++;
+	page->frame = frame;
+	page->pml4 = pml4;
+}
+
+/* Removes PAGE from the pages of its frame. */
+static void frame_remove_page(struct page *page) {
+	struct frame *frame = page->frame;
+
+	/* A merged frame that is down to one page is an ordinary frame
+	 * again. */
+	if (frame->merged && frame->refcnt > 1) {
+		ksm_saved--;
+		if (frame->refcnt == 2)
+			frame->merged = false;
+	}
+	list_remove(&page->frame_elem);
+	if (--frame->refcnt == 0)
+		queue_remove(frame);
+	page->frame = NULL;
+}
+
+/* Waits until PAGE is not in a frame that an eviction is writing out,
+ * and returns the frame it is in then, or a null pointer if the eviction
+ * took it out.  Must be called with frame_lock held. */
+static struct frame *frame_wait(struct page *page) {
+	ASSERT(lock_held_by_current_thread(&frame_lock));
+
+	while (page->frame != NULL && page->frame->evicting)
+		cond_wait(&evict_done, &frame_lock);
+	return page->frame;
+}
+
+/* Maps each page of FRAME, writable only if it has FRAME to itself.  The
+ * dirty bits that frame_unmap() left alone are kept. */
+static void frame_map(struct frame *frame) {
+	struct list_elem *e;
+
+	for (e = list_begin(&frame->pages); e != list_end(&frame->pages);
+		 e = list_next(e)) {
+		struct page *page = list_entry(e, struct page, frame_elem);
+		bool dirty = pml4_is_dirty(page->pml4, page->va);
+
+		pml4_set_page(page->pml4, page->va, frame->kva,
+					  page->writable && frame->refcnt == 1);
+		if (dirty)
+			pml4_set_dirty(page->pml4, page->va, true);
+	}
+}
+
+/* Unmaps each page of FRAME.  The dirty bits are left alone. */
+static void frame_unmap(struct frame *frame) {
+	struct list_elem *e;
+
+	for (e = list_begin(&frame->pages); e != list_end(&frame->pages);
+		 e = list_next(e)) {
+		struct page *page = list_entry(e, struct page, frame_elem);
+
+		pml4_clear_page(page->pml4, page->va);
+	}
+}
+
+/* Returns true if some page of FRAME was accessed since the last call, and
+ * clears their accessed bits.  Bits that the working-set sampler cleared
+ * in the meantime count too. */
+static bool frame_accessed(struct frame *frame) {
+	bool accessed = frame->young;
+	struct list_elem *e;
+
+	frame->young = false;
+	for (e = list_begin(&frame->pages); e != list_end(&frame->pages);
+		 e = list_next(e)) {
+		struct page *page = list_entry(e, struct page, frame_elem);
+
+		if (pml4_is_accessed(page->pml4, page->va)) {
+			pml4_set_accessed(page->pml4, page->va, false);
+			accessed = true;
+		}
+	}
+	return accessed;
+}
+
+/* Returns true if some page of FRAME was written. */
+static bool frame_dirty(struct frame *frame) {
+	struct list_elem *e;
+
+	for (e = list_begin(&frame->pages); e != list_end(&frame->pages);
+		 e = list_next(e)) {
+		struct page *page = list_entry(e, struct page, frame_elem);
+
+		if (pml4_is_dirty(page->pml4, page->va))
+			return true;
 	}
-err:
 	return false;
 }
 
-/* Find VA from spt and return page. On error, return NULL. */
-struct page *spt_find_page(struct supplemental_page_table *spt UNUSED,
-						   void *va UNUSED) {
-	struct page *page = NULL;
-	/* TODO: Fill this function. */
+/* Takes FRAME, whose contents are about to change, out of the text
+ * cache. */
+static void text_forget(struct frame *frame) {
+	if (frame->text.inode == NULL)
+		return;
+	hash_delete(&text_cache, &frame->text_elem);
+	frame->text.inode = NULL;
+}
 
-	return page;
+/* Takes FRAME, which no page maps any more or whose contents are about to
+ * change, out of the same-page scanner's view. */
+static void ksm_forget(struct frame *frame) {
+	if (frame->ksm_listed) {
+		hash_delete(&ksm_table, &frame->ksm_elem);
+		frame->ksm_listed = false;
+	}
+	frame->merged = false;
+	frame->ksm_sum = 0;
 }
 
-/* Insert PAGE into spt with validation. */
-bool spt_insert_page(struct supplemental_page_table *spt UNUSED,
-					 struct page *page UNUSED) {
-	int succ = false;
-	/* TODO: Fill this function. */
+/* Gives FRAME, which no page maps any more, back to the user pool. */
+static void frame_release(struct frame *frame) {
+	ASSERT(frame->refcnt == 0);
+	ASSERT(frame != &zero_frame);
 
-	return succ;
+	text_forget(frame);
+	ksm_forget(frame);
+	frame->pinned = false;
+	frame->young = false;
+	used_cnt--;
+	palloc_free_page(frame->kva);
 }
 
-void spt_remove_page(struct supplemental_page_table *spt, struct page *page) {
-	vm_dealloc_page(page);
-	return true;
+/* Returns true if FRAME holds a page of a region that is advised to be
+ * read in order, which is done with once the stream has moved past it. */
+static bool frame_sequential(struct frame *frame) {
+	struct page *page = frame_page(frame);
+
+	return page->operations->type == VM_FILE && page->file.region->ra.sequential;
+}
+
+/* Returns the first frame of QUEUE that is not pinned and, if
+ * SECOND_CHANCE, was not accessed since the last time around, moving the
+ * frames it looks at to the back.  Returns a null pointer if there is
+ * none. */
+static struct frame *queue_victim(struct list *queue, bool second_chance) {
+	size_t i;
+
+	for (i = 0; i < 2 * frame_cnt && !list_empty(queue); i++) {
+		struct frame *frame =
+			list_entry(list_pop_front(queue), struct frame, queue_elem);
+
+		list_push_back(queue, &frame->queue_elem);
+		scan_cnt++;
+		if (frame->pinned || (second_chance && frame_accessed(frame)))
+			continue;
+		return frame;
+	}
+	return NULL;
+}
+
+/* Returns the frame to evict under 2Q: the oldest of the in queue while
+ * it is over its share, or else the first unreferenced one of the hot
+ * queue.  Either queue stands in for the other when it has none. */
+static struct frame *queue_get_victim(void) {
+	struct frame *frame = NULL;
+
+	if (in_cnt > frame_cnt / 4)
+		frame = queue_victim(&in_queue, false);
+	if (frame == NULL)
+		frame = queue_victim(&hot_queue, true);
+	if (frame == NULL)
+		frame = queue_victim(&in_queue, false);
+	return frame;
 }
 
-/* Get the struct frame, that will be evicted. */
+/* Get the struct frame, that will be evicted.
+ *
+ * Second chance: the clock hand sweeps the frame table, clearing the
+ * accessed bit of each frame it passes, and stops at the first frame whose
+ * bit was already clear.  During the first lap it also passes over dirty
+ * frames, so that a page that needs no writing is preferred; from the
+ * second lap on anything unreferenced goes.  Free and pinned frames are
+ * skipped, and frames of regions that are read in order get no second
+ * chance.  Returns a null pointer if every frame is pinned.
+ * With the 2q option, queue_get_victim() decides instead.
+ * Must be called with frame_lock held. */
 static struct frame *vm_get_victim(void) {
-	struct frame *victim = NULL;
-	/* TODO: The policy for eviction is up to you. */
+	struct frame *dirty = NULL;
+	size_t i;
 
-	return victim;
+	ASSERT(lock_held_by_current_thread(&frame_lock));
+
+	if (evict_2q)
+		return queue_get_victim();
+	for (i = 0; i < 2 * frame_cnt; i++) {
+		struct frame *frame = &frames[clock_hand];
+
+		clock_hand = (clock_hand + 1) % frame_cnt;
+		scan_cnt++;
+		if (frame->refcnt == 0 || frame->pinned)
+			continue;
+		if (frame_accessed(frame) && !frame_sequential(frame))
+			continue;
+		if (i < frame_cnt && frame_dirty(frame)) {
+			if (dirty == NULL)
+				dirty = frame;
+			continue;
+		}
+		return frame;
+	}
+	return dirty;
+}
+
+/* Orders the frames of A and B by the page table of their first page,
+ * then by its address. */
+static bool victim_less(struct frame *a, struct frame *b) {
+	struct page *pa = frame_page(a), *pb = frame_page(b);
+
+	if (pa->pml4 != pb->pml4)
+		return pa->pml4 < pb->pml4;
+	return pa->va < pb->va;
 }
 
 /* Evict one page and return the corresponding frame.
- * Return NULL on error.*/
+ * Return NULL on error.
+ *
+ * Up to SWAP_BATCH victims are evicted at once.  The anonymous ones are
+ * sorted by address space and address and swapped out together, so that
+ * neighbouring pages of a process land in neighbouring swap slots, where
+ * swap-in readahead finds them.  The others are written back one by one.
+ * A frame that fork shared is written out once, and all of its pages
+ * refer to the same swap slot.
+ * One frame is returned and the rest go back to the pool, so that the next
+ * few faults find a free frame without evicting.
+ * Must be called with frame_lock held, which is released while the victims
+ * are written out. */
 static struct frame *vm_evict_frame(void) {
-	struct frame *victim UNUSED = vm_get_victim();
-	/* TODO: swap out the victim and return the evicted frame. */
+	struct frame *victims[SWAP_BATCH];
+	struct page *anon[SWAP_BATCH];
+	bool evicted[SWAP_BATCH];
+	struct frame *frame = NULL;
+	size_t victim_cnt, anon_cnt, i;
 
-	return NULL;
+	for (victim_cnt = 0; victim_cnt < SWAP_BATCH; victim_cnt++) {
+		struct frame *victim = vm_get_victim();
+		size_t j;
+
+		if (victim == NULL)
+			break;
+
+		/* Pin it so that the clock passes it by from now on, and unmap
+		 * it so that the owners cannot change the page while it is
+		 * written out.  This leaves the dirty bits for swap_out() to
+		 * see. */
+		victim->pinned = true;
+		victim->evicting = true;
+		frame_unmap(victim);
+
+		for (j = victim_cnt; j > 0 && victim_less(victim, victims[j - 1]); j--)
+			victims[j] = victims[j - 1];
+		victims[j] = victim;
+	}
+
+	if (victim_cnt == 0)
+		return NULL;
+
+	/* No one adds pages to the victims or takes them away until they are
+	 * no longer evicting, so their page lists hold still without the
+	 * lock. */
+	evict_busy++;
+	lock_release(&frame_lock);
+
+	anon_cnt = 0;
+	for (i = 0; i < victim_cnt; i++)
+		if (page_get_type(frame_page(victims[i])) == VM_ANON)
+			anon[anon_cnt++] = frame_page(victims[i]);
+	anon_swap_out_batch(anon, anon_cnt);
+
+	for (i = 0; i < victim_cnt; i++) {
+		struct page *page = frame_page(victims[i]);
+
+		evicted[i] = page_get_type(page) == VM_ANON ? anon_is_swapped_out(page)
+													: swap_out(page);
+	}
+
+	lock_acquire(&frame_lock);
+	evict_busy--;
+
+	for (i = 0; i < victim_cnt; i++) {
+		struct frame *victim = victims[i];
+		struct page *page = frame_page(victim);
+
+		victim->pinned = false;
+		victim->evicting = false;
+		if (!evicted[i]) {
+			frame_map(victim);
+			continue;
+		}
+
+		if (victim->queue == &in_queue)
+			ghost_add(page);
+
+		/* The other pages of a shared frame were written out along with
+		 * the first one. */
+		while (victim->refcnt > 0) {
+			struct page *sharer = list_entry(list_back(&victim->pages),
+											 struct page, frame_elem);
+
+			if (sharer != page)
+				sharer->anon.slot = swap_dup(page->anon.slot);
+			if (page_get_type(sharer) == VM_ANON) {
+				sharer->spt->stats.swap_out_cnt++;
+				sharer->spt->stats.swap_cnt++;
+			}
+			frame_remove_page(sharer);
+		}
+		evict_cnt++;
+		text_forget(victim);
+		ksm_forget(victim);
+		if (frame == NULL)
+			frame = victim;
+		else
+			frame_release(victim);
+	}
+	cond_broadcast(&evict_done, &frame_lock);
+	return frame;
+}
+
+/* Returns a free frame of the user pool, pinned, or a null pointer if
+ * there is none.  Must be called with frame_lock held. */
+static struct frame *get_free_frame(void) {
+	void *kva = palloc_get_page(PAL_USER);
+	struct frame *frame;
+
+	if (kva == NULL)
+		return NULL;
+	frame = frame_of(kva);
+	frame->pinned = true;
+	if (++used_cnt > used_peak)
+		used_peak = used_cnt;
+	return frame;
+}
+
+/* Returns the process to kill for lack of memory: the one with the most
+ * pages resident or in swap, counting a frame it shares with others as
+ * its own.  Processes already killed do not count.  Returns a null
+ * pointer if there is none.  Must be called with frame_lock held. */
+static struct supplemental_page_table *oom_select(void) {
+	struct supplemental_page_table *victim = NULL;
+	struct list_elem *e;
+	size_t i;
+
+	/* Every process with a resident page is on the pages list of some
+	 * frame; one with none has no memory to give back. */
+	for (i = 0; i < frame_cnt; i++)
+		for (e = list_begin(&frames[i].pages); e != list_end(&frames[i].pages);
+			 e = list_next(e)) {
+			struct page *page = list_entry(e, struct page, frame_elem);
+
+			page->spt->oom_badness = page->spt->stats.swap_cnt;
+		}
+	for (i = 0; i < frame_cnt; i++)
+		for (e = list_begin(&frames[i].pages); e != list_end(&frames[i].pages);
+			 e = list_next(e)) {
+			struct page *page = list_entry(e, struct page, frame_elem);
+			struct supplemental_page_table *spt = page->spt;
+
+			spt->oom_badness++;
+			if (!spt->oom_killed &&
+				(victim == NULL || spt->oom_badness > victim->oom_badness))
+				victim = spt;
+		}
+	return victim;
+}
+
+/* Takes the pages of FRAME that belong to SPT away from user mode, so that
+ * the next access of its process faults. */
+static void frame_revoke(struct frame *frame,
+						 struct supplemental_page_table *spt) {
+	struct list_elem *e;
+
+	for (e = list_begin(&frame->pages); e != list_end(&frame->pages);
+		 e = list_next(e)) {
+		struct page *page = list_entry(e, struct page, frame_elem);
+
+		if (page->spt == spt)
+			pml4_set_user(page->pml4, page->va, false);
+	}
+}
+
+/* Kills a process because neither memory nor swap has room left, unless
+ * one that was killed a moment ago is still exiting.  The victim dies at
+ * its next fault, which vm_try_handle_fault() refuses, and every page of
+ * it that is mapped is made to fault.  If it is in the kernel instead, it
+ * dies on the way out of its system call, and if it is blocked in wait(),
+ * it is woken up to do so.  Returns true if the caller should
+ * wait for the victim to give its memory back and try again, false if it
+ * should give up: because there is no victim, or because the caller is
+ * the victim.  Must be called with frame_lock held. */
+static bool oom_kill(void) {
+	struct supplemental_page_table *spt = &thread_current()->spt;
+	struct supplemental_page_table *victim;
+	size_t i;
+
+	if (spt->oom_killed)
+		return false;
+	if (oom_kill_cnt > 0 && timer_elapsed(oom_tick) < OOM_GRACE)
+		return true;
+
+	victim = oom_select();
+	if (victim == NULL)
+		return false;
+	victim->oom_killed = true;
+	for (i = 0; i < frame_cnt; i++)
+		frame_revoke(&frames[i], victim);
+	frame_revoke(&zero_frame, victim);
+	if (victim != spt)
+		process_wake(victim->owner);
+	oom_kill_cnt++;
+	oom_tick = timer_ticks();
+	return victim != spt;
 }
 
 /* palloc() and get frame. If there is no available page, evict the page
- * and return it. This always return valid address. That is, if the user pool
- * memory is full, this function evicts the frame to get the available memory
- * space.*/
+ * and return it.  If every frame is pinned by evictions that are under
+ * way, wait for them to give back what they do not need.  If nothing can
+ * be evicted either, because swap is full, a process is killed to make
+ * room; the frame comes from what it gives back.  Returns a null pointer if that fails, or if the current process is
+ * the one killed.
+ * The frame comes back pinned; the caller unpins it once the page is
+ * mapped. */
 static struct frame *vm_get_frame(void) {
-	struct frame *frame = NULL;
-	/* TODO: Fill this function. */
+	struct frame *frame;
+
+	lock_acquire(&frame_lock);
+	FAULT_PROF_TIME(FAULT_ALLOC, frame = get_free_frame());
+	if (frame == NULL)
+		pressure_cnt++;
+	while (frame == NULL) {
+		FAULT_PROF_TIME(FAULT_EVICT, frame = vm_evict_frame());
+		if (frame != NULL) {
+			frame->pinned = true;
+			break;
+		}
+		if (evict_busy > 0) {
+			cond_wait(&evict_done, &frame_lock);
+			frame = get_free_frame();
+			continue;
+		}
+		if (!oom_kill())
+			break;
+
+		/* The victim takes frame_lock to free its frames. */
+		lock_release(&frame_lock);
+		timer_msleep(OOM_WAIT_MS);
+		lock_acquire(&frame_lock);
+		frame = get_free_frame();
+	}
+	lock_release(&frame_lock);
 
-	ASSERT(frame != NULL);
-	ASSERT(frame->page == NULL);
+	ASSERT(frame == NULL || frame->refcnt == 0);
 	return frame;
 }
 
-/* Growing the stack. */
-static void vm_stack_growth(void *addr UNUSED) {}
+/* Unmaps PAGE from the page table it is mapped into and lets go of the
+ * frame holding it, which is released unless other pages still share it.
+ * If PAGE was evicted in the meantime, this only stops counting it as
+ * swapped out, as it is about to be destroyed. */
+void vm_free_frame(struct page *page) {
+	struct frame *frame;
+
+	lock_acquire(&frame_lock);
+	frame = frame_wait(page);
+	if (frame != NULL) {
+		pml4_clear_page(page->pml4, page->va);
+		frame_remove_page(page);
+		if (frame->refcnt == 0 && frame != &zero_frame)
+			frame_release(frame);
+	} else if (page->operations->type == VM_ANON && anon_is_swapped_out(page))
+		page->spt->stats.swap_cnt--;
+	lock_release(&frame_lock);
+}
+
+/* Counts PAGE, which the sampler found accessed, in the working set of its
+ * address space for the current pass. */
+static void ws_count(struct page *page) {
+	struct spt_stats *stats = &page->spt->stats;
+
+	if (stats->ws_pass != ws_pass) {
+		stats->ws_pass = ws_pass;
+		stats->ws_cnt = 0;
+	}
+	if (++stats->ws_cnt > stats->ws_peak)
+		stats->ws_peak = stats->ws_cnt;
+}
+
+/* Estimates the working set of each process every WSS_MS milliseconds: the
+ * pages that were accessed since the previous pass.  Their accessed bits
+ * are cleared for the next pass and handed on to the clock through the
+ * frame's young flag, so that sampling does not make them look idle to
+ * eviction.  Pages mapped to the zero page cost no frame and are left
+ * out. */
+static void wss_sampler(void *aux UNUSED) {
+	for (;;) {
+		size_t i;
+
+		timer_msleep(wss_ms);
+		lock_acquire(&frame_lock);
+		ws_pass++;
+		for (i = 0; i < frame_cnt; i++) {
+			struct frame *frame = &frames[i];
+			struct list_elem *e;
+
+			for (e = list_begin(&frame->pages); e != list_end(&frame->pages);
+				 e = list_next(e)) {
+				struct page *page = list_entry(e, struct page, frame_elem);
+
+				if (pml4_is_accessed(page->pml4, page->va)) {
+					pml4_set_accessed(page->pml4, page->va, false);
+					frame->young = true;
+					ws_count(page);
+				}
+			}
+		}
+		lock_release(&frame_lock);
+	}
+}
+
+/* Returns true if the same-page scanner may merge FRAME: it is in use and
+ * not pinned, and every page that maps it is writable anonymous memory.
+ * Read-only anonymous pages hold executable code, which the text cache
+ * shares already. */
+static bool ksm_candidate(struct frame *frame) {
+	struct list_elem *e;
+
+	if (frame->refcnt == 0 || frame->pinned || frame->text.inode != NULL)
+		return false;
+	for (e = list_begin(&frame->pages); e != list_end(&frame->pages);
+		 e = list_next(e)) {
+		struct page *page = list_entry(e, struct page, frame_elem);
+
+		if (page->operations->type != VM_ANON || !page->writable)
+			return false;
+	}
+	return true;
+}
+
+/* Maps each page of FRAME read-only, so that its contents stay put while
+ * they are compared: a write faults, and the fault waits for frame_lock. */
+static void frame_write_protect(struct frame *frame) {
+	struct list_elem *e;
+
+	for (e = list_begin(&frame->pages); e != list_end(&frame->pages);
+		 e = list_next(e)) {
+		struct page *page = list_entry(e, struct page, frame_elem);
+
+		pml4_set_page(page->pml4, page->va, frame->kva, false);
+	}
+}
+
+/* Merges FRAME into STABLE, another frame or the zero page, if they hold
+ * the same contents: the pages of FRAME are mapped read-only to STABLE
+ * and FRAME is released.  A write to any of them later copies it out
+ * again through vm_handle_wp().  Returns true if it merged. */
+static bool ksm_merge(struct frame *stable, struct frame *frame) {
+	if (stable != &zero_frame)
+		frame_write_protect(stable);
+	frame_write_protect(frame);
+	if (memcmp(stable->kva, frame->kva, PGSIZE)) {
+		if (stable != &zero_frame)
+			frame_map(stable);
+		frame_map(frame);
+		return false;
+	}
+
+	if (stable != &zero_frame && !stable->merged) {
+		stable->merged = true;
+		ksm_saved += stable->refcnt - 1;
+	}
+	while (frame->refcnt > 0) {
+		struct page *page =
+			list_entry(list_front(&frame->pages), struct page, frame_elem);
+		uint64_t *pml4 = page->pml4;
+
+		frame_remove_page(page);
+		frame_add_page(stable, page, pml4);
+		pml4_set_page(pml4, page->va, stable->kva, false);
+	}
+	if (ksm_saved > ksm_saved_peak)
+		ksm_saved_peak = ksm_saved;
+	frame_release(frame);
+	ksm_merge_cnt++;
+	if (stable == &zero_frame)
+		ksm_zero_cnt++;
+	return true;
+}
+
+/* Scans FRAME for the same-page scanner.  Its contents are only considered
+ * once their checksum is the same as at the last scan, which keeps pages
+ * that are being written out of the table.  A frame of zeros is merged
+ * into the zero page.  Otherwise, a frame with the same checksum in the
+ * table is merged with, or replaced if its contents turn out to differ.
+ * Must be called with frame_lock held. */
+static void ksm_scan(struct frame *frame) {
+	struct hash_elem *e;
+	struct frame *stable;
+	uint64_t sum;
+
+	ASSERT(lock_held_by_current_thread(&frame_lock));
+
+	if (!ksm_candidate(frame))
+		return;
+	ksm_scan_cnt++;
+	sum = hash_bytes(frame->kva, PGSIZE);
+	if (sum != frame->ksm_sum) {
+		if (frame->ksm_listed) {
+			hash_delete(&ksm_table, &frame->ksm_elem);
+			frame->ksm_listed = false;
+		}
+		frame->ksm_sum = sum;
+		return;
+	}
+	if (frame->ksm_listed)
+		return;
+
+	if (sum == zero_sum && ksm_merge(&zero_frame, frame))
+		return;
+	e = hash_find(&ksm_table, &frame->ksm_elem);
+	if (e != NULL) {
+		stable = hash_entry(e, struct frame, ksm_elem);
+		if (ksm_candidate(stable) && ksm_merge(stable, frame))
+			return;
+		hash_delete(&ksm_table, e);
+		stable->ksm_listed = false;
+	}
+	frame->ksm_listed = hash_insert(&ksm_table, &frame->ksm_elem) == NULL;
+}
 
-/* Handle the fault on write_protected page */
-static bool vm_handle_wp(struct page *page UNUSED) {}
+/* Same-page scanner: looks at KSM_PAGES frames of the frame table every
+ * KSM_SLEEP_MS milliseconds, going round, and merges anonymous pages with
+ * identical contents into one read-only frame. */
+static void ksm_scanner(void *aux UNUSED) {
+	for (;;) {
+		unsigned i;
+
+		timer_msleep(KSM_SLEEP_MS);
+		for (i = 0; i < ksm_pages; i++) {
+			lock_acquire(&frame_lock);
+			ksm_scan(&frames[ksm_cursor]);
+			ksm_cursor = (ksm_cursor + 1) % frame_cnt;
+			lock_release(&frame_lock);
+		}
+	}
+}
+
+/* Prints virtual memory statistics. */
+void vm_print_stats(void) {
+	int64_t ticks = timer_ticks();
+
+	printf("VM: %lld faults (%lld per second), %lld evictions, "
+		   "%lld frames scanned per eviction, %lld pages read ahead\n",
+		   fault_cnt, ticks > 0 ? fault_cnt * TIMER_FREQ / ticks : 0,
+		   evict_cnt, evict_cnt > 0 ? scan_cnt / evict_cnt : 0,
+		   readahead_cnt);
+	printf("Fault-around: %lld faults on file pages, %lld pages faulted "
+		   "around, %lld faults avoided\n",
+		   file_fault_cnt, around_cnt, avoided_cnt);
+	printf("COW: %lld pages shared by fork, %lld mapped to the zero page, "
+		   "%lld copied on write, %lld made writable in place\n",
+		   share_cnt, zero_map_cnt, cow_copy_cnt, cow_reuse_cnt);
+	printf("Text: %lld pages mapped from the text cache, %zu frames cached, "
+		   "%zu frames in use at peak\n",
+		   text_map_cnt, hash_size(&text_cache), used_peak);
+	printf("Madvise: %lld pages read in ahead, %lld pages dropped\n",
+		   willneed_cnt, dontneed_cnt);
+	printf("Stack: %lld faults grew the stack, %lld pages brought in ahead\n",
+		   stack_fault_cnt, stack_ahead_cnt);
+	printf("OOM: %lld frames reclaimed under memory pressure, %lld processes "
+		   "killed\n",
+		   pressure_cnt, oom_kill_cnt);
+	if (ksm_pages > 0)
+		printf("KSM: %lld frames scanned, %lld pages merged (%lld into the "
+			   "zero page), %lld copied on write, %zu frames saved at peak\n",
+			   ksm_scan_cnt, ksm_merge_cnt, ksm_zero_cnt, ksm_copy_cnt,
+			   ksm_saved_peak);
+	if (thp_enabled)
+		printf("THP: %lld faults mapped 2 MB pages, %lld found no 2 MB free\n",
+			   thp_map_cnt, thp_miss_cnt);
+	if (evict_2q)
+		printf("2Q: %zu frames in the in queue, %zu in the hot queue, "
+			   "%lld pages brought back while remembered\n",
+			   in_cnt, list_size(&hot_queue), ghost_hit_cnt);
+	swap_print_stats();
+	zswap_print_stats();
+	file_print_stats();
+	FAULT_PROF_PRINT();
+}
+
+/* Returns true if OPTION, of the form NAME=VALUE, is named NAME. */
+static bool option_is(const char *option, const char *name) {
+	size_t len = strlen(name);
+
+	return !memcmp(option, name, len) && option[len] == '=';
+}
+
+/* Parses the decimal number at S, which must be no larger than MAX, into
+ * *N.  Returns the character after it, or a null pointer if S does not
+ * start with a number or it is too large. */
+static const char *parse_number(const char *s, unsigned max, unsigned *n) {
+	const char *p;
+
+	*n = 0;
+	for (p = s; *p >= '0' && *p <= '9'; p++) {
+		*n = *n * 10 + (*p - '0');
+		if (*n > max)
+			return NULL;
+	}
+	return p != s ? p : NULL;
+}
+
+/* Sets the virtual memory tunable given by OPTION, of the form NAME=VALUE,
+ * from the kernel command line.  Must be called before vm_init(). */
+void vm_set_option(const char *option) {
+	const char *value = strchr(option, '=');
+	const char *end;
+	unsigned n;
+
+	if (value == NULL)
+		PANIC("bad VM option `%s' (use -h for help)", option);
+	value++;
+
+	if (option_is(option, "zswap")) {
+		end = parse_number(value, 100, &n);
+		if (end == NULL || end[*end == '%'] != '\0')
+			PANIC("bad zswap percentage `%s'", value);
+		zswap_percent = n;
+	} else if (option_is(option, "writeback")) {
+		end = parse_number(value, 3600 * 1000, &n);
+		if (end == NULL || *end != '\0')
+			PANIC("bad writeback interval `%s'", value);
+		writeback_ms = n;
+	} else if (option_is(option, "wss")) {
+		end = parse_number(value, 3600 * 1000, &n);
+		if (end == NULL || *end != '\0')
+			PANIC("bad working-set sampling interval `%s'", value);
+		wss_ms = n;
+	} else if (option_is(option, "ksm")) {
+		end = parse_number(value, 1 << 20, &n);
+		if (end == NULL || *end != '\0')
+			PANIC("bad KSM scan rate `%s'", value);
+		ksm_pages = n;
+	} else if (option_is(option, "evict")) {
+		if (!strcmp(value, "clock"))
+			evict_2q = false;
+		else if (!strcmp(value, "2q"))
+			evict_2q = true;
+		else
+			PANIC("bad eviction policy `%s' (use clock or 2q)", value);
+	} else if (option_is(option, "stack")) {
+		end = parse_number(value, 256 * 1024, &n);
+		if (end == NULL || *end != '\0' || n < PGSIZE / 1024)
+			PANIC("bad stack size `%s' (use 4 to 262144 kB)", value);
+		stack_max = ROUND_UP((size_t)n * 1024, PGSIZE);
+	} else if (option_is(option, "thp")) {
+		end = parse_number(value, 1, &n);
+		if (end == NULL || *end != '\0')
+			PANIC("bad THP setting `%s' (use 0 or 1)", value);
+		thp_enabled = n;
+	} else if (option_is(option, "memstat")) {
+		end = parse_number(value, 1, &n);
+		if (end == NULL || *end != '\0')
+			PANIC("bad memstat setting `%s' (use 0 or 1)", value);
+		memstat_at_exit = n;
+	} else
+		PANIC("unknown VM option `%s' (use -h for help)", option);
+}
+
+/* Returns the lowest address above which the stack and its guard gap
+ * lie, which the heap and mappings must stay below. */
+void *vm_stack_limit(void) {
+	return (uint8_t *)USER_STACK - stack_max - STACK_GUARD;
+}
+
+/* Returns true if a fault at ADDR, which no page holds, with the user
+ * stack pointer at RSP is the stack growing: ADDR is within the most the
+ * stack may grow to, and no more than 8 bytes below RSP, where PUSH
+ * writes. */
+static bool is_stack_growth(void *addr, uintptr_t rsp) {
+	return (uintptr_t)addr >= rsp - 8 &&
+		   (uint8_t *)addr < (uint8_t *)USER_STACK &&
+		   (uint8_t *)addr >= (uint8_t *)USER_STACK - stack_max;
+}
+
+/* Brings in PAGE of the current process if there is a free frame for it.
+ * Returns false if there is none. */
+static bool claim_free(struct page *page) {
+	struct frame *frame;
+
+	lock_acquire(&frame_lock);
+	frame = get_free_frame();
+	lock_release(&frame_lock);
+	if (frame == NULL || !claim_pinned(page, frame, thread_current()->pml4))
+		return false;
+	page->frame->pinned = false;
+	return true;
+}
+
+/* Grows the stack of the current process down to the page of ADDR, and
+ * further ahead if it has been growing a page at a time.  Returns false
+ * if the page of ADDR cannot be brought in. */
+static bool vm_stack_growth(void *addr) {
+	struct supplemental_page_table *spt = &thread_current()->spt;
+	uint8_t *old_bottom = spt->stack_bottom;
+	uint8_t *fault_page = pg_round_down(addr);
+	uint8_t *limit = (uint8_t *)USER_STACK - stack_max;
+	uint8_t *bottom, *va;
+	size_t ahead, cnt = 0;
+
+	if (fault_page == old_bottom - PGSIZE) {
+		spt->stack_ahead = spt->stack_ahead == 0 ? 1 : spt->stack_ahead * 2;
+		if (spt->stack_ahead > STACK_AHEAD_MAX)
+			spt->stack_ahead = STACK_AHEAD_MAX;
+	} else
+		spt->stack_ahead = 0;
+	ahead = spt->stack_ahead;
+	if (ahead > (size_t)(fault_page - limit) / PGSIZE)
+		ahead = (fault_page - limit) / PGSIZE;
+	bottom = fault_page - ahead * PGSIZE;
+
+	if (!anon_grow(spt, VM_ANON | VM_MARKER_0, bottom,
+				   (old_bottom - bottom) / PGSIZE))
+		return false;
+	spt->stack_bottom = bottom;
+	stack_fault_cnt++;
+	if (!vm_do_claim_page(spt_find_page(spt, fault_page)))
+		return false;
+
+	/* The pages ahead, then those between the fault and the old bottom,
+	 * nearest the fault first. */
+	for (va = fault_page - PGSIZE; va >= bottom && cnt < STACK_AHEAD_MAX;
+		 va -= PGSIZE, cnt++)
+		if (!claim_free(spt_find_page(spt, va)))
+			break;
+	for (va = fault_page + PGSIZE; va < old_bottom && cnt < STACK_AHEAD_MAX;
+		 va += PGSIZE, cnt++)
+		if (!claim_free(spt_find_page(spt, va)))
+			break;
+	stack_ahead_cnt += cnt;
+	return true;
+}
+
+/* Makes PAGE, which is mapped read-only, writable.  The caller must
+ * already have checked that it may be written to.
+ *
+ * PAGE shares its frame with other pages since fork, or did until they went
+ * away, or is mapped to the zero page.  If it still shares, it gets a copy
+ * of the frame of its own; if it has the frame to itself by now, the frame
+ * is just mapped writable. */
+static bool vm_handle_wp(struct page *page) {
+	struct frame *frame = NULL;
+	struct frame *old;
+
+	for (;;) {
+		lock_acquire(&frame_lock);
+		old = frame_wait(page);
+
+		/* Evicted in the meantime: the access faults again, and swapping
+		 * in gives it a frame of its own. */
+		if (old == NULL)
+			break;
+
+		if (old->refcnt == 1 && old != &zero_frame) {
+			FAULT_PROF_TIME(FAULT_INSTALL,
+							pml4_set_page(page->pml4, page->va, old->kva, true));
+			cow_reuse_cnt++;
+			break;
+		}
+
+		if (frame != NULL) {
+			if (old->merged)
+				ksm_copy_cnt++;
+			FAULT_PROF_TIME(FAULT_IO, memcpy(frame->kva, old->kva, PGSIZE));
+			frame_remove_page(page);
+			frame_add_page(frame, page, page->pml4);
+			FAULT_PROF_TIME(FAULT_INSTALL, pml4_set_page(page->pml4, page->va,
+														 frame->kva, true));
+			frame->pinned = false;
+			frame = NULL;
+			cow_copy_cnt++;
+			break;
+		}
+
+		/* Getting a frame may have to evict, which takes the lock. */
+		lock_release(&frame_lock);
+		frame = vm_get_frame();
+		if (frame == NULL)
+			return false;
+	}
+
+	/* Not needed after all. */
+	if (frame != NULL)
+		frame_release(frame);
+	lock_release(&frame_lock);
+	return true;
+}
+
+/* Maps PAGE, an anonymous page that has never been touched and starts out
+ * zeroed, to the zero page, so that reading it costs no frame.  The first
+ * write gives it a frame of its own through vm_handle_wp(). */
+static bool vm_map_zero_page(struct page *page) {
+	uint64_t *pml4 = thread_current()->pml4;
+	bool success;
+
+	if (!page->uninit.page_initializer(page, page->uninit.type, NULL))
+		return false;
+
+	lock_acquire(&frame_lock);
+	frame_add_page(&zero_frame, page, pml4);
+	FAULT_PROF_TIME(FAULT_INSTALL, success = pml4_set_page(pml4, page->va,
+														   zero_frame.kva, false));
+	if (success)
+		zero_map_cnt++;
+	else
+		frame_remove_page(page);
+	lock_release(&frame_lock);
+	return success;
+}
+
+/* Returns true if PAGE has not been touched yet and will start out as a page
+ * of zeros. */
+static bool is_zero_fill(struct page *page) {
+	return page->operations->type == VM_UNINIT && page->uninit.init == NULL &&
+		   VM_TYPE(page->uninit.type) == VM_ANON;
+}
+
+/* Brings in the aligned 2 MB of memory around PAGE, which was just written
+ * for the first time, all at once and maps it with one large page, if
+ * every page of it is untouched writable zero-fill memory and an aligned
+ * 2 MB of the user pool is free.  Like fault-around, this never evicts.
+ * Returns true if PAGE was brought in, false if nothing was done. */
+static bool thp_fault(struct page *page) {
+	struct supplemental_page_table *spt = &thread_current()->spt;
+	uint64_t *pml4 = thread_current()->pml4;
+	uint8_t *base = (uint8_t *)((uintptr_t)page->va & ~(HUGE_PGSIZE - 1));
+	uint8_t *kva;
+	size_t i, cnt;
+
+	for (i = 0; i < HUGE_PGCNT; i++) {
+		struct page *p = spt_find_page(spt, base + i * PGSIZE);
+
+		if (p == NULL || !p->writable || !is_zero_fill(p))
+			return false;
+	}
+
+	lock_acquire(&frame_lock);
+	FAULT_PROF_TIME(FAULT_ALLOC, kva = palloc_get_aligned(PAL_USER, HUGE_PGCNT));
+	if (kva == NULL) {
+		thp_miss_cnt++;
+		lock_release(&frame_lock);
+		return false;
+	}
+	for (i = 0; i < HUGE_PGCNT; i++)
+		frame_of(kva + i * PGSIZE)->pinned = true;
+	used_cnt += HUGE_PGCNT;
+	if (used_cnt > used_peak)
+		used_peak = used_cnt;
+	lock_release(&frame_lock);
+
+	for (cnt = 0; cnt < HUGE_PGCNT; cnt++)
+		if (!claim_pinned(spt_find_page(spt, base + cnt * PGSIZE),
+						  frame_of(kva + cnt * PGSIZE), pml4))
+			break;
+	if (cnt == HUGE_PGCNT && pml4_collapse(pml4, base))
+		thp_map_cnt++;
+
+	/* claim_pinned() gave back the frame it failed on. */
+	lock_acquire(&frame_lock);
+	for (i = 0; i < HUGE_PGCNT; i++) {
+		struct frame *frame = frame_of(kva + i * PGSIZE);
+
+		if (i < cnt)
+			frame->pinned = false;
+		else if (i > cnt)
+			frame_release(frame);
+	}
+	lock_release(&frame_lock);
+	return page->frame != NULL;
+}
+
+/* Pages to fault around when a stream starts or turns sequential, and the
+ * most that the window grows to. */
+#define FAULT_AROUND_MIN 4
+#define FAULT_AROUND_MAX 32
+
+/* Returns the readahead state of the stream of pages that PAGE, which has
+ * not been brought in yet, belongs to, or a null pointer if PAGE is not read
+ * from a file: the region for an mmap'd page, the executable for a page of
+ * a segment that is still to be loaded. */
+static struct readahead *page_readahead(struct page *page) {
+	switch (page->operations->type) {
+	case VM_UNINIT:
+		if (VM_TYPE(page->uninit.type) == VM_FILE)
+			return &((struct mmap_region *)page->uninit.aux)->ra;
+		if (page->uninit.init != NULL)
+			return &thread_current()->spt.exec_ra;
+		return NULL;
+	case VM_FILE:
+		return &page->file.region->ra;
+	default:
+		return NULL;
+	}
+}
+
+/* After PAGE, which is read from a file, was brought in on a fault, brings
+ * in the pages that follow it in the same stream RA, as long as they are
+ * not in memory.  The window grows while faults follow on from the last
+ * window and collapses on a fault elsewhere, so random access reads one
+ * page at a time.  Like swap readahead, this never evicts. */
+static void vm_fault_around(struct page *page, struct readahead *ra) {
+	struct supplemental_page_table *spt = &thread_current()->spt;
+	size_t cnt = 0;
+
+	file_fault_cnt++;
+	if (page->va == ra->next) {
+		/* The stream went through the whole last window. */
+		avoided_cnt += ra->last_cnt;
+		ra->window = ra->window * 2;
+		if (ra->window < FAULT_AROUND_MIN)
+			ra->window = FAULT_AROUND_MIN;
+		if (ra->window > FAULT_AROUND_MAX)
+			ra->window = FAULT_AROUND_MAX;
+	} else
+		ra->window = ra->next == NULL ? FAULT_AROUND_MIN : 0;
+
+	/* A stream that is advised to be read in order reads the most from the
+	 * start, and keeps doing so wherever it faults. */
+	if (ra->sequential)
+		ra->window = FAULT_AROUND_MAX;
+
+	while (cnt < ra->window) {
+		struct page *next =
+			spt_find_page(spt, (uint8_t *)page->va + (cnt + 1) * PGSIZE);
+		struct frame *frame;
+
+		if (next == NULL || next->frame != NULL || page_readahead(next) != ra)
+			break;
+
+		lock_acquire(&frame_lock);
+		FAULT_PROF_TIME(FAULT_ALLOC, frame = get_free_frame());
+		lock_release(&frame_lock);
+		if (frame == NULL ||
+			!claim_pinned(next, frame, thread_current()->pml4))
+			break;
+		next->frame->pinned = false;
+		cnt++;
+	}
+	around_cnt += cnt;
+	ra->last_cnt = cnt;
+	ra->next = (uint8_t *)page->va + (cnt + 1) * PGSIZE;
+}
+
+/* After PAGE was read from SLOT, reads in the pages that follow PAGE in
+ * the address space as long as they follow it in swap too, that is, as
+ * long as they were evicted along with it.  Stops at the first page that
+ * does not, or when there is no free frame: readahead never evicts. */
+static void vm_swap_readahead(struct page *page, size_t slot) {
+	struct supplemental_page_table *spt = &thread_current()->spt;
+	size_t i;
+
+	for (i = 1; i < SWAP_BATCH; i++) {
+		struct page *next =
+			spt_find_page(spt, (uint8_t *)page->va + i * PGSIZE);
+		struct frame *frame;
+
+		if (next == NULL || anon_swap_slot(next) != slot + i)
+			break;
+
+		lock_acquire(&frame_lock);
+		FAULT_PROF_TIME(FAULT_ALLOC, frame = get_free_frame());
+		lock_release(&frame_lock);
+		if (frame == NULL ||
+			!claim_pinned(next, frame, thread_current()->pml4))
+			break;
+		next->frame->pinned = false;
+		readahead_cnt++;
+	}
+}
+
+/* Reads PAGE in ahead of use for MADV_WILLNEED, unless it is in memory
+ * already or is zero-fill.  Like readahead, this never evicts: returns false
+ * to stop the walk when there is no free frame left. */
+static bool willneed_page(struct page *page, void *aux UNUSED) {
+	struct frame *frame;
+
+	if (page->frame != NULL || is_zero_fill(page))
+		return true;
+
+	lock_acquire(&frame_lock);
+	frame = get_free_frame();
+	lock_release(&frame_lock);
+	if (frame == NULL || !claim_pinned(page, frame, thread_current()->pml4))
+		return false;
+	page->frame->pinned = false;
+	willneed_cnt++;
+	return true;
+}
+
+/* Turns anonymous PAGE, whose contents are gone, back into a page that is
+ * brought in by INIT with AUX on its next access, as vm_new_page() makes
+ * it.  It stays in its table, with the same permissions. */
+static void page_restart(struct page *page, vm_initializer *init,
+						 void *aux) {
+	struct supplemental_page_table *spt = page->spt;
+	bool writable = page->writable;
+
+	uninit_new(page, page->va, init, VM_ANON, aux, anon_initializer);
+	page->writable = writable;
+	page->pml4 = NULL;
+	page->spt = spt;
+}
+
+/* Drops the contents of PAGE for MADV_DONTNEED.  An anonymous page loses
+ * them and starts over as it began: a page of the executable's data
+ * segment is read from the executable again on the next access, and any
+ * other reads back as zeros.  A file backed page is written back and read
+ * in again on the next access, unless it cannot be written back.
+ * Read-only anonymous pages hold the code of the executable, which needs
+ * no dropping, so they are kept. */
+static bool dontneed_page(struct page *page, void *aux_ UNUSED) {
+	bool writable = page->writable;
+	vm_initializer *init;
+	void *aux;
+
+	switch (page->operations->type) {
+	case VM_ANON:
+		if (!writable)
+			break;
+		init = page->anon.init;
+		aux = page->anon.aux;
+		destroy(page);
+		page_restart(page, init, aux);
+		dontneed_cnt++;
+		break;
+	case VM_FILE:
+		if (file_page_drop(page))
+			dontneed_cnt++;
+		break;
+	default:
+		break;
+	}
+	return true;
+}
+
+/* Applies ADVICE, one of the MADV_* values of <mman.h>, to the pages of
+ * the current process in [ADDR, ADDR + LENGTH).  Returns 0 if successful,
+ * or -1 if ADDR is not page-aligned, the range is not user memory, or
+ * ADVICE is unknown.  Unmapped parts of the range are ignored. */
+int vm_madvise(void *addr, size_t length, int advice) {
+	struct supplemental_page_table *spt = &thread_current()->spt;
+	uint8_t *end;
+
+	if (pg_ofs(addr) != 0 || !is_user_vaddr(addr) ||
+		length > (uint64_t)KERN_BASE - (uint64_t)addr)
+		return -1;
+	end = (uint8_t *)addr + ROUND_UP(length, PGSIZE);
+
+	switch (advice) {
+	case MADV_NORMAL:
+	case MADV_SEQUENTIAL:
+		file_set_sequential(spt, addr, end, advice == MADV_SEQUENTIAL);
+		return 0;
+	case MADV_WILLNEED:
+		spt_for_each(spt, addr, end, willneed_page, NULL);
+		return 0;
+	case MADV_DONTNEED:
+		spt_for_each(spt, addr, end, dontneed_page, NULL);
+		return 0;
+	default:
+		return -1;
+	}
+}
+
+/* Counts PAGE, if it is resident, in the resident set of ST_, a struct
+ * memstat. */
+static bool count_resident(struct page *page, void *st_) {
+	struct memstat *st = st_;
+	struct frame *frame = page->frame;
+
+	if (frame == NULL)
+		return true;
+	if (frame->refcnt > 1 || frame == &zero_frame)
+		st->rss_shared++;
+	else if (page_get_type(page) == VM_FILE)
+		st->rss_file++;
+	else
+		st->rss_anon++;
+	return true;
+}
+
+/* Fills in ST, which must be in kernel memory, with the memory statistics
+ * of the current process. */
+void vm_memstat(struct memstat *st) {
+	struct supplemental_page_table *spt = &thread_current()->spt;
+	const struct spt_stats *stats = &spt->stats;
+
+	memset(st, 0, sizeof *st);
+	lock_acquire(&frame_lock);
+	spt_for_each(spt, NULL, (void *)KERN_BASE, count_resident, st);
+	if (wss_ms > 0) {
+		st->wss = stats->ws_pass == ws_pass ? (long long)stats->ws_cnt : 0;
+		st->wss_peak = stats->ws_peak;
+	} else
+		st->wss = st->wss_peak = -1;
+	st->swap_outs = stats->swap_out_cnt;
+	st->swap_pages = stats->swap_cnt;
+	st->pressure_events = pressure_cnt;
+	st->oom_kills = oom_kill_cnt;
+	lock_release(&frame_lock);
+
+	st->major_faults = stats->major_cnt;
+	st->minor_faults = stats->minor_cnt;
+	st->cow_faults = stats->cow_cnt;
+	st->swap_ins = stats->swap_in_cnt;
+}
+
+/* Prints the memory statistics of the current process, which is exiting,
+ * if the memstat option asks for them. */
+void vm_print_memstat(void) {
+	struct memstat st;
+	char wss[64] = "";
+
+	if (!memstat_at_exit)
+		return;
+	vm_memstat(&st);
+	if (st.wss >= 0)
+		snprintf(wss, sizeof wss, ", working set %lld pages (%lld at peak)",
+				 st.wss, st.wss_peak);
+	printf("%s: %lld pages resident (%lld anon, %lld file, %lld shared)%s, "
+		   "%lld faults (%lld major, %lld minor, %lld COW), "
+		   "%lld pages swapped in, %lld swapped out\n",
+		   thread_current()->name,
+		   st.rss_anon + st.rss_file + st.rss_shared, st.rss_anon,
+		   st.rss_file, st.rss_shared, wss,
+		   st.major_faults + st.minor_faults, st.major_faults,
+		   st.minor_faults, st.cow_faults, st.swap_ins, st.swap_outs);
+}
+
+/* Adds zero-fill anonymous pages of TYPE to SPT for the PAGE_CNT pages
+ * starting at UPAGE, in one bulk insert.  Returns false if memory cannot be
+ * allocated or one of the pages is in use already. */
+static bool anon_grow(struct supplemental_page_table *spt, enum vm_type type,
+					  uint8_t *upage, size_t page_cnt) {
+	struct page **pages;
+	bool success = false;
+	size_t i;
+
+	if (page_cnt == 0)
+		return true;
+	pages = calloc(page_cnt, sizeof *pages);
+	if (pages == NULL)
+		return false;
+	for (i = 0; i < page_cnt; i++) {
+		pages[i] = vm_new_page(type, upage + i * PGSIZE, true, NULL, NULL);
+		if (pages[i] == NULL)
+			goto done;
+	}
+	success = spt_insert_pages(spt, pages, page_cnt);
+
+done:
+	if (!success)
+		for (i = 0; i < page_cnt && pages[i] != NULL; i++)
+			vm_dealloc_page(pages[i]);
+	free(pages);
+	return success;
+}
+
+/* Moves the break of the current process, the end of its heap, to ADDR,
+ * and returns the new break.  The heap starts out empty right after the
+ * executable's segments and is made of anonymous pages, which are brought
+ * in as they are touched like any others; shrinking it frees the pages
+ * past the new break.  If ADDR is null, below the start of the heap, in
+ * the stack's guard gap, or would take a page that is mapped already, the
+ * break stays where it is and is returned. */
+void *vm_brk(void *addr) {
+	struct supplemental_page_table *spt = &thread_current()->spt;
+	uint8_t *old_end = pg_round_up(spt->brk);
+	uint8_t *new_end = pg_round_up(addr);
+	uint8_t *va;
+
+	if (addr == NULL || spt->heap_start == NULL || addr < spt->heap_start ||
+		addr > vm_stack_limit())
+		return spt->brk;
+
+	if (new_end > old_end &&
+		!anon_grow(spt, VM_ANON, old_end, (new_end - old_end) / PGSIZE))
+		return spt->brk;
+	for (va = new_end; va < old_end; va += PGSIZE) {
+		struct page *page = spt_find_page(spt, va);
+
+		if (page != NULL)
+			spt_remove_page(spt, page);
+	}
+	spt->brk = addr;
+	return addr;
+}
 
 /* Return true on success */
-bool vm_try_handle_fault(struct intr_frame *f UNUSED, void *addr UNUSED,
-						 bool user UNUSED, bool write UNUSED,
-						 bool not_present UNUSED) {
-	struct supplemental_page_table *spt UNUSED = &thread_current()->spt;
-	struct page *page = NULL;
-	/* TODO: Validate the fault */
-	/* TODO: Your code goes here */
+bool vm_try_handle_fault(struct intr_frame *f, void *addr, bool user,
+						 bool write, bool not_present) {
+	struct supplemental_page_table *spt = &thread_current()->spt;
+	struct readahead *ra;
+	struct page *page;
+	size_t slot;
+	bool major;
 
-	return vm_do_claim_page(page);
+	/* Only a page of the user address space can be fixed up, and writing
+	 * to a read-only page is a real fault. */
+	if (addr == NULL || !is_user_vaddr(addr))
+		return false;
+
+	/* A process killed for lack of memory dies here. */
+	if (spt->oom_killed)
+		return false;
+
+	FAULT_PROF_TIME(FAULT_LOOKUP,
+					page = spt_find_page(spt, pg_round_down(addr)));
+
+	/* The stack pointer of a fault in the kernel is the kernel's: use the
+	 * one the process made its system call with. */
+	if (page == NULL) {
+		if (!not_present ||
+			!is_stack_growth(addr, user ? f->rsp : thread_current()->user_rsp))
+			return false;
+		fault_cnt++;
+		spt->stats.minor_cnt++;
+		FAULT_PROF_TYPE(FAULT_STACK);
+		return vm_stack_growth(addr);
+	}
+	if (write && !page->writable)
+		return false;
+
+	/* A writable page that is present but mapped read-only is shared
+	 * copy-on-write. */
+	if (!not_present) {
+		if (!write)
+			return false;
+		fault_cnt++;
+		spt->stats.minor_cnt++;
+		spt->stats.cow_cnt++;
+		FAULT_PROF_TYPE(FAULT_COW);
+		return vm_handle_wp(page);
+	}
+
+	fault_cnt++;
+	if (!write && is_zero_fill(page)) {
+		spt->stats.minor_cnt++;
+		return vm_map_zero_page(page);
+	}
+	if (thp_enabled && is_zero_fill(page) && thp_fault(page)) {
+		spt->stats.minor_cnt++;
+		return true;
+	}
+	slot = anon_swap_slot(page);
+	ra = page_readahead(page);
+	major = ra != NULL || (page->operations->type == VM_ANON &&
+						   anon_is_swapped_out(page));
+	if (ra != NULL)
+		FAULT_PROF_TYPE(FAULT_FILE);
+	else if (major)
+		FAULT_PROF_TYPE(FAULT_SWAP);
+	if (!vm_do_claim_page(page))
+		return false;
+	if (major)
+		spt->stats.major_cnt++;
+	else
+		spt->stats.minor_cnt++;
+	if (slot != SWAP_SLOT_NONE)
+		vm_swap_readahead(page, slot);
+	else if (ra != NULL)
+		vm_fault_around(page, ra);
+	return true;
 }
 
 /* Free the page.
@@ -137,35 +1796,330 @@ void vm_dealloc_page(struct page *page) {
 }
 
 /* Claim the page that allocate on VA. */
-bool vm_claim_page(void *va UNUSED) {
-	struct page *page = NULL;
-	/* TODO: Fill this function */
+bool vm_claim_page(void *va) {
+	struct page *page = spt_find_page(&thread_current()->spt, va);
 
+	if (page == NULL)
+		return false;
 	return vm_do_claim_page(page);
 }
 
-/* Claim the PAGE and set up the mmu. */
-static bool vm_do_claim_page(struct page *page) {
-	struct frame *frame = vm_get_frame();
+/* Maps PAGE, which is in a frame already, into PML4 again, writable only
+ * if it has the frame to itself.  Must be called with frame_lock held. */
+static bool claim_resident(struct page *page, uint64_t *pml4) {
+	struct frame *frame = page->frame;
+	bool success;
+
+	ASSERT(lock_held_by_current_thread(&frame_lock));
+
+	FAULT_PROF_TIME(FAULT_INSTALL,
+					success = pml4_set_page(pml4, page->va, frame->kva,
+											page->writable &&
+												frame->refcnt == 1));
+	return success;
+}
+
+/* Brings PAGE into FRAME, a pinned frame obtained for it, and maps it into
+ * PML4.  The frame is left pinned.  If PAGE got a frame in the meantime,
+ * because an eviction that had unmapped it failed and kept it, FRAME is
+ * given back and that frame is mapped and pinned instead. */
+static bool claim_pinned(struct page *page, struct frame *frame,
+						 uint64_t *pml4) {
+	bool swapped, success;
+
+	if (frame == NULL)
+		return false;
 
 	/* Set links */
-	frame->page = page;
-	page->frame = frame;
+	lock_acquire(&frame_lock);
+	if (frame_wait(page) != NULL) {
+		frame_release(frame);
+		success = claim_resident(page, pml4);
+		if (success)
+			page->frame->pinned = true;
+		lock_release(&frame_lock);
+		return success;
+	}
+	swapped = page->operations->type == VM_ANON && anon_is_swapped_out(page);
+	frame_add_page(frame, page, pml4);
+	lock_release(&frame_lock);
 
-	/* TODO: Insert page table entry to map page's VA to frame's PA. */
+	/* Fill the frame before the page becomes visible to the process. */
+	FAULT_PROF_TIME(FAULT_IO, success = swap_in(page, frame->kva));
+	if (success)
+		FAULT_PROF_TIME(FAULT_INSTALL,
+						success = pml4_set_page(pml4, page->va, frame->kva,
+												page->writable));
+	if (!success) {
+		vm_free_frame(page);
+		return false;
+	}
+	if (swapped) {
+		lock_acquire(&frame_lock);
+		page->spt->stats.swap_in_cnt++;
+		page->spt->stats.swap_cnt--;
+		lock_release(&frame_lock);
+	}
+	return true;
+}
 
-	return swap_in(page, frame->kva);
+/* Claim the PAGE and set up the mmu.  A PAGE that is still in a frame,
+ * which an eviction unmapped and then kept, is only mapped again. */
+static bool vm_do_claim_page(struct page *page) {
+	uint64_t *pml4 = thread_current()->pml4;
+	bool success;
+
+	lock_acquire(&frame_lock);
+	if (frame_wait(page) != NULL) {
+		success = claim_resident(page, pml4);
+		lock_release(&frame_lock);
+		return success;
+	}
+	lock_release(&frame_lock);
+
+	if (!claim_pinned(page, vm_get_frame(), pml4))
+		return false;
+	page->frame->pinned = false;
+	return true;
+}
+
+/* Makes sure that PAGE, which is mapped in PML4, is in a frame and stays
+ * there until vm_unpin_page(). */
+static bool vm_pin_page(struct page *page, uint64_t *pml4) {
+	lock_acquire(&frame_lock);
+	if (frame_wait(page) != NULL) {
+		page->frame->pinned = true;
+		lock_release(&frame_lock);
+		return true;
+	}
+	lock_release(&frame_lock);
+	return claim_pinned(page, vm_get_frame(), pml4);
+}
+
+/* Keeps the frame that PAGE is in, if any, from being evicted until
+ * vm_unpin_page() or vm_free_frame(), and returns it.  Returns a null
+ * pointer if PAGE is not in memory. */
+struct frame *vm_pin_resident(struct page *page) {
+	struct frame *frame;
+
+	lock_acquire(&frame_lock);
+	frame = frame_wait(page);
+	if (frame != NULL)
+		frame->pinned = true;
+	lock_release(&frame_lock);
+	return frame;
+}
+
+/* If PAGE is in memory and was written to since it was last marked clean,
+ * marks it clean and keeps its frame from being evicted until
+ * vm_unpin_page(), for writing it back, and returns the frame.  Returns a
+ * null pointer if there is nothing to write: PAGE is not in memory or is
+ * clean, or its frame is pinned, by eviction for example, which writes it
+ * back itself. */
+struct frame *vm_pin_dirty(struct page *page) {
+	struct frame *frame;
+
+	lock_acquire(&frame_lock);
+	frame = page->frame;
+	if (frame == NULL || frame->pinned || !pml4_is_dirty(page->pml4, page->va))
+		frame = NULL;
+	else {
+		frame->pinned = true;
+		pml4_set_dirty(page->pml4, page->va, false);
+	}
+	lock_release(&frame_lock);
+	return frame;
+}
+
+/* Lets PAGE be evicted again. */
+void vm_unpin_page(struct page *page) {
+	page->frame->pinned = false;
+}
+
+/* Maps PAGE, a read-only page of the current thread that has not been
+ * brought in yet and holds the contents KEY, to the frame of the text cache
+ * that holds them already, if there is one.  Returns true if it did, and
+ * false if PAGE is to be read in as usual. */
+bool vm_text_map(struct page *page, const struct text_key *key) {
+	uint64_t *pml4 = thread_current()->pml4;
+	struct frame probe;
+	struct hash_elem *e;
+	bool success = false;
+
+	ASSERT(!page->writable);
+	ASSERT(page->operations->type == VM_UNINIT);
+
+	probe.text = *key;
+	lock_acquire(&frame_lock);
+	e = hash_find(&text_cache, &probe.text_elem);
+	if (e != NULL) {
+		struct frame *frame = hash_entry(e, struct frame, text_elem);
+
+		/* One that is being evicted is about to leave the cache. */
+		success = !frame->evicting &&
+				  pml4_set_page(pml4, page->va, frame->kva, false);
+		if (success) {
+			page->uninit.page_initializer(page, page->uninit.type, frame->kva);
+			frame_add_page(frame, page, pml4);
+			text_map_cnt++;
+		}
+	}
+	lock_release(&frame_lock);
+	return success;
+}
+
+/* Enters the frame of PAGE, a read-only page that was just read in with
+ * the contents KEY, into the text cache, unless some frame there holds them
+ * already. */
+void vm_text_insert(struct page *page, const struct text_key *key) {
+	struct frame *frame = page->frame;
+
+	ASSERT(!page->writable);
+	ASSERT(frame != NULL && frame->pinned);
+
+	lock_acquire(&frame_lock);
+	if (frame->text.inode == NULL) {
+		frame->text = *key;
+		if (hash_insert(&text_cache, &frame->text_elem) != NULL)
+			frame->text.inode = NULL;
+	}
+	lock_release(&frame_lock);
 }
 
 /* Initialize new supplemental page table */
-void supplemental_page_table_init(struct supplemental_page_table *spt UNUSED) {}
+void supplemental_page_table_init(struct supplemental_page_table *spt) {
+	spt->owner = thread_current();
+	spt->root = NULL;
+	spt->page_cnt = 0;
+	spt->node_cnt = 0;
+	list_init(&spt->mmaps);
+	spt->exec_ra = (struct readahead){0};
+	spt->heap_start = spt->brk = NULL;
+	spt->stack_bottom = (void *)USER_STACK;
+	spt->stack_ahead = 0;
+	spt->stats = (struct spt_stats){0};
+	spt->oom_killed = false;
+}
+
+/* Where copy_page() copies to, and the page table of the source. */
+struct copy_aux {
+	struct supplemental_page_table *dst;
+	uint64_t *src_pml4;
+};
+
+/* Makes anonymous PAGE, which belongs to the current thread, share the
+ * contents of SRC_PAGE, which is mapped in SRC_PML4, copy-on-write.  A
+ * resident SRC_PAGE shares its frame, mapped read-only on both sides; one
+ * that is swapped out to disk shares its swap slot. */
+static bool share_page(struct page *page, struct page *src_page,
+					   uint64_t *src_pml4) {
+	uint64_t *pml4 = thread_current()->pml4;
+	struct frame *frame;
+	bool success;
+
+	lock_acquire(&frame_lock);
+	if (frame_wait(src_page) == NULL && !zswap_contains(src_page) &&
+		src_page->anon.slot != SWAP_SLOT_NONE) {
+		page->anon.slot = swap_dup(src_page->anon.slot);
+		page->spt->stats.swap_cnt++;
+		lock_release(&frame_lock);
+		share_cnt++;
+		return true;
+	}
+	lock_release(&frame_lock);
+
+	/* Anything else is brought in first. */
+	if (!vm_pin_page(src_page, src_pml4))
+		return false;
+
+	lock_acquire(&frame_lock);
+	frame = src_page->frame;
+	frame_add_page(frame, page, pml4);
+	success = pml4_set_page(pml4, page->va, frame->kva, false);
+	if (success) {
+		/* Any other pages of the frame are read-only already. */
+		pml4_set_page(src_page->pml4, src_page->va, frame->kva, false);
+		share_cnt++;
+	} else
+		frame_remove_page(page);
+	frame->pinned = false;
+	lock_release(&frame_lock);
+	return success;
+}
+
+/* Copies SRC_PAGE into the supplemental page table AUX->dst, which belongs
+ * to the current thread.  Pages that were never touched stay lazy, and
+ * anonymous pages are shared copy-on-write.  The others get a frame of
+ * their own with the same contents.  Mappings made with mmap() are not
+ * inherited. */
+static bool copy_page(struct page *src_page, void *aux_) {
+	struct copy_aux *aux = aux_;
+	struct supplemental_page_table *dst = aux->dst;
+	struct page *page;
+	bool success;
+
+	if (page_get_type(src_page) == VM_FILE)
+		return true;
+
+	if (src_page->operations->type == VM_UNINIT) {
+		struct uninit_page *uninit = &src_page->uninit;
+
+		page = vm_new_page(uninit->type, src_page->va, src_page->writable,
+						   uninit->init, uninit->aux);
+		if (page == NULL)
+			return false;
+		if (!spt_insert_page(dst, page)) {
+			free(page);
+			return false;
+		}
+		return true;
+	}
+
+	page = vm_new_page(page_get_type(src_page), src_page->va,
+					   src_page->writable, NULL, NULL);
+	if (page == NULL)
+		return false;
+	if (!spt_insert_page(dst, page)) {
+		free(page);
+		return false;
+	}
+
+	if (page_get_type(src_page) == VM_ANON) {
+		anon_initializer(page, VM_ANON, NULL);
+		page->anon.init = src_page->anon.init;
+		page->anon.aux = src_page->anon.aux;
+		return share_page(page, src_page, aux->src_pml4);
+	}
+
+	/* The source may have been evicted, and must not be while it is
+	 * copied. */
+	if (!vm_pin_page(src_page, aux->src_pml4))
+		return false;
+	success = vm_do_claim_page(page);
+	if (success)
+		memcpy(page->frame->kva, src_page->frame->kva, PGSIZE);
+	vm_unpin_page(src_page);
+	return success;
+}
 
 /* Copy supplemental page table from src to dst */
-bool supplemental_page_table_copy(struct supplemental_page_table *dst UNUSED,
-								  struct supplemental_page_table *src UNUSED) {}
+bool supplemental_page_table_copy(struct supplemental_page_table *dst,
+								  struct supplemental_page_table *src) {
+	struct copy_aux aux = {dst, src->owner->pml4};
+
+	dst->heap_start = src->heap_start;
+	dst->brk = src->brk;
+	dst->stack_bottom = src->stack_bottom;
+	dst->stack_ahead = src->stack_ahead;
+	return spt_for_each(src, NULL, (void *)KERN_BASE, copy_page, &aux);
+}
 
 /* Free the resource hold by the supplemental page table */
-void supplemental_page_table_kill(struct supplemental_page_table *spt UNUSED) {
-	/* TODO: Destroy all the supplemental_page_table hold by thread and
-	 * TODO: writeback all the modified contents to the storage. */
+void supplemental_page_table_kill(struct supplemental_page_table *spt) {
+	file_munmap_all(spt);
+	spt_destroy(spt, vm_dealloc_page);
+	spt->exec_ra = (struct readahead){0};
+	spt->heap_start = spt->brk = NULL;
+	spt->stack_bottom = (void *)USER_STACK;
+	spt->stack_ahead = 0;
 }
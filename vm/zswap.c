@@ -0,0 +1,229 @@
+/* zswap.c: Compressed cache in front of the swap disk.
+ *
+ * Anonymous pages that are swapped out are compressed into kernel memory
+ * instead of going to disk, as long as the compressed pool stays under
+ * zswap_percent of the user pool.  A page that is all zeros is kept as a
+ * flag, with no data at all.  When the pool is full, the pages that were
+ * stored first, which are the ones that have gone unused longest, are
+ * decompressed and written to their own swap slot.  A page that does not
+ * compress to at most STORE_MAX bytes goes straight to disk.
+ *
+ * An entry belongs to exactly one page, and goes away when the page is
+ * swapped back in. */
+
+#include "vm/zswap.h"
+#include <debug.h>
+#include <list.h>
+#include <lz.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+#include "vm/swap.h"
+#include "vm/vm.h"
+
+/* Largest compressed size worth keeping in memory. */
+#define STORE_MAX (PGSIZE * 3 / 4)
+
+/* A compressed page. */
+struct zswap_entry {
+	struct list_elem elem; /* Element in lru, unless a zero page. */
+	struct page *page;	   /* Page stored here. */
+	size_t size;		   /* Bytes of data, 0 for a zero page. */
+	uint8_t data[];		   /* Compressed contents. */
+};
+
+unsigned zswap_percent;
+
+static size_t pool_max;		 /* Most bytes the pool may use. */
+static size_t pool_bytes;	 /* Bytes the pool uses now. */
+static struct list lru;		 /* Entries with data, oldest first. */
+static struct lock zswap_lock; /* Protects all of the above and the
+								  anon_page of every stored page. */
+
+/* Scratch space, used under zswap_lock. */
+static uint16_t lz_work[LZ_WORK_CNT];
+static uint8_t *scratch; /* One page. */
+
+/* Statistics. */
+static long long store_cnt;	 /* # of pages stored. */
+static long long zero_cnt;	 /* # of those that were all zeros. */
+static long long reject_cnt; /* # of pages that did not compress. */
+static long long spill_cnt;	 /* # of pages written to disk to make room. */
+static long long load_cnt;	 /* # of pages loaded back. */
+static long long miss_cnt;	 /* # of swap-ins that had to go to disk. */
+static long long in_bytes;	 /* Uncompressed bytes of pages with data. */
+static long long out_bytes;	 /* Compressed bytes of pages with data. */
+
+/* Sets up the compressed cache, sized by zswap_percent. */
+void zswap_init(void) {
+	size_t user_pages;
+
+	list_init(&lru);
+	lock_init(&zswap_lock);
+	if (zswap_percent == 0)
+		return;
+
+	palloc_user_pool(&user_pages);
+	pool_max = (uint64_t)user_pages * PGSIZE * zswap_percent / 100;
+	scratch = palloc_get_page(0);
+	if (scratch == NULL)
+		PANIC("zswap_init: out of memory");
+}
+
+/* Returns true if the page at KVA is all zeros. */
+static bool is_zero_page(const void *kva) {
+	const uint64_t *p = kva;
+	size_t i;
+
+	for (i = 0; i < PGSIZE / sizeof *p; i++)
+		if (p[i] != 0)
+			return false;
+	return true;
+}
+
+/* Writes the oldest entry to a swap slot of its own and frees it.
+ * Returns false if swap is full. */
+static bool spill_oldest(void) {
+	struct zswap_entry *e =
+		list_entry(list_front(&lru), struct zswap_entry, elem);
+	size_t slot = swap_alloc(1);
+	void *kvas[1] = {scratch};
+
+	ASSERT(lock_held_by_current_thread(&zswap_lock));
+
+	if (slot == SWAP_SLOT_NONE)
+		return false;
+	if (lz_decompress(e->data, e->size, scratch, PGSIZE) != PGSIZE)
+		PANIC("zswap: corrupt entry");
+	swap_write(slot, kvas, 1);
+
+	list_remove(&e->elem);
+	pool_bytes -= sizeof *e + e->size;
+	e->page->anon.slot = slot;
+	e->page->anon.zentry = NULL;
+	free(e);
+	spill_cnt++;
+	return true;
+}
+
+/* Compresses anonymous PAGE, whose contents are at KVA, into the cache,
+ * making room by spilling older pages to disk if needed.  Returns false if
+ * the cache is disabled, the page does not compress well, or there is no
+ * room, in which case the caller should write it to disk itself. */
+bool zswap_store(struct page *page, const void *kva) {
+	struct zswap_entry *e;
+	size_t size;
+	bool success = false;
+
+	if (zswap_percent == 0)
+		return false;
+
+	lock_acquire(&zswap_lock);
+	if (is_zero_page(kva))
+		size = 0;
+	else {
+		size = lz_compress(kva, PGSIZE, scratch, STORE_MAX, lz_work);
+		if (size == 0) {
+			reject_cnt++;
+			goto done;
+		}
+	}
+
+	while (size > 0 && pool_bytes + sizeof *e + size > pool_max)
+		if (list_empty(&lru) || !spill_oldest())
+			goto done;
+
+	e = malloc(sizeof *e + size);
+	if (e == NULL)
+		goto done;
+	e->page = page;
+	e->size = size;
+	memcpy(e->data, scratch, size);
+	page->anon.zentry = e;
+
+	store_cnt++;
+	if (size == 0)
+		zero_cnt++;
+	else {
+		list_push_back(&lru, &e->elem);
+		pool_bytes += sizeof *e + size;
+		in_bytes += PGSIZE;
+		out_bytes += size;
+	}
+	success = true;
+
+done:
+	lock_release(&zswap_lock);
+	return success;
+}
+
+/* Frees entry E of the cache. */
+static void entry_free(struct zswap_entry *e) {
+	if (e->size > 0) {
+		list_remove(&e->elem);
+		pool_bytes -= sizeof *e + e->size;
+	}
+	e->page->anon.zentry = NULL;
+	free(e);
+}
+
+/* If anonymous PAGE is in the cache, decompresses it to KVA, drops it from
+ * the cache and returns true.  Otherwise returns false, and PAGE has to
+ * come from its swap slot, if any. */
+bool zswap_load(struct page *page, void *kva) {
+	struct zswap_entry *e;
+
+	lock_acquire(&zswap_lock);
+	e = page->anon.zentry;
+	if (e == NULL) {
+		if (zswap_percent != 0)
+			miss_cnt++;
+		lock_release(&zswap_lock);
+		return false;
+	}
+
+	if (e->size == 0)
+		memset(kva, 0, PGSIZE);
+	else if (lz_decompress(e->data, e->size, kva, PGSIZE) != PGSIZE)
+		PANIC("zswap: corrupt entry");
+	entry_free(e);
+	load_cnt++;
+	lock_release(&zswap_lock);
+	return true;
+}
+
+/* Returns true if anonymous PAGE is in the cache.  If it is not, any
+ * spill of it to disk has completed. */
+bool zswap_contains(struct page *page) {
+	bool contains;
+
+	lock_acquire(&zswap_lock);
+	contains = page->anon.zentry != NULL;
+	lock_release(&zswap_lock);
+	return contains;
+}
+
+/* Drops anonymous PAGE from the cache, if it is there, without reading
+ * it. */
+void zswap_invalidate(struct page *page) {
+	lock_acquire(&zswap_lock);
+	if (page->anon.zentry != NULL)
+		entry_free(page->anon.zentry);
+	lock_release(&zswap_lock);
+}
+
+/* Prints compressed cache statistics. */
+void zswap_print_stats(void) {
+	if (zswap_percent == 0)
+		return;
+	printf("Zswap: %lld stored (%lld zero), %lld rejected, %lld spilled, "
+		   "%lld%% compressed size, %lld of %lld swap-ins hit, "
+		   "pool %zu of %zu bytes\n",
+		   store_cnt, zero_cnt, reject_cnt, spill_cnt,
+		   in_bytes > 0 ? out_bytes * 100 / in_bytes : 0, load_cnt,
+		   load_cnt + miss_cnt, pool_bytes, pool_max);
+}